@@ -0,0 +1,630 @@
+#pragma once
+
+#include <Arduino.h>
+#include <algorithm>
+
+#include <Adafruit_GFX.h>
+
+#include "compact_font.h"
+#include "polygon.h"
+
+namespace EinkCanvas{
+
+/**
+ * @class GFXCanvasBW
+ * @brief Black and white canvas implementation for Adafruit GFX library
+ * 
+ * GFXCanvasBW provides a memory buffer-based black and white drawing surface 
+ * where each pixel is represented by a single bit (1-bit per pixel). This allows
+ * for memory-efficient display buffers for monochrome displays.
+ * 
+ * The class inherits from Adafruit_GFX, providing all standard drawing primitives
+ * while implementing the pixel-specific operations for a 1-bit per pixel buffer.
+ * 
+ * Drawing is limited to the active viewport, which translates coordinates and clips
+ * drawing to its rectangle. Viewports are nested by pushViewport() and popViewport().
+ * Rectangles, lines and glyphs are clipped once and rasterized without per pixel checks.
+ *
+ * @note The buffer is organized with 8 pixels per byte. The bits within each byte
+ *       are ordered from most significant bit (leftmost pixel) to least significant bit.
+ */
+class GFXCanvasBW : public Adafruit_GFX {
+public:
+    /**
+     * @brief Construct a new black and white canvas
+     * 
+     * @param w Width of the canvas in pixels
+     * @param h Height of the canvas in pixels
+     */
+    GFXCanvasBW(uint16_t w, uint16_t h): Adafruit_GFX(w, h) {
+        buffer = new uint8_t[(w * h + 7) / 8];
+        memset(buffer, 0, (w * h + 7) / 8);
+        m_viewports[0] = {0, 0, 0, 0, (int16_t)(w - 1), (int16_t)(h - 1)};
+    }
+
+    /**
+     * @brief Construct a canvas drawing into an external buffer, e.g. EinkCanvas::Surface
+     *
+     * @param w Width of the canvas in pixels
+     * @param h Height of the canvas in pixels
+     * @param bits Buffer of at least (w * h + 7) / 8 bytes, it is not cleared nor freed
+     */
+    GFXCanvasBW(uint16_t w, uint16_t h, uint8_t* bits): Adafruit_GFX(w, h), buffer(bits), m_owned(false) {
+        m_viewports[0] = {0, 0, 0, 0, (int16_t)(w - 1), (int16_t)(h - 1)};
+    }
+
+    ~GFXCanvasBW() {
+        if (m_owned) delete[] buffer;
+    }
+
+    GFXCanvasBW(const GFXCanvasBW&) = delete;
+    GFXCanvasBW& operator=(const GFXCanvasBW&) = delete;
+
+    /**
+     * @brief Draw a pixel at the specified coordinates
+     * 
+     * @param x X coordinate
+     * @param y Y coordinate
+     * @param color Pixel color (any non-zero value is treated as "on")
+     * @note The function handles bounds checking and will not draw outside the viewport
+     */
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        const Viewport& v = m_viewports[m_depth];
+        x += v.origin_x;
+        y += v.origin_y;
+        if ((x < v.clip_x0) || (x > v.clip_x1) || (y < v.clip_y0) || (y > v.clip_y1)) return;
+        setPixel((uint32_t)y * width() + x, color);
+    }
+
+    /**
+     * @brief Fill a rectangle, it is clipped once and filled by whole bytes
+     *
+     * @param x X coordinate of the top-left corner
+     * @param y Y coordinate of the top-left corner
+     * @param w Width of the rectangle
+     * @param h Height of the rectangle
+     * @param color Pixel color (any non-zero value is treated as "on")
+     */
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+        if (w <= 0 || h <= 0) return;
+        int16_t x0 = x, y0 = y, x1 = x + w - 1, y1 = y + h - 1;
+        if (!clipRect(x0, y0, x1, y1)) return;
+        uint32_t bit = (uint32_t)y0 * width() + x0;
+        for (int16_t row = y0; row <= y1; row++, bit += width()) {
+            fillSpan(bit, x1 - x0 + 1, color);
+        }
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+        if (w < 0) {
+            x += w + 1;
+            w = -w;
+        }
+        fillRect(x, y, w, 1, color);
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+        if (h < 0) {
+            y += h + 1;
+            h = -h;
+        }
+        fillRect(x, y, 1, h, color);
+    }
+
+    /**
+     * @brief Fill the whole canvas, regardless of the viewport
+     *
+     * @param color Pixel color (any non-zero value is treated as "on")
+     */
+    void fillScreen(uint16_t color) override {
+        memset(buffer, color ? 0xFF : 0x00, ((uint32_t)width() * height() + 7) / 8);
+    }
+
+    /**
+     * @brief Draw a line, same pixels as Adafruit GFX draws
+     *
+     * Part of the line inside of the viewport is found first, Bresenham's algorithm
+     * then starts from its first pixel and runs without bounds checks.
+     * @param x0 X coordinate of the start point
+     * @param y0 Y coordinate of the start point
+     * @param x1 X coordinate of the end point
+     * @param y1 Y coordinate of the end point
+     * @param color Pixel color (any non-zero value is treated as "on")
+     */
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) override {
+        if (x0 == x1) {
+            drawFastVLine(x0, std::min(y0, y1), abs(y1 - y0) + 1, color);
+            return;
+        }
+        if (y0 == y1) {
+            drawFastHLine(std::min(x0, x1), y0, abs(x1 - x0) + 1, color);
+            return;
+        }
+        const Viewport& v = m_viewports[m_depth];
+        // Coordinates along the major axis u and the minor axis v
+        int32_t u0 = x0 + v.origin_x, v0 = y0 + v.origin_y;
+        int32_t u1 = x1 + v.origin_x, v1 = y1 + v.origin_y;
+        int32_t u_min = v.clip_x0, u_max = v.clip_x1, v_min = v.clip_y0, v_max = v.clip_y1;
+        const bool steep = abs(y1 - y0) > abs(x1 - x0);
+        if (steep) {
+            std::swap(u0, v0);
+            std::swap(u1, v1);
+            std::swap(u_min, v_min);
+            std::swap(u_max, v_max);
+        }
+        if (u0 > u1) {
+            std::swap(u0, u1);
+            std::swap(v0, v1);
+        }
+        const int32_t du = u1 - u0;
+        const int32_t dv = abs(v1 - v0);
+        const int8_t v_step = v0 < v1 ? 1 : -1;
+        const int32_t half = du / 2;
+
+        // Step k draws pixel (u0 + k, v0 + v_step * m), where m = max(0, ceil((k * dv - half) / du))
+        int32_t k_start = std::max<int32_t>(0, u_min - u0);
+        int32_t k_end = std::min<int32_t>(du, u_max - u0);
+        const int32_t m_low = v_step > 0 ? v_min - v0 : v0 - v_max;
+        const int32_t m_high = v_step > 0 ? v_max - v0 : v0 - v_min;
+        if (m_high < 0) return;
+        k_end = std::min<int32_t>(k_end, (m_high * du + half) / dv);
+        if (m_low > 0) {
+            k_start = std::max<int32_t>(k_start, ((m_low - 1) * du + half) / dv + 1);
+        }
+        if (k_start > k_end) return;
+
+        int32_t m = std::max<int32_t>(0, (k_start * dv - half + du - 1) / du);
+        int32_t error = half - k_start * dv + m * du;
+        for (int32_t k = k_start; k <= k_end; k++) {
+            const int32_t u = u0 + k;
+            const int32_t v = v0 + v_step * m;
+            setPixel(steep ? (uint32_t)u * width() + v : (uint32_t)v * width() + u, color);
+            error -= dv;
+            if (error < 0) {
+                m++;
+                error += du;
+            }
+        }
+    }
+
+    /**
+     * @brief Push a viewport, following drawing is translated to it and clipped by it
+     *
+     * @param x X coordinate of the viewport in the current viewport
+     * @param y Y coordinate of the viewport in the current viewport
+     * @param w Width of the viewport
+     * @param h Height of the viewport
+     * @return true if the viewport was pushed, false if the stack is full
+     */
+    bool pushViewport(int16_t x, int16_t y, int16_t w, int16_t h) {
+        if (m_depth + 1 >= M_MAX_VIEWPORTS) return false;
+        const Viewport& current = m_viewports[m_depth];
+        Viewport& next = m_viewports[m_depth + 1];
+        next.origin_x = current.origin_x + x;
+        next.origin_y = current.origin_y + y;
+        next.clip_x0 = std::max<int16_t>(current.clip_x0, next.origin_x);
+        next.clip_y0 = std::max<int16_t>(current.clip_y0, next.origin_y);
+        next.clip_x1 = std::min<int32_t>(current.clip_x1, (int32_t)next.origin_x + w - 1);
+        next.clip_y1 = std::min<int32_t>(current.clip_y1, (int32_t)next.origin_y + h - 1);
+        m_depth++;
+        return true;
+    }
+
+    /**
+     * @brief Pop the last pushed viewport, the whole canvas is never popped
+     */
+    void popViewport() {
+        if (m_depth > 0) m_depth--;
+    }
+
+    /**
+     * @brief Get position of the active viewport in the canvas
+     *
+     * @param x Output x coordinate of the viewport origin
+     * @param y Output y coordinate of the viewport origin
+     */
+    void getOrigin(int16_t& x, int16_t& y) const {
+        x = m_viewports[m_depth].origin_x;
+        y = m_viewports[m_depth].origin_y;
+    }
+
+    /**
+     * @brief Translate a rectangle from the viewport to the canvas and clip it by the viewport
+     *
+     * @param x0 Left column, inclusive
+     * @param y0 Top row, inclusive
+     * @param x1 Right column, inclusive
+     * @param y1 Bottom row, inclusive
+     * @return true if part of the rectangle is visible, false if nothing is
+     */
+    bool clipRect(int16_t& x0, int16_t& y0, int16_t& x1, int16_t& y1) const {
+        const Viewport& v = m_viewports[m_depth];
+        const int32_t cx0 = std::max<int32_t>(v.clip_x0, (int32_t)x0 + v.origin_x);
+        const int32_t cy0 = std::max<int32_t>(v.clip_y0, (int32_t)y0 + v.origin_y);
+        const int32_t cx1 = std::min<int32_t>(v.clip_x1, (int32_t)x1 + v.origin_x);
+        const int32_t cy1 = std::min<int32_t>(v.clip_y1, (int32_t)y1 + v.origin_y);
+        if (cx0 > cx1 || cy0 > cy1) return false;
+        x0 = cx0;
+        y0 = cy0;
+        x1 = cx1;
+        y1 = cy1;
+        return true;
+    }
+
+    /**
+     * @brief Draw a glyph of a GFX font, only set pixels of the glyph are drawn.
+     *
+     * Glyph is clipped once against the viewport and its bits are written directly
+     * into the buffer.
+     * @param x X coordinate of the glyph origin
+     * @param y Y coordinate of the baseline
+     * @param font Font of the glyph
+     * @param c Character to draw
+     * @param color Pixel color (any non-zero value is treated as "on")
+     * @return Horizontal advance of the glyph, 0 if the font does not contain the character
+     */
+    uint8_t drawGlyph(int16_t x, int16_t y, const GFXfont* font, uint8_t c, uint16_t color) {
+        if (c < font->first || c > font->last) return 0;
+        const GFXglyph& glyph = font->glyph[c - font->first];
+        const uint8_t* bitmap = font->bitmap + glyph.bitmapOffset;
+        const Viewport& v = m_viewports[m_depth];
+        const int16_t x0 = x + glyph.xOffset + v.origin_x;
+        const int16_t y0 = y + glyph.yOffset + v.origin_y;
+
+        const int16_t col_start = std::max<int16_t>(0, v.clip_x0 - x0);
+        const int16_t col_end = std::min<int16_t>(glyph.width, v.clip_x1 + 1 - x0);
+        const int16_t row_start = std::max<int16_t>(0, v.clip_y0 - y0);
+        const int16_t row_end = std::min<int16_t>(glyph.height, v.clip_y1 + 1 - y0);
+
+        for (int16_t row = row_start; row < row_end; row++) {
+            uint16_t bit = row * glyph.width + col_start;
+            uint32_t index = x0 + col_start + (y0 + row) * width();
+            for (int16_t col = col_start; col < col_end; col++, bit++, index++) {
+                if (!(bitmap[bit >> 3] & (0x80 >> (bit & 7)))) continue;
+                if (color)
+                    buffer[index >> 3] |= 0x80 >> (index & 7);
+                else
+                    buffer[index >> 3] &= ~(0x80 >> (index & 7));
+            }
+        }
+        return glyph.xAdvance;
+    }
+
+    /**
+     * @brief Write a row of packed pixels, pixels outside of the viewport are skipped.
+     *
+     * Pixels are written a whole destination byte at a time, bits are shifted
+     * when x is not aligned to 8.
+     * @param x X coordinate of the first pixel
+     * @param y Y coordinate of the row
+     * @param bits Packed pixels, MSB of the first byte is the first pixel
+     * @param w Number of pixels
+     */
+    void writeRow(int16_t x, int16_t y, const uint8_t* bits, int16_t w) {
+        if (w <= 0) return;
+        int16_t x1 = x + w - 1, y1 = y;
+        const int16_t local_x = x;
+        if (!clipRect(x, y, x1, y1)) return;
+        const Viewport& v = m_viewports[m_depth];
+        const int16_t skip = x - (local_x + v.origin_x);
+        w = x1 - x + 1;
+
+        writeBits((uint32_t)y * width() + x, bits, skip, w);
+    }
+
+    /**
+     * @brief Read a row of packed pixels, counterpart of writeRow().
+     *
+     * Coordinates are translated by the viewport, but not clipped by it. Pixels
+     * outside of the canvas are read as 0.
+     * @param x X coordinate of the first pixel
+     * @param y Y coordinate of the row
+     * @param bits Output, MSB of the first byte is the first pixel
+     * @param w Number of pixels
+     */
+    void readRow(int16_t x, int16_t y, uint8_t* bits, int16_t w) const {
+        if (w <= 0) return;
+        memset(bits, 0, (w + 7) / 8);
+        const Viewport& v = m_viewports[m_depth];
+        const int32_t cx = (int32_t)x + v.origin_x;
+        const int32_t cy = (int32_t)y + v.origin_y;
+        if (cy < 0 || cy >= height()) return;
+        const int32_t end = std::min<int32_t>(w, width() - cx);
+        uint32_t bit = cy * width() + cx;
+        for (int32_t i = std::max<int32_t>(0, -cx); i < end;) {
+            const uint8_t count = std::min<int32_t>(8 - (i & 7), end - i);
+            uint8_t value;
+            readBits(bit + i, &value, count);
+            bits[i >> 3] |= (value & ~(0xFF >> count)) >> (i & 7);
+            i += count;
+        }
+    }
+
+    /**
+     * @brief Scroll content of a rectangle, pixels shifted out of it are lost.
+     *
+     * Rows are moved by memmove when source and destination share bit alignment,
+     * otherwise they are shifted by whole bytes through a buffer on the stack, rows wider
+     * than M_SCROLL_PIECE_SIZE bytes piece by piece. Exposed strip
+     * is filled with the color, so it can be drawn again.
+     * @param x X coordinate of the top-left corner
+     * @param y Y coordinate of the top-left corner
+     * @param w Width of the rectangle
+     * @param h Height of the rectangle
+     * @param dx Horizontal shift, positive moves content to the right
+     * @param dy Vertical shift, positive moves content down
+     * @param color Color of the exposed strip (any non-zero value is treated as "on")
+     */
+    void scrollRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx, int16_t dy, uint16_t color) {
+        if (w <= 0 || h <= 0) return;
+        int16_t x0 = x, y0 = y, x1 = x + w - 1, y1 = y + h - 1;
+        if (!clipRect(x0, y0, x1, y1)) return;
+        w = x1 - x0 + 1;
+        h = y1 - y0 + 1;
+        if (abs(dx) >= w || abs(dy) >= h) {
+            uint32_t bit = (uint32_t)y0 * width() + x0;
+            for (int16_t row = y0; row <= y1; row++, bit += width()) {
+                fillSpan(bit, w, color);
+            }
+            return;
+        }
+
+        const int16_t count = w - abs(dx);
+        const int16_t src_x = dx > 0 ? x0 : x0 - dx;
+        const int16_t dst_x = dx > 0 ? x0 + dx : x0;
+        const int16_t rows = h - abs(dy);
+        if (dx == 0 && w == width() && (width() & 7) == 0) {
+            // Rows of the whole canvas are contiguous
+            const uint16_t stride = width() / 8;
+            const int16_t src_y = dy > 0 ? y0 : y0 - dy;
+            memmove(buffer + (uint32_t)(src_y + dy) * stride, buffer + (uint32_t)src_y * stride, (uint32_t)rows * stride);
+        } else {
+            const bool aligned = ((uint32_t)dy * width() + dx) % 8 == 0;
+            uint8_t piece[M_SCROLL_PIECE_SIZE];
+            const int16_t piece_width = M_SCROLL_PIECE_SIZE * 8;
+            for (int16_t i = 0; i < rows; i++) {
+                // Moving down is done from the bottom, so no source row is overwritten before it is read
+                const int16_t dst_y = dy > 0 ? y1 - i : y0 + i;
+                const uint32_t src_bit = (uint32_t)(dst_y - dy) * width() + src_x;
+                const uint32_t dst_bit = (uint32_t)dst_y * width() + dst_x;
+                if (aligned) {
+                    moveSpan(dst_bit, src_bit, count);
+                    continue;
+                }
+                // Pieces are copied against the shift, so none is overwritten in its row before it is read
+                for (int16_t done = 0; done < count; done += piece_width) {
+                    const int16_t length = std::min<int16_t>(piece_width, count - done);
+                    const int16_t offset = dx > 0 ? count - done - length : done;
+                    readBits(src_bit + offset, piece, length);
+                    writeBits(dst_bit + offset, piece, 0, length);
+                }
+            }
+        }
+
+        const int16_t exposed_y0 = dy > 0 ? y0 : y1 + dy + 1;
+        const int16_t exposed_x0 = dx > 0 ? x0 : x1 + dx + 1;
+        const int16_t moved_y0 = dy > 0 ? y0 + dy : y0;
+        uint32_t bit = (uint32_t)exposed_y0 * width() + x0;
+        for (int16_t i = 0; i < abs(dy); i++, bit += width()) {
+            fillSpan(bit, w, color);
+        }
+        bit = (uint32_t)moved_y0 * width() + exposed_x0;
+        for (int16_t i = 0; dx != 0 && i < rows; i++, bit += width()) {
+            fillSpan(bit, abs(dx), color);
+        }
+    }
+
+    /**
+     * @brief Draw a glyph of a compact font, only set pixels of the glyph are drawn.
+     *
+     * Glyph is decoded on the fly into runs of set pixels, runs are clipped against
+     * the viewport and filled by whole bytes.
+     * @param x X coordinate of the glyph origin
+     * @param y Y coordinate of the baseline
+     * @param font Font of the glyph
+     * @param glyph Glyph of the font, see EinkDisplay::find_glyph()
+     * @param color Pixel color (any non-zero value is treated as "on")
+     * @return Horizontal advance of the glyph
+     */
+    uint8_t drawCompactGlyph(int16_t x, int16_t y, const EinkDisplay::CompactFont& font,
+                             const EinkDisplay::CompactGlyph& glyph, uint16_t color) {
+        const Viewport& v = m_viewports[m_depth];
+        const int16_t x0 = x + glyph.x_offset + v.origin_x;
+        const int16_t y0 = y + glyph.y_offset + v.origin_y;
+        if (x0 > v.clip_x1 || y0 > v.clip_y1 || x0 + (int16_t)glyph.width <= v.clip_x0 ||
+            y0 + glyph.height <= v.clip_y0) {
+            return glyph.x_advance;
+        }
+        EinkDisplay::for_each_run(font, glyph, [&](uint8_t row, uint8_t column, uint8_t length) {
+            const int16_t py = y0 + row;
+            const int16_t start = std::max<int16_t>(x0 + column, v.clip_x0);
+            const int16_t end = std::min<int16_t>(x0 + column + length - 1, v.clip_x1);
+            if (py < v.clip_y0 || py > v.clip_y1 || start > end) return;
+            fillSpan((uint32_t)py * width() + start, end - start + 1, color);
+        });
+        return glyph.x_advance;
+    }
+
+    /**
+     * @brief Fill polygons of the rasterizer, rows and spans are clipped by the viewport.
+     *
+     * Only rows inside of the viewport are rasterized, spans are filled by whole bytes.
+     * @param rasterizer Rasterizer with contours in viewport coordinates
+     * @param color Pixel color (any non-zero value is treated as "on")
+     * @param x0 Output left column of filled pixels in the canvas
+     * @param y0 Output top row of filled pixels in the canvas
+     * @param x1 Output right column of filled pixels in the canvas, inclusive
+     * @param y1 Output bottom row of filled pixels in the canvas, inclusive
+     * @return true if any pixel was filled, false otherwise
+     */
+    bool fillPolygon(ScanlineRasterizer& rasterizer, uint16_t color,
+                     int16_t& x0, int16_t& y0, int16_t& x1, int16_t& y1) {
+        const Viewport& v = m_viewports[m_depth];
+        const int32_t first = std::max<int32_t>(rasterizer.top(), v.clip_y0 - v.origin_y);
+        const int32_t last = std::min<int32_t>(rasterizer.bottom(), v.clip_y1 - v.origin_y);
+        if (first > last) return false;
+        x0 = y0 = INT16_MAX;
+        x1 = y1 = INT16_MIN;
+        rasterizer.start(first);
+        for (int32_t row = first; row <= last; row++) {
+            uint16_t count;
+            const Span* spans = rasterizer.next_row(count);
+            const int16_t y = row + v.origin_y;
+            for (uint16_t i = 0; i < count; i++) {
+                const int16_t start = std::max<int32_t>(spans[i].x0 + v.origin_x, v.clip_x0);
+                const int16_t end = std::min<int32_t>(spans[i].x1 + v.origin_x, v.clip_x1);
+                if (start > end) continue;
+                fillSpan((uint32_t)y * width() + start, end - start + 1, color);
+                x0 = std::min(x0, start);
+                x1 = std::max(x1, end);
+                y0 = std::min(y0, y);
+                y1 = y;
+            }
+        }
+        return x0 <= x1;
+    }
+
+    /**
+     * @brief Get the internal pixel buffer
+     * 
+     * @return Pointer to the raw pixel buffer
+     * @note Each byte contains 8 pixels, with the MSB representing the leftmost pixel
+     */
+    uint8_t *getBuffer() {
+        return buffer;
+    }
+
+    /// Maximal depth of nested viewports including the whole canvas
+    static constexpr uint8_t M_MAX_VIEWPORTS = 8;
+
+    /// Bytes of the buffer of scrollRect() for rows without common bit alignment
+    static constexpr uint8_t M_SCROLL_PIECE_SIZE = 32;
+
+private:
+    /**
+     * @brief Translation and clip rectangle in canvas coordinates, inclusive.
+     */
+    struct Viewport {
+        int16_t origin_x;
+        int16_t origin_y;
+        int16_t clip_x0;
+        int16_t clip_y0;
+        int16_t clip_x1;
+        int16_t clip_y1;
+    };
+
+    /**
+     * @brief Set a pixel without any checks.
+     * @param bit Index of the pixel in the buffer.
+     * @param color Pixel color (any non-zero value is treated as "on")
+     */
+    void setPixel(uint32_t bit, uint16_t color) {
+        if (color)
+            buffer[bit >> 3] |= 0x80 >> (bit & 7);
+        else
+            buffer[bit >> 3] &= ~(0x80 >> (bit & 7));
+    }
+
+    /**
+     * @brief Fill consecutive pixels without any checks, inner bytes are filled at once.
+     * @param bit Index of the first pixel in the buffer.
+     * @param count Number of pixels.
+     * @param color Pixel color (any non-zero value is treated as "on")
+     */
+    void fillSpan(uint32_t bit, uint16_t count, uint16_t color) {
+        const uint8_t value = color ? 0xFF : 0x00;
+        uint8_t* dst = buffer + (bit >> 3);
+        const uint8_t offset = bit & 7;
+        if (offset + count <= 8) {
+            const uint8_t mask = (0xFF >> offset) & ~(0xFF >> (offset + count));
+            *dst = (*dst & ~mask) | (value & mask);
+            return;
+        }
+        if (offset != 0) {
+            const uint8_t mask = 0xFF >> offset;
+            *dst = (*dst & ~mask) | (value & mask);
+            dst++;
+            count -= 8 - offset;
+        }
+        memset(dst, value, count / 8);
+        dst += count / 8;
+        if (count & 7) {
+            const uint8_t mask = ~(0xFF >> (count & 7));
+            *dst = (*dst & ~mask) | (value & mask);
+        }
+    }
+
+    /**
+     * @brief Write packed pixels without any checks, a whole destination byte at a time.
+     * @param dst_bit Index of the first destination pixel in the buffer.
+     * @param bits Packed pixels, MSB of the first byte is the first pixel.
+     * @param src_bit Index of the first pixel in bits.
+     * @param count Number of pixels.
+     */
+    void writeBits(uint32_t dst_bit, const uint8_t* bits, uint16_t src_bit, uint16_t count) {
+        const uint16_t src_end = src_bit + count;
+        const uint16_t src_bytes = (src_end + 7) / 8;
+        while (src_bit < src_end) {
+            const uint8_t dst_offset = dst_bit & 7;
+            const uint8_t n = std::min<uint16_t>(8 - dst_offset, src_end - src_bit);
+            const uint16_t src_byte = src_bit >> 3;
+            const uint16_t pair = (bits[src_byte] << 8) | (src_byte + 1 < src_bytes ? bits[src_byte + 1] : 0);
+            const uint8_t value = (pair << (src_bit & 7)) >> 8;
+            const uint8_t mask = (0xFF >> dst_offset) & ~(0xFF >> (dst_offset + n));
+            uint8_t& dst = buffer[dst_bit >> 3];
+            dst = (dst & ~mask) | ((value >> dst_offset) & mask);
+            src_bit += n;
+            dst_bit += n;
+        }
+    }
+
+    /**
+     * @brief Read consecutive pixels without any checks into packed bits.
+     * @param bit Index of the first pixel in the buffer.
+     * @param bits Output, MSB of the first byte is the first pixel.
+     * @param count Number of pixels.
+     */
+    void readBits(uint32_t bit, uint8_t* bits, uint16_t count) const {
+        const uint8_t* src = buffer + (bit >> 3);
+        const uint8_t shift = bit & 7;
+        const uint16_t bytes = (count + 7) / 8;
+        const uint16_t src_bytes = (shift + count + 7) / 8;
+        for (uint16_t i = 0; i < bytes; i++) {
+            const uint16_t pair = (src[i] << 8) | (i + 1 < src_bytes ? src[i + 1] : 0);
+            bits[i] = (pair << shift) >> 8;
+        }
+    }
+
+    /**
+     * @brief Move consecutive pixels with the same bit alignment, spans may overlap.
+     * @param dst_bit Index of the first destination pixel, dst_bit % 8 == src_bit % 8.
+     * @param src_bit Index of the first source pixel.
+     * @param count Number of pixels.
+     */
+    void moveSpan(uint32_t dst_bit, uint32_t src_bit, uint16_t count) {
+        uint8_t* dst = buffer + (dst_bit >> 3);
+        const uint8_t* src = buffer + (src_bit >> 3);
+        const uint8_t offset = dst_bit & 7;
+        if (offset + count <= 8) {
+            const uint8_t mask = (0xFF >> offset) & ~(0xFF >> (offset + count));
+            *dst = (*dst & ~mask) | (*src & mask);
+            return;
+        }
+        const uint16_t last = (offset + count - 1) / 8;
+        const uint8_t head_mask = 0xFF >> offset;
+        const uint8_t tail_mask = ~(0xFF >> ((offset + count - 1) % 8 + 1));
+        // Edges are read first, the middle can overlap them
+        const uint8_t head = *src;
+        const uint8_t tail = src[last];
+        memmove(dst + 1, src + 1, last - 1);
+        *dst = (*dst & ~head_mask) | (head & head_mask);
+        dst[last] = (dst[last] & ~tail_mask) | (tail & tail_mask);
+    }
+
+    uint8_t *buffer;
+    bool m_owned = true;
+    Viewport m_viewports[M_MAX_VIEWPORTS];
+    uint8_t m_depth = 0;
+};
+
+} // namespace EinkCanvas
@@ -0,0 +1,67 @@
+#include "compact_font.h"
+
+namespace EinkDisplay {
+
+const CompactGlyph* find_glyph(const CompactFont& font, uint32_t codepoint) {
+    uint16_t low = 0;
+    uint16_t high = font.range_count;
+    while (low < high) {
+        const uint16_t middle = (low + high) / 2;
+        const CompactRange& range = font.ranges[middle];
+        if (codepoint < range.first) {
+            high = middle;
+        } else if (codepoint >= range.first + range.count) {
+            low = middle + 1;
+        } else {
+            return &font.glyphs[range.glyph + (codepoint - range.first)];
+        }
+    }
+    return nullptr;
+}
+
+uint32_t utf8_next(const char*& text) {
+    // Terminating zero is not a continuation byte, so decoding stops at it
+    return utf8_next(text, text + 4);
+}
+
+uint32_t utf8_next(const char*& text, const char* end) {
+    const uint8_t lead = *text++;
+    if (lead < 0x80) {
+        return lead;
+    }
+    uint8_t length;
+    uint32_t codepoint;
+    uint32_t minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 1;
+        codepoint = lead & 0x1F;
+        minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 2;
+        codepoint = lead & 0x0F;
+        minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 3;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        return 0xFFFD;
+    }
+    if (end - text < length) {
+        return 0xFFFD;
+    }
+    const char* next = text;
+    for (uint8_t i = 0; i < length; i++, next++) {
+        if ((*next & 0xC0) != 0x80) {
+            return 0xFFFD;
+        }
+        codepoint = (codepoint << 6) | (*next & 0x3F);
+    }
+    if (codepoint < minimum || codepoint > 0x10FFFF) {
+        return 0xFFFD;
+    }
+    text = next;
+    return codepoint;
+}
+
+} // namespace EinkDisplay
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace EinkDisplay{
+
+/**
+ * @brief Glyph of CompactFont, 8 bytes.
+ */
+struct CompactGlyph {
+    uint32_t offset : 24; ///< Offset of compressed bitmap in CompactFont::bitmap
+    uint32_t width : 8;   ///< Width of the bitmap in pixels
+    uint8_t height;       ///< Height of the bitmap in pixels
+    uint8_t x_advance;    ///< Distance to the origin of the next glyph
+    int8_t x_offset;      ///< Offset of the bitmap from the origin
+    int8_t y_offset;      ///< Offset of the bitmap from the baseline, negative is above
+};
+
+/**
+ * @brief Range of consecutive codepoints, their glyphs follow each other.
+ */
+struct CompactRange {
+    uint32_t first;  ///< First codepoint of the range
+    uint16_t count;  ///< Number of codepoints in the range
+    uint16_t glyph;  ///< Index of the glyph of the first codepoint
+};
+
+/**
+ * @brief Font with sparse set of codepoints and compressed glyphs.
+ *
+ * Ranges are sorted by codepoint, so glyph is found by binary search. Bitmap of a glyph
+ * is a sequence of its pixels row by row, encoded by bytes:
+ * - 1xxxxxxx: next 7 pixels, bit 6 first, 1 is set pixel
+ * - 0cnnnnnn: run of nnnnnn + 1 pixels of color c
+ *
+ * Fonts are generated by tools/compact_font_convert.py.
+ */
+struct CompactFont {
+    const uint8_t* bitmap;
+    const CompactGlyph* glyphs;
+    const CompactRange* ranges;
+    uint16_t range_count;
+    uint8_t y_advance; ///< Distance between baselines of lines
+};
+
+/**
+ * @brief Find glyph of the codepoint.
+ * @param font The font.
+ * @param codepoint Unicode codepoint.
+ * @return Pointer to the glyph, nullptr if the font does not contain the codepoint.
+ */
+const CompactGlyph* find_glyph(const CompactFont& font, uint32_t codepoint);
+
+/**
+ * @brief Decode next character of UTF-8 text.
+ *
+ * Invalid sequences decode to U+FFFD and skip a single byte, decoding never reads
+ * past the terminating zero.
+ * @param text Pointer to the character, moved after it.
+ * @return Unicode codepoint.
+ */
+uint32_t utf8_next(const char*& text);
+
+/**
+ * @brief Decode next character of UTF-8 text which does not have to be terminated.
+ *
+ * Invalid sequences and sequences cut by the end decode to U+FFFD and skip a single byte,
+ * decoding never reads at or past the end.
+ * @param text Pointer to the character before the end, moved after it.
+ * @param end End of the text.
+ * @return Unicode codepoint.
+ */
+uint32_t utf8_next(const char*& text, const char* end);
+
+/**
+ * @brief Decode bitmap of a glyph and call the callback for every run of set pixels.
+ *
+ * Runs never cross rows. Nothing is allocated, pixels are decoded on the fly.
+ * @param font Font of the glyph.
+ * @param glyph The glyph.
+ * @param callback Callable void(uint8_t row, uint8_t column, uint8_t length).
+ */
+template <typename Callback>
+void for_each_run(const CompactFont& font, const CompactGlyph& glyph, Callback&& callback) {
+    const uint8_t* data = font.bitmap + glyph.offset;
+    const uint16_t width = glyph.width;
+    const uint16_t total = width * glyph.height;
+    auto emit = [&](uint16_t start, uint16_t length) {
+        uint8_t row = start / width;
+        uint8_t column = start % width;
+        while (length > 0) {
+            const uint8_t count = length < width - column ? length : width - column;
+            callback(row, column, count);
+            length -= count;
+            row++;
+            column = 0;
+        }
+    };
+
+    uint16_t pixel = 0;
+    while (pixel < total) {
+        const uint8_t code = *data++;
+        if (code & 0x80) {
+            const uint8_t count = total - pixel < 7 ? total - pixel : 7;
+            uint8_t run = 0;
+            for (uint8_t i = 0; i < count; i++) {
+                if (code & (0x40 >> i)) {
+                    run++;
+                } else if (run > 0) {
+                    emit(pixel + i - run, run);
+                    run = 0;
+                }
+            }
+            if (run > 0) {
+                emit(pixel + count - run, run);
+            }
+            pixel += count;
+        } else {
+            const uint16_t length = (code & 0x3F) + 1;
+            const uint16_t count = total - pixel < length ? total - pixel : length;
+            if (code & 0x40) {
+                emit(pixel, count);
+            }
+            pixel += count;
+        }
+    }
+}
+
+} // namespace EinkDisplay
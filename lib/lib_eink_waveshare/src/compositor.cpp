@@ -0,0 +1,232 @@
+#include "compositor.h"
+
+#include <algorithm>
+
+namespace EinkCanvas {
+
+namespace {
+
+template <BlendOp Op, typename T>
+inline T blend(T dst, T src) {
+    switch (Op) {
+    case BlendOp::COPY: return src;
+    case BlendOp::AND: return dst & src;
+    case BlendOp::OR: return dst | src;
+    case BlendOp::XOR: return dst ^ src;
+    case BlendOp::INVERT: return dst ^ (T)~src;
+    }
+    return dst;
+}
+
+template <BlendOp Op>
+inline void blend_masked(uint8_t* dst, uint8_t src, uint8_t mask) {
+    *dst = (*dst & ~mask) | (blend<Op, uint8_t>(*dst, src) & mask);
+}
+
+template <BlendOp Op>
+void blend_rows(uint8_t* dst, const uint8_t* src, uint16_t stride,
+                uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+    const uint16_t first = x0 / 8;
+    const uint16_t last = x1 / 8;
+    const uint8_t first_mask = 0xFF >> (x0 & 7);
+    const uint8_t last_mask = 0xFF << (7 - (x1 & 7));
+
+    for (uint16_t y = y0; y <= y1; y++) {
+        uint8_t* d = dst + (uint32_t)y * stride;
+        const uint8_t* s = src + (uint32_t)y * stride;
+        if (first == last) {
+            blend_masked<Op>(d + first, s[first], first_mask & last_mask);
+            continue;
+        }
+        blend_masked<Op>(d + first, s[first], first_mask);
+        uint16_t i = first + 1;
+        // Rows are not aligned to words, memcpy compiles to plain loads where it is allowed
+        for (; i + 4 <= last; i += 4) {
+            uint32_t dw, sw;
+            memcpy(&dw, d + i, 4);
+            memcpy(&sw, s + i, 4);
+            dw = blend<Op, uint32_t>(dw, sw);
+            memcpy(d + i, &dw, 4);
+        }
+        for (; i < last; i++) {
+            d[i] = blend<Op, uint8_t>(d[i], s[i]);
+        }
+        blend_masked<Op>(d + last, s[last], last_mask);
+    }
+}
+
+inline uint32_t load_big_endian(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+inline void store_big_endian(uint8_t* p, uint32_t value) {
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+template <BlendOp Op>
+void blit_row(uint8_t* dst, uint32_t dst_bit, const uint8_t* src, uint32_t src_bit, uint16_t count) {
+    uint8_t* d = dst + (dst_bit >> 3);
+    const uint8_t* s = src + (src_bit >> 3);
+    const uint8_t offset = dst_bit & 7;
+    const uint16_t last = (offset + count - 1) / 8;
+    const int32_t s_last = (src_bit + count - 1) / 8 - src_bit / 8;
+    // Byte i of the destination gets source bits from byte i + lead of s, shifted left
+    const int32_t base = (int32_t)(src_bit & 7) - offset;
+    const int8_t lead = base < 0 ? -1 : 0;
+    const uint8_t shift = base & 7;
+    const uint8_t head_mask = 0xFF >> offset;
+    const uint8_t tail_mask = ~(0xFF >> ((offset + count - 1) % 8 + 1));
+
+    // Edge bytes may reach bytes outside of the source row, they are masked anyway
+    auto fetch = [&](int32_t i) -> uint8_t {
+        const int32_t j = i + lead;
+        const uint8_t high = j >= 0 ? s[j] : 0;
+        const uint8_t low = shift != 0 && j + 1 <= s_last ? s[j + 1] : 0;
+        return (high << shift) | (low >> (8 - shift));
+    };
+
+    if (last == 0) {
+        blend_masked<Op>(d, fetch(0), head_mask & tail_mask);
+        return;
+    }
+    blend_masked<Op>(d, fetch(0), head_mask);
+    uint16_t i = 1;
+    if (shift == 0) {
+        for (; i + 4 <= last; i += 4) {
+            uint32_t dw, sw;
+            memcpy(&dw, d + i, 4);
+            memcpy(&sw, s + i, 4);
+            dw = blend<Op, uint32_t>(dw, sw);
+            memcpy(d + i, &dw, 4);
+        }
+    } else {
+        for (; i + 4 <= last; i += 4) {
+            const uint8_t* p = s + i + lead;
+            const uint32_t sw = (load_big_endian(p) << shift) | (p[4] >> (8 - shift));
+            store_big_endian(d + i, blend<Op, uint32_t>(load_big_endian(d + i), sw));
+        }
+    }
+    for (; i < last; i++) {
+        d[i] = blend<Op, uint8_t>(d[i], fetch(i));
+    }
+    blend_masked<Op>(d + last, fetch(last), tail_mask);
+}
+
+template <BlendOp Op>
+void blit_rows(uint8_t* dst, uint32_t dst_pitch, uint32_t dst_bit, const uint8_t* src, uint32_t src_pitch,
+               uint32_t src_bit, uint16_t w, uint16_t h) {
+    for (uint16_t row = 0; row < h; row++, dst_bit += dst_pitch, src_bit += src_pitch) {
+        blit_row<Op>(dst, dst_bit, src, src_bit, w);
+    }
+}
+
+} // namespace
+
+
+void blend_rect(uint8_t* dst, const uint8_t* src, uint16_t stride,
+                uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, BlendOp op) {
+    switch (op) {
+    case BlendOp::COPY: blend_rows<BlendOp::COPY>(dst, src, stride, x0, y0, x1, y1); break;
+    case BlendOp::AND: blend_rows<BlendOp::AND>(dst, src, stride, x0, y0, x1, y1); break;
+    case BlendOp::OR: blend_rows<BlendOp::OR>(dst, src, stride, x0, y0, x1, y1); break;
+    case BlendOp::XOR: blend_rows<BlendOp::XOR>(dst, src, stride, x0, y0, x1, y1); break;
+    case BlendOp::INVERT: blend_rows<BlendOp::INVERT>(dst, src, stride, x0, y0, x1, y1); break;
+    }
+}
+
+
+void blit_bits(uint8_t* dst, uint32_t dst_pitch, uint16_t dst_x, uint16_t dst_y,
+               const uint8_t* src, uint32_t src_pitch, uint16_t src_x, uint16_t src_y,
+               uint16_t w, uint16_t h, BlendOp op) {
+    if (w == 0 || h == 0) {
+        return;
+    }
+    const uint32_t dst_bit = dst_y * dst_pitch + dst_x;
+    const uint32_t src_bit = src_y * src_pitch + src_x;
+    switch (op) {
+    case BlendOp::COPY: blit_rows<BlendOp::COPY>(dst, dst_pitch, dst_bit, src, src_pitch, src_bit, w, h); break;
+    case BlendOp::AND: blit_rows<BlendOp::AND>(dst, dst_pitch, dst_bit, src, src_pitch, src_bit, w, h); break;
+    case BlendOp::OR: blit_rows<BlendOp::OR>(dst, dst_pitch, dst_bit, src, src_pitch, src_bit, w, h); break;
+    case BlendOp::XOR: blit_rows<BlendOp::XOR>(dst, dst_pitch, dst_bit, src, src_pitch, src_bit, w, h); break;
+    case BlendOp::INVERT: blit_rows<BlendOp::INVERT>(dst, dst_pitch, dst_bit, src, src_pitch, src_bit, w, h); break;
+    }
+}
+
+
+Compositor::Compositor(uint16_t width, uint16_t height) :
+    m_width(width), m_height(height) {
+    m_layers[0] = {new GFXCanvasBW(width, height), BlendOp::COPY, true};
+    m_layers[0].canvas->fillScreen(1);
+    m_count = 1;
+}
+
+Compositor::~Compositor() {
+    for (uint8_t i = 0; i < m_count; i++) {
+        delete m_layers[i].canvas;
+    }
+}
+
+uint8_t Compositor::add_layer(BlendOp op) {
+    if (m_count >= M_MAX_LAYERS) {
+        debug::Print("Too many layers.\n");
+        return 0;
+    }
+    m_layers[m_count] = {new GFXCanvasBW(m_width, m_height), op, true};
+    m_layers[m_count].canvas->fillScreen(transparent_color(op));
+    return m_count++;
+}
+
+void Compositor::set_op(uint8_t index, BlendOp op) {
+    if (index == 0 || index >= m_count) {
+        debug::Print("Invalid layer.\n");
+        return;
+    }
+    m_layers[index].op = op;
+}
+
+void Compositor::set_visible(uint8_t index, bool visible) {
+    if (index == 0 || index >= m_count) {
+        debug::Print("Invalid layer.\n");
+        return;
+    }
+    m_layers[index].visible = visible;
+}
+
+void Compositor::clear(uint16_t color) {
+    m_layers[0].canvas->fillScreen(color);
+    for (uint8_t i = 1; i < m_count; i++) {
+        m_layers[i].canvas->fillScreen(m_layers[i].op == BlendOp::COPY ? color : transparent_color(m_layers[i].op));
+    }
+}
+
+void Compositor::compose(uint8_t* dst, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) const {
+    x1 = std::min<uint16_t>(x1, m_width - 1);
+    y1 = std::min<uint16_t>(y1, m_height - 1);
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+    uint16_t stride = m_width / 8;
+    if (m_width % 8 != 0) {
+        // Rows are packed without padding and are not aligned to bytes, whole buffer is composed
+        stride = 1;
+        x0 = 0;
+        x1 = 7;
+        y0 = 0;
+        y1 = ((uint32_t)m_width * m_height + 7) / 8 - 1;
+    }
+    for (uint8_t i = 0; i < m_count; i++) {
+        if (m_layers[i].visible) {
+            blend_rect(dst, m_layers[i].canvas->getBuffer(), stride, x0, y0, x1, y1,
+                       i == 0 ? BlendOp::COPY : m_layers[i].op);
+        }
+    }
+}
+
+uint16_t Compositor::transparent_color(BlendOp op) {
+    return (op == BlendOp::AND || op == BlendOp::INVERT) ? 1 : 0;
+}
+
+} // namespace EinkCanvas
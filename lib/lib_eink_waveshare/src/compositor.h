@@ -0,0 +1,167 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "canvas_bw.h"
+#include "my_utils.h"
+
+namespace EinkCanvas{
+
+/**
+ * @brief Operation combining pixels of a layer with layers below it, 1 is white.
+ */
+enum class BlendOp : uint8_t {
+    COPY,   ///< Layer replaces everything below it
+    AND,    ///< Black pixels of the layer are drawn, white are transparent
+    OR,     ///< White pixels of the layer are drawn, black are transparent
+    XOR,    ///< Pixels below white pixels of the layer are inverted
+    INVERT  ///< Pixels below black pixels of the layer are inverted
+};
+
+/**
+ * @brief Blend a rectangle of source buffer into destination buffer.
+ *
+ * Both buffers have the same layout, 1 bit per pixel with rows of stride bytes. Inner bytes
+ * of rows are processed 32 bits at a time, partial bytes at edges are masked.
+ * @param dst Destination buffer.
+ * @param src Source buffer.
+ * @param stride Number of bytes in a row.
+ * @param x0 Left column of the rectangle.
+ * @param y0 Top row of the rectangle.
+ * @param x1 Right column of the rectangle, inclusive.
+ * @param y1 Bottom row of the rectangle, inclusive.
+ * @param op Blend operation.
+ */
+void blend_rect(uint8_t* dst, const uint8_t* src, uint16_t stride,
+                uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, BlendOp op);
+
+/**
+ * @brief Blit a rectangle between buffers of different layouts, without any checks.
+ *
+ * Rows may start at any bit of both buffers. Source bits are shifted to the alignment
+ * of the destination, so inner bytes of rows are still processed 32 bits at a time.
+ * Buffers must not overlap.
+ * @param dst Destination buffer.
+ * @param dst_pitch Number of pixels from the start of a destination row to the next one.
+ * @param dst_x Left column of the rectangle in the destination.
+ * @param dst_y Top row of the rectangle in the destination.
+ * @param src Source buffer.
+ * @param src_pitch Number of pixels from the start of a source row to the next one.
+ * @param src_x Left column of the rectangle in the source.
+ * @param src_y Top row of the rectangle in the source.
+ * @param w Width of the rectangle.
+ * @param h Height of the rectangle.
+ * @param op Blend operation.
+ */
+void blit_bits(uint8_t* dst, uint32_t dst_pitch, uint16_t dst_x, uint16_t dst_y,
+               const uint8_t* src, uint32_t src_pitch, uint16_t src_x, uint16_t src_y,
+               uint16_t w, uint16_t h, BlendOp op);
+
+/**
+ * @class Compositor
+ * @brief Stack of layers composed into a single canvas.
+ *
+ * Layer 0 is the background, overlays are added above it and blended by their operation.
+ * Static content can stay in the background while overlays are redrawn, and only
+ * the changed rectangle is composed again.
+ *
+ * Usage example:
+ * @code
+ * EinkCanvas::Compositor layers(200, 200);
+ * uint8_t clock = layers.add_layer(EinkCanvas::BlendOp::AND);
+ * layers.layer(0)->fillCircle(100, 100, 90, 0);      // background
+ * layers.layer(clock)->fillScreen(1);                 // transparent for AND
+ * layers.layer(clock)->drawLine(100, 100, 100, 20, 0);
+ * layers.compose(canvas.getBuffer(), 0, 0, 199, 199);
+ * @endcode
+ */
+class Compositor {
+public:
+    /**
+     * @brief Construct compositor with background layer only.
+     * @param width Width of the layers in pixels.
+     * @param height Height of the layers in pixels.
+     */
+    Compositor(uint16_t width, uint16_t height);
+
+    ~Compositor();
+
+    Compositor(const Compositor&) = delete;
+    Compositor& operator=(const Compositor&) = delete;
+
+    /**
+     * @brief Add overlay above all layers, it is filled with pixels transparent for the operation.
+     * @param op Blend operation of the layer.
+     * @return Index of the new layer, 0 if there are already M_MAX_LAYERS layers.
+     */
+    uint8_t add_layer(BlendOp op);
+
+    /**
+     * @brief Get canvas of the layer for drawing.
+     * @param index Index of the layer, 0 is the background.
+     * @return Pointer to the canvas, nullptr for invalid index.
+     */
+    GFXCanvasBW* layer(uint8_t index) {
+        return index < m_count ? m_layers[index].canvas : nullptr;
+    }
+
+    /**
+     * @brief Set blend operation of the layer, it has no effect on the background.
+     * @param index Index of the layer.
+     * @param op Blend operation.
+     */
+    void set_op(uint8_t index, BlendOp op);
+
+    /**
+     * @brief Show or hide the layer, background is always visible.
+     * @param index Index of the layer.
+     * @param visible true to show the layer.
+     */
+    void set_visible(uint8_t index, bool visible);
+
+    /**
+     * @brief Fill background with the color and make overlays transparent.
+     * @param color Color of the background.
+     */
+    void clear(uint16_t color);
+
+    /**
+     * @brief Compose visible layers into the buffer, only inside of the rectangle.
+     * @param dst Buffer of the same size as layers.
+     * @param x0 Left column of the rectangle.
+     * @param y0 Top row of the rectangle.
+     * @param x1 Right column of the rectangle, inclusive.
+     * @param y1 Bottom row of the rectangle, inclusive.
+     */
+    void compose(uint8_t* dst, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) const;
+
+    /**
+     * @brief Get number of layers including the background.
+     * @return The number of layers.
+     */
+    uint8_t count() const {
+        return m_count;
+    }
+
+    /// Maximal number of layers including the background
+    static constexpr uint8_t M_MAX_LAYERS = 4;
+
+private:
+    struct Layer {
+        GFXCanvasBW* canvas;
+        BlendOp op;
+        bool visible;
+    };
+
+    /**
+     * @brief Get value of pixels which do not change anything below the layer.
+     */
+    static uint16_t transparent_color(BlendOp op);
+
+    uint16_t m_width;
+    uint16_t m_height;
+    uint8_t m_count = 0;
+    Layer m_layers[M_MAX_LAYERS];
+};
+
+} // namespace EinkCanvas
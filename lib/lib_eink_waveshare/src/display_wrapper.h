@@ -1,87 +1,41 @@
 #pragma once
 
 #include <Arduino.h>
+#include <algorithm>
 #include <type_traits>
 
-#include <Adafruit_GFX.h>
-
+#include "canvas_bw.h"
 #include "spi_controller.h"
 #include "my_utils.h"
 #include "eink_driver.h"
+#include "frame_store.h"
+#include "tile_hashes.h"
+#include "text_format.h"
+#include "text_layout.h"
+#include "refresh_profiler.h"
+#include "dithering.h"
+#include "image_decoder.h"
+#include "compositor.h"
+#include "pixel_convert.h"
+#include "time_plot.h"
+#include "draw_log.h"
+#include "draw_queue.h"
+#include "frame_stream.h"
+#include "surface_arena.h"
 
 
-namespace EinkCanvas{
+namespace EinkDisplay{
 
 /**
- * @class GFXCanvasBW
- * @brief Black and white canvas implementation for Adafruit GFX library
- * 
- * GFXCanvasBW provides a memory buffer-based black and white drawing surface 
- * where each pixel is represented by a single bit (1-bit per pixel). This allows
- * for memory-efficient display buffers for monochrome displays.
- * 
- * The class inherits from Adafruit_GFX, providing all standard drawing primitives
- * while implementing the pixel-specific operations for a 1-bit per pixel buffer.
- * 
- * @note The buffer is organized with 8 pixels per byte. The bits within each byte
- *       are ordered from most significant bit (leftmost pixel) to least significant bit.
+ * @brief Refresh requested from DisplayHandle::display_frame().
  */
-class GFXCanvasBW : public Adafruit_GFX {
-public:
-    /**
-     * @brief Construct a new black and white canvas
-     * 
-     * @param w Width of the canvas in pixels
-     * @param h Height of the canvas in pixels
-     */
-    GFXCanvasBW(uint16_t w, uint16_t h): Adafruit_GFX(w, h) {
-        buffer = new uint8_t[(w * h + 7) / 8];
-        memset(buffer, 0, (w * h + 7) / 8);
-    }
-
-    ~GFXCanvasBW() {
-        delete[] buffer;
-    }
-
-    /**
-     * @brief Draw a pixel at the specified coordinates
-     * 
-     * @param x X coordinate
-     * @param y Y coordinate
-     * @param color Pixel color (any non-zero value is treated as "on")
-     * @note The function handles bounds checking and will not draw outside the canvas
-     */
-    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
-        if ((x < 0) || (x >= width()) || (y < 0) || (y >= height())) return;
-        int byteIndex = x + y * width();
-        int bit = 7 - (byteIndex % 8);
-        byteIndex /= 8;
-
-        if (color)
-            buffer[byteIndex] |= (1 << bit);
-        else
-            buffer[byteIndex] &= ~(1 << bit);
-    }
-
-    /**
-     * @brief Get the internal pixel buffer
-     * 
-     * @return Pointer to the raw pixel buffer
-     * @note Each byte contains 8 pixels, with the MSB representing the leftmost pixel
-     */
-    uint8_t *getBuffer() {
-        return buffer;
-    }
-
-private:
-    uint8_t *buffer;
+enum class RefreshMode : uint8_t {
+    AUTO,    ///< Full or partial refresh chosen by thresholds and number of partial refreshes
+    FULL,    ///< Full refresh, even if nothing changed
+    PARTIAL, ///< Partial refresh
+    FAST     ///< Fast partial refresh with lower quality, e.g. for rapidly changing counters
 };
 
-} // namespace EinkCanvas
-
-
-namespace EinkDisplay{
-
 template <
     typename DriverType,
     typename = typename std::enable_if<
@@ -123,68 +77,264 @@ public:
      * @param dc Data/command pin for SPI communication
      * @param rst Reset pin for the display
      * @param busy Busy signal pin for the display
-     * @param refresh_threshold Ratio (0.0-1.0) of screen change that triggers a full refresh instead of partial
+     * @param refresh_threshold Ratio (0.0-1.0) of changed area of the screen that triggers a full refresh
+     *        instead of partial. It is kept until calibration from measured refresh times finds
+     *        the area where full refresh gets cheaper, see set_auto_threshold().
      * @param refresh_number Number of refreshes before forcing a full refresh
      * 
-     * @note The constructor initializes an internal canvas of 200x200 pixels and calculates
-     *       refresh thresholds based on the display dimensions.
+     * @note The constructor initializes an internal canvas of the display size and calculates
+     *       refresh threshold based on the display dimensions.
      */
     DisplayHandle(uint8_t cs, uint8_t dc, uint8_t rst, uint8_t busy, float refresh_threshold = 0.7, uint8_t refresh_number = 10) :
         m_spi(cs, dc), m_driver(rst, busy, m_spi), m_refresh_threshold(refresh_number), m_refresh_number(0) {
-        m_canvas = new EinkCanvas::GFXCanvasBW(200, 200);
+        m_canvas = new EinkCanvas::GFXCanvasBW(m_driver.get_width(), m_driver.get_height());
+        m_target = m_canvas;
+        m_tiles = new EinkDisplay::TileHashes(m_driver.get_width(), m_driver.get_height());
         m_canvas->fillScreen(EinkColor::WHITE.value());
-        full_refresh_threshold_height = m_driver.get_height() * refresh_threshold;
-        full_refresh_threshold_width = m_driver.get_width() * refresh_threshold;
+        m_full_refresh_area = display_area() * refresh_threshold;
         reset_bounding_box();
     }
 
     ~DisplayHandle() {
+        delete m_layers;
         delete m_canvas;
+        delete m_tiles;
+        delete m_ditherer;
     }
 
     /**
      * @brief Clears the entire e-ink display frame with a specified color.
      * 
      * This function performs a full refresh of the display, filling it with the
-     * specified color (white by default)
+     * specified color (white by default). IL3829 keeps two memory areas and switches
+     * to the other one with every refresh, so the color is written again after the
+     * refresh. The second write needs no refresh of its own, the screen already shows it.
      * @param color The color to fill the display with, defaults to WHITE
      */
     void clear_frame(EinkColor color = EinkColor::WHITE) {
+        trace::log(trace::Event::CLEAR, color.value());
+        record(EinkDisplay::DrawCall::CLEAR_FRAME, {color.value()});
         m_canvas->fillScreen(color.value());
+        if (m_layers != nullptr) {
+            m_layers->clear(color.value());
+        }
         reset_bounding_box();
         m_refresh_number = 0;
 
-        m_driver.init(false);
+        m_driver.init(EinkDriver::Waveform::FULL);
+        const uint32_t start = micros();
         m_driver.clear_frame(color);
+        const uint32_t upload_time = micros() - start;
         m_driver.display_frame();
-
+        m_profiler.record(EinkDriver::Waveform::FULL, display_area(), display_area(), upload_time, m_driver.get_busy_time());
         m_driver.clear_frame(color);
-        m_driver.display_frame();
         m_driver.sleep();
+        m_tiles->rehash(m_canvas->getBuffer());
+        save_frame();
     }
     
     /**
      * @brief Displays the current frame on the e-ink display.
      * 
-     * This function checks if a full refresh is needed based on the bounding box
-     * and refresh thresholds. It then sends the frame buffer to the display.
+     * The bounding box is first shrunk to the tiles whose content really changed since
+     * the last update, if nothing changed the display is not refreshed at all.
+     * This function then checks if a full refresh is needed based on the changed area
+     * and refresh thresholds. It then sends the frame buffer to the display. Partial refresh
+     * uploads changed tiles in up to M_MAX_WINDOWS windows, so distant changes do not
+     * upload everything between them.
+     * If content of the display is not known (clear_frame() was not called), full refresh is done.
+     * @param mode Requested refresh, decisions above are made only for RefreshMode::AUTO.
+     *        Partial and fast refreshes count towards the periodic full refresh.
      */
-    void display_frame() {
-        if (bounding_above_threshold() || m_refresh_number >= m_refresh_threshold) {
-            debug::Print("Full refresh.\n");
-            m_driver.init(false); // Full refresh
+    void display_frame(EinkDisplay::RefreshMode mode = EinkDisplay::RefreshMode::AUTO) {
+        record(EinkDisplay::DrawCall::DISPLAY_FRAME, {(int32_t)mode});
+        if (m_layers != nullptr) {
+            m_layers->compose(m_canvas->getBuffer(), m_min_bounding_box_x, m_min_bounding_box_y,
+                              m_max_bounding_box_x, m_max_bounding_box_y);
+        }
+        const bool changed = !m_tiles->is_valid() ||
+            m_tiles->update(m_canvas->getBuffer(), m_min_bounding_box_x, m_min_bounding_box_y,
+                            m_max_bounding_box_x, m_max_bounding_box_y);
+        if (!changed && mode != EinkDisplay::RefreshMode::FULL) {
+            trace::log(trace::Event::UNCHANGED);
+            reset_bounding_box();
+            return;
+        }
+
+        EinkDriver::Window windows[M_MAX_WINDOWS + 1];
+        uint8_t count = 0;
+        uint32_t area = display_area();
+        if (m_tiles->is_valid() && changed) {
+            count = plan_windows(windows);
+            area = windows_area(windows, count);
+        }
+
+        bool full_refresh = !m_tiles->is_valid();
+        if (mode == EinkDisplay::RefreshMode::FULL) {
+            full_refresh = true;
+        } else if (mode == EinkDisplay::RefreshMode::AUTO) {
+            full_refresh = full_refresh || area > m_full_refresh_area || m_refresh_number >= m_refresh_threshold;
+        }
+
+        EinkDriver::Waveform waveform;
+        uint32_t start;
+        if (full_refresh) {
+            waveform = EinkDriver::Waveform::FULL;
+            trace::log(trace::Event::REFRESH, (uint8_t)waveform, 0, 0, m_canvas->width() - 1, m_canvas->height() - 1);
+            area = display_area();
+            m_driver.init(waveform);
             m_refresh_number = 0;
+            start = micros();
             m_driver.set_frame_memory(m_canvas->getBuffer());
+            m_tiles->rehash(m_canvas->getBuffer());
         } else {
-            debug::Print("Partial refresh.\n");
-            m_driver.init(true); // Partial refresh
+            waveform = mode == EinkDisplay::RefreshMode::FAST ? EinkDriver::Waveform::FAST : EinkDriver::Waveform::PARTIAL;
+            trace::log(trace::Event::REFRESH, (uint8_t)waveform, m_min_bounding_box_x, m_min_bounding_box_y,
+                       m_max_bounding_box_x, m_max_bounding_box_y);
+            m_driver.init(waveform);
             m_refresh_number++;
-            m_driver.set_frame_memory(m_canvas->getBuffer(), m_min_bounding_box_x, m_min_bounding_box_y,
-                                              m_max_bounding_box_x, m_max_bounding_box_y);
+            start = micros();
+            m_driver.set_frame_memory(m_canvas->getBuffer(), windows, count);
         }
+        const uint32_t upload_time = micros() - start;
         m_driver.display_frame();
         m_driver.sleep();
         reset_bounding_box();
+        save_frame();
+
+        m_profiler.record(waveform, area, display_area(), upload_time, m_driver.get_busy_time());
+        if (m_auto_threshold) {
+            m_profiler.crossover_area(display_area(), m_refresh_threshold, m_full_refresh_area);
+        }
+    }
+
+    /**
+     * @brief Sets how long following drawing may wait for the display update.
+     *
+     * Every drawing operation sets a deadline, the earliest deadline of pending changes is
+     * kept. flush_due() refreshes the display only when the deadline passed, and all changes
+     * pending at that moment are shown by the same refresh. So drawing which can wait, e.g.
+     * a status bar updated every minute with delay of a minute, joins refreshes of more
+     * urgent drawing and never costs its own refresh.
+     *
+     * Usage example:
+     * @code
+     * display.set_update_delay(60000);
+     * draw_status_bar();  // Shown with the next clock update, at latest in a minute
+     * display.set_update_delay(0);
+     * draw_clock();       // Due immediately
+     * display.flush_due();
+     * @endcode
+     * @param delay_ms Maximal delay of the update in milliseconds, 0 by default.
+     */
+    void set_update_delay(uint32_t delay_ms) {
+        m_update_delay = delay_ms;
+    }
+
+    /**
+     * @brief Updates the display if the deadline of pending changes passed.
+     * @param mode Requested refresh, see display_frame().
+     * @return true if the display was updated, false if nothing is due yet.
+     */
+    bool flush_due(EinkDisplay::RefreshMode mode = EinkDisplay::RefreshMode::AUTO) {
+        if (!m_update_pending || (int32_t)(millis() - m_deadline) < 0) {
+            return false;
+        }
+        display_frame(mode);
+        return true;
+    }
+
+    /**
+     * @brief Get time remaining until pending changes are due, e.g. to sleep until then.
+     * @return Time in milliseconds, 0 if changes are already due, UINT32_MAX if nothing is pending.
+     */
+    uint32_t get_time_to_deadline() const {
+        if (!m_update_pending) {
+            return UINT32_MAX;
+        }
+        const int32_t remaining = (int32_t)(m_deadline - millis());
+        return remaining > 0 ? remaining : 0;
+    }
+
+    /**
+     * @brief Enables or disables calibration of the full refresh threshold.
+     *
+     * Every refresh is measured by the profiler, see get_profiler(). With calibration enabled,
+     * area of changes from which full refresh is done is set to the point where partial refresh
+     * including its share of the periodic full refresh gets more expensive than full refresh.
+     * Until such area is measured, threshold given to the constructor is kept. Enabled by default.
+     * @param enabled true to calibrate the threshold, false to keep it.
+     */
+    void set_auto_threshold(bool enabled) {
+        m_auto_threshold = enabled;
+    }
+
+    /**
+     * @brief Get area of changes from which full refresh is done.
+     * @return The area in pixels.
+     */
+    uint32_t get_full_refresh_area() const {
+        return m_full_refresh_area;
+    }
+
+    /**
+     * @brief Get measurements of refreshes done so far.
+     * @return Reference to the profiler.
+     */
+    const EinkDisplay::RefreshProfiler& get_profiler() const {
+        return m_profiler;
+    }
+
+    /**
+     * @brief Sets temperature of the display, waveform timing is chosen according to it.
+     * @param celsius Temperature in degrees Celsius, e.g. from a sensor next to the display.
+     */
+    void set_temperature(int8_t celsius) {
+        m_driver.set_temperature(celsius);
+    }
+
+    /**
+     * @brief Sets storage keeping the displayed frame across deep sleep.
+     *
+     * Every displayed frame is saved into the store. After wake up call restore_frame()
+     * instead of clear_frame().
+     * @param store Pointer to the frame store, nullptr disables storing. Store has to outlive the handle.
+     */
+    void set_frame_store(EinkDisplay::FrameStore* store) {
+        m_frame_store = store;
+    }
+
+    /**
+     * @brief Restores the last displayed frame from the frame store after wake up.
+     *
+     * Restored frame is loaded into the canvas, so drawing can continue where it ended.
+     * Next display_frame() compares the canvas with restored frame tile by tile and refreshes
+     * only the tiles which differ, or nothing if both frames are same. This holds even if
+     * the canvas is cleared and redrawn completely.
+     * @return true if the frame was restored, false if there is no valid frame. Then the display
+     *         should be cleared by clear_frame().
+     */
+    bool restore_frame() {
+        if (m_frame_store == nullptr) {
+            debug::Print("Frame store is not set.\n");
+            return false;
+        }
+        if (!m_frame_store->load(m_canvas->getBuffer(), frame_size(), m_refresh_number)) {
+            m_canvas->fillScreen(EinkColor::WHITE.value());
+            m_tiles->invalidate();
+            reset_bounding_box();
+            return false;
+        }
+        m_tiles->rehash(m_canvas->getBuffer());
+        if (m_layers != nullptr) {
+            m_layers->clear(EinkColor::WHITE.value());
+            memcpy(m_layers->layer(0)->getBuffer(), m_canvas->getBuffer(), frame_size());
+            // Canvas is overwritten by composition, drawing continues in the background
+            m_target = m_layers->layer(0);
+            m_target->setFont(m_font);
+        }
+        mark_all_dirty();
+        return true;
     }
 
     /**
@@ -195,8 +345,9 @@ public:
      * @param color The color of the pixel.
      */
     void draw_pixel(int16_t x, int16_t y, EinkColor color) {
-        update_bounding_box(x, y);
-        m_canvas->drawPixel(x, y, color.value());
+        record(EinkDisplay::DrawCall::PIXEL, {x, y, color.value()});
+        mark_dirty(x, y, x, y);
+        m_target->drawPixel(x, y, color.value());
     }
 
     /**
@@ -209,9 +360,9 @@ public:
      * @param color The color of the line.
      */
     void draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, EinkColor color) {
-        update_bounding_box(x0, y0);
-        update_bounding_box(x1, y1);
-        m_canvas->drawLine(x0, y0, x1, y1, color.value());
+        record(EinkDisplay::DrawCall::LINE, {x0, y0, x1, y1, color.value()});
+        mark_dirty(std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1));
+        m_target->drawLine(x0, y0, x1, y1, color.value());
     }
 
     /**
@@ -224,9 +375,9 @@ public:
      * @param color The color of the rectangle.
      */
     void draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, EinkColor color) {
-        update_bounding_box(x, y);
-        update_bounding_box(x + w, y + h);
-        m_canvas->drawRect(x, y, w, h, color.value());
+        record(EinkDisplay::DrawCall::RECT, {x, y, w, h, color.value()});
+        mark_dirty(x, y, x + w - 1, y + h - 1);
+        m_target->drawRect(x, y, w, h, color.value());
     }
 
     /**
@@ -239,9 +390,9 @@ public:
      * @param color The color of the rectangle.
      */
     void fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, EinkColor color) {
-        update_bounding_box(x, y);
-        update_bounding_box(x + w, y + h);
-        m_canvas->fillRect(x, y, w, h, color.value());
+        record(EinkDisplay::DrawCall::FILL_RECT, {x, y, w, h, color.value()});
+        mark_dirty(x, y, x + w - 1, y + h - 1);
+        m_target->fillRect(x, y, w, h, color.value());
     }
 
     /**
@@ -253,9 +404,9 @@ public:
      * @param color The color of the circle.
      */
     void draw_circle(int16_t x0, int16_t y0, int16_t r, EinkColor color) {
-        update_bounding_box(x0 - r, y0 - r);
-        update_bounding_box(x0 + r, y0 + r);
-        m_canvas->drawCircle(x0, y0, r, color.value());
+        record(EinkDisplay::DrawCall::CIRCLE, {x0, y0, r, color.value()});
+        mark_dirty(x0 - r, y0 - r, x0 + r, y0 + r);
+        m_target->drawCircle(x0, y0, r, color.value());
     }
 
     /**
@@ -267,18 +418,346 @@ public:
      * @param color The color of the circle.
      */
     void fill_circle(int16_t x0, int16_t y0, int16_t r, EinkColor color) {
-        update_bounding_box(x0 - r, y0 - r);
-        update_bounding_box(x0 + r, y0 + r);
-        m_canvas->fillCircle(x0, y0, r, color.value());
+        record(EinkDisplay::DrawCall::FILL_CIRCLE, {x0, y0, r, color.value()});
+        mark_dirty(x0 - r, y0 - r, x0 + r, y0 + r);
+        m_target->fillCircle(x0, y0, r, color.value());
+    }
+
+    /**
+     * @brief Scrolls content of a rectangle in place, e.g. for log tails and message feeds.
+     *
+     * Content is shifted inside of the canvas, exposed strip is filled with the background,
+     * so only new content has to be drawn into it afterwards.
+     *
+     * Usage example:
+     * @code
+     * display.scroll_region(0, 20, 200, 180, 0, -line_height);
+     * display.print(0, 200 - line_height, EinkColor::BLACK, message);
+     * @endcode
+     * @param x The x-coordinate of the top-left corner.
+     * @param y The y-coordinate of the top-left corner.
+     * @param w The width of the rectangle.
+     * @param h The height of the rectangle.
+     * @param dx Horizontal shift, positive moves content to the right.
+     * @param dy Vertical shift, positive moves content down.
+     * @param background The color of the exposed strip.
+     */
+    void scroll_region(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx, int16_t dy,
+                       EinkColor background = EinkColor::WHITE) {
+        if (dx == 0 && dy == 0) {
+            return;
+        }
+        record(EinkDisplay::DrawCall::SCROLL, {x, y, w, h, dx, dy, background.value()});
+        mark_dirty(x, y, x + w - 1, y + h - 1);
+        m_target->scrollRect(x, y, w, h, dx, dy, background.value());
+    }
+
+    /**
+     * @brief Draws whole plot, its area is cleared first.
+     *
+     * @param plot The plot to draw.
+     * @param color The color of the plot.
+     * @param background The color of the plot area.
+     */
+    void draw_plot(const EinkCanvas::TimePlot& plot, EinkColor color, EinkColor background = EinkColor::WHITE) {
+        fill_rect(plot.x(), plot.y(), plot.width(), plot.height(), background);
+        plot.draw(*m_target, color.value());
+        record_rows(plot.x(), plot.y(), plot.width(), plot.height());
+    }
+
+    /**
+     * @brief Appends a sample to the plot and draws only the changed column.
+     *
+     * When the sample starts a new column, the plot area is scrolled by one column
+     * to the left, otherwise the newest column is cleared and drawn again.
+     *
+     * Usage example:
+     * @code
+     * EinkCanvas::TimePlot temperature(0, 100, 200, 60, 15.0, 30.0, 800); // 4 samples per column
+     * display.draw_plot(temperature, EinkColor::BLACK);
+     * ...
+     * display.add_sample(temperature, read_temperature(), EinkColor::BLACK);
+     * display.display_frame();
+     * @endcode
+     * @param plot The plot the sample is appended to.
+     * @param value The value of the sample.
+     * @param color The color of the plot.
+     * @param background The color of the plot area.
+     */
+    void add_sample(EinkCanvas::TimePlot& plot, float value, EinkColor color, EinkColor background = EinkColor::WHITE) {
+        const int16_t column = plot.x() + plot.width() - 1;
+        if (plot.append(value)) {
+            scroll_region(plot.x(), plot.y(), plot.width(), plot.height(), -1, 0, background);
+        } else {
+            fill_rect(column, plot.y(), 1, plot.height(), background);
+        }
+        plot.draw_newest(*m_target, color.value());
+        record_rows(column, plot.y(), 1, plot.height());
+    }
+
+    /**
+     * @brief Fills a polygon, it may be concave or self-intersecting.
+     *
+     * Polygon is rasterized by an edge table into horizontal spans written directly into
+     * the canvas, and only its exact bounding box is marked as changed. Pixels with centers
+     * inside of the polygon are filled, areas wound several times are filled once.
+     *
+     * Usage example:
+     * @code
+     * const EinkCanvas::Point arrow[] = {{100, 20}, {130, 60}, {110, 60}, {110, 100}, {90, 100}, {90, 60}, {70, 60}};
+     * display.fill_polygon(arrow, 7, EinkColor::BLACK);
+     * @endcode
+     * @param points Vertices of the polygon.
+     * @param count Number of vertices.
+     * @param color The color to fill the polygon with.
+     */
+    void fill_polygon(const EinkCanvas::Point* points, uint16_t count, EinkColor color) {
+        if (points == nullptr) {
+            debug::Print("Points are null.\n");
+            return;
+        }
+        if (count < 3) {
+            return;
+        }
+        EinkCanvas::ScanlineRasterizer rasterizer(count);
+        rasterizer.add_polygon(points, count);
+        fill_rasterized(rasterizer, color);
+    }
+
+    /**
+     * @brief Draws a thick polyline, e.g. a gauge needle or a line chart.
+     *
+     * Segments have flat ends and are joined by bevels. Whole polyline is rasterized
+     * at once like fill_polygon(), so overlapping segments are filled once.
+     * @param points Vertices of the polyline.
+     * @param count Number of vertices.
+     * @param thickness The thickness of the line in pixels.
+     * @param color The color of the line.
+     */
+    void draw_polyline(const EinkCanvas::Point* points, uint16_t count, uint16_t thickness, EinkColor color) {
+        if (points == nullptr) {
+            debug::Print("Points are null.\n");
+            return;
+        }
+        if (count < 2 || thickness == 0) {
+            return;
+        }
+        EinkCanvas::ScanlineRasterizer rasterizer(EinkCanvas::ScanlineRasterizer::polyline_edges(count));
+        rasterizer.add_polyline(points, count, thickness);
+        fill_rasterized(rasterizer, color);
     }
 
     /**
-     * @brief Sets the rotation of the canvas.
+     * @brief Blits a pre-rendered surface, so cached content is shown without drawing it again.
      *
-     * @param r The rotation value (0-3).
+     * Surface is clipped by the viewport once, rows are then combined with the canvas
+     * 32 bits at a time and shifted when x is not a multiple of 8.
+     *
+     * Usage example:
+     * @code
+     * EinkCanvas::SurfaceArena arena(2048);
+     * EinkCanvas::Surface icon = arena.allocate(24, 24);
+     * EinkCanvas::GFXCanvasBW painter(icon.stride * 8, icon.height, icon.bits);
+     * painter.drawBitmap(0, 0, battery_icon, 24, 24, 0);
+     * display.blit(icon, 173, 3, EinkCanvas::BlendOp::AND);
+     * @endcode
+     * @param surface The surface to blit.
+     * @param x The x-coordinate of the top-left corner.
+     * @param y The y-coordinate of the top-left corner.
+     * @param op Operation combining the surface with the canvas, see EinkCanvas::BlendOp.
+     */
+    void blit(const EinkCanvas::Surface& surface, int16_t x, int16_t y,
+              EinkCanvas::BlendOp op = EinkCanvas::BlendOp::COPY) {
+        if (!surface.valid()) {
+            debug::Print("Surface is empty.\n");
+            return;
+        }
+        int16_t origin_x, origin_y;
+        m_target->getOrigin(origin_x, origin_y);
+        int16_t x0 = x, y0 = y, x1 = x + surface.width - 1, y1 = y + surface.height - 1;
+        if (!m_target->clipRect(x0, y0, x1, y1)) {
+            return;
+        }
+        EinkCanvas::blit_bits(m_target->getBuffer(), m_canvas->width(), x0, y0,
+                              surface.bits, surface.stride * 8, x0 - origin_x - x, y0 - origin_y - y,
+                              x1 - x0 + 1, y1 - y0 + 1, op);
+        update_bounding_box(x0, y0);
+        update_bounding_box(x1, y1);
+        update_deadline();
+        record_rows(x, y, surface.width, surface.height);
+    }
+
+    /**
+     * @brief Copies a rectangle of the canvas into a surface, e.g. to restore background later.
+     *
+     * Parts of the surface outside of the viewport are not changed.
+     * @param surface The surface, its size is the size of the rectangle.
+     * @param x The x-coordinate of the top-left corner.
+     * @param y The y-coordinate of the top-left corner.
+     */
+    void capture(EinkCanvas::Surface& surface, int16_t x, int16_t y) const {
+        if (!surface.valid()) {
+            debug::Print("Surface is empty.\n");
+            return;
+        }
+        int16_t origin_x, origin_y;
+        m_target->getOrigin(origin_x, origin_y);
+        int16_t x0 = x, y0 = y, x1 = x + surface.width - 1, y1 = y + surface.height - 1;
+        if (!m_target->clipRect(x0, y0, x1, y1)) {
+            return;
+        }
+        EinkCanvas::blit_bits(surface.bits, surface.stride * 8, x0 - origin_x - x, y0 - origin_y - y,
+                              m_target->getBuffer(), m_canvas->width(), x0, y0,
+                              x1 - x0 + 1, y1 - y0 + 1, EinkCanvas::BlendOp::COPY);
+    }
+
+    /**
+     * @brief Sets the rotation of the display.
+     *
+     * Canvas always keeps unrotated byte layout of the rotated screen, so drawing stays
+     * without per pixel coordinate transform. Rotation is applied by the driver while
+     * uploading the frame. Content of the canvas is kept, but it will be shown in new
+     * orientation, so it should be redrawn. Next update of the display is a full refresh.
+     *
+     * @param r The rotation value (0-3), in steps of 90 degrees clockwise.
      */
     void set_rotation(uint8_t r) {
-        m_canvas->setRotation(r);
+        r &= 0x03;
+        record(EinkDisplay::DrawCall::ROTATION, {r});
+        m_driver.set_rotation(r);
+        const uint16_t width = (r & 1) ? m_driver.get_height() : m_driver.get_width();
+        const uint16_t height = (r & 1) ? m_driver.get_width() : m_driver.get_height();
+        if (width != m_canvas->width() || height != m_canvas->height()) {
+            delete m_canvas;
+            m_canvas = new EinkCanvas::GFXCanvasBW(width, height);
+            m_canvas->fillScreen(EinkColor::WHITE.value());
+            delete m_tiles;
+            m_tiles = new EinkDisplay::TileHashes(width, height);
+            m_target = m_canvas;
+            if (m_layers != nullptr) {
+                debug::Print("Layers are removed by change of the canvas size.\n");
+                delete m_layers;
+                m_layers = nullptr;
+            }
+        }
+        m_tiles->invalidate();
+        reset_bounding_box();
+        m_refresh_number = m_refresh_threshold;
+    }
+
+    /**
+     * @brief Adds a layer above the canvas content, drawing then goes into the selected layer.
+     *
+     * With the first layer, current content of the canvas becomes the background layer 0
+     * and drawing goes into it until another layer is selected.
+     * New layer is transparent for its blend operation. Layers are composed into the canvas
+     * by display_frame(), only inside of the area changed since the last update, so redrawing
+     * an overlay never requires redrawing the background.
+     *
+     * Usage example:
+     * @code
+     * uint8_t hands = display.add_layer(EinkCanvas::BlendOp::AND);
+     * display.select_layer(0);
+     * display.draw_circle(100, 100, 90, EinkColor::BLACK); // drawn once
+     * display.select_layer(hands);
+     * display.clear_buffer(); // white is transparent for AND
+     * display.draw_line(100, 100, 100, 20, EinkColor::BLACK);
+     * display.display_frame();
+     * @endcode
+     * @param op Blend operation of the layer.
+     * @return Index of the new layer, 0 if no more layers can be added.
+     */
+    uint8_t add_layer(EinkCanvas::BlendOp op) {
+        record(EinkDisplay::DrawCall::ADD_LAYER, {(int32_t)op});
+        if (m_layers == nullptr) {
+            m_layers = new EinkCanvas::Compositor(m_canvas->width(), m_canvas->height());
+            memcpy(m_layers->layer(0)->getBuffer(), m_canvas->getBuffer(), frame_size());
+            // Canvas is overwritten by composition, drawing continues in the background
+            m_target = m_layers->layer(0);
+            m_target->setFont(m_font);
+        }
+        return m_layers->add_layer(op);
+    }
+
+    /**
+     * @brief Selects layer for drawing, 0 is the background.
+     * @param index Index of the layer returned by add_layer().
+     */
+    void select_layer(uint8_t index) {
+        record(EinkDisplay::DrawCall::SELECT_LAYER, {index});
+        EinkCanvas::GFXCanvasBW* layer = m_layers != nullptr ? m_layers->layer(index) : nullptr;
+        if (layer == nullptr) {
+            debug::Print("Invalid layer.\n");
+            return;
+        }
+        m_target = layer;
+        m_target->setFont(m_font);
+    }
+
+    /**
+     * @brief Changes blend operation of the layer.
+     * @param index Index of the layer, background has no operation.
+     * @param op Blend operation.
+     */
+    void set_layer_op(uint8_t index, EinkCanvas::BlendOp op) {
+        record(EinkDisplay::DrawCall::LAYER_OP, {index, (int32_t)op});
+        if (m_layers == nullptr) {
+            debug::Print("No layers.\n");
+            return;
+        }
+        m_layers->set_op(index, op);
+        mark_all_dirty();
+    }
+
+    /**
+     * @brief Shows or hides the layer.
+     * @param index Index of the layer, background is always visible.
+     * @param visible true to show the layer.
+     */
+    void set_layer_visible(uint8_t index, bool visible) {
+        record(EinkDisplay::DrawCall::LAYER_VISIBLE, {index, visible});
+        if (m_layers == nullptr) {
+            debug::Print("No layers.\n");
+            return;
+        }
+        m_layers->set_visible(index, visible);
+        mark_all_dirty();
+    }
+
+    /**
+     * @brief Pushes a viewport, following drawing is translated to it and clipped by it.
+     *
+     * Viewports can be nested, e.g. a widget gets its own coordinates and cannot draw
+     * outside of its area. Viewport belongs to the selected layer.
+     *
+     * Usage example:
+     * @code
+     * display.push_viewport(0, 180, 200, 20); // Status bar
+     * display.fill_rect(0, 0, 200, 20, EinkColor::BLACK);
+     * display.print(2, 2, EinkColor::WHITE, "Battery 80%");
+     * display.pop_viewport();
+     * @endcode
+     * @param x The x-coordinate of the viewport in the current viewport.
+     * @param y The y-coordinate of the viewport in the current viewport.
+     * @param w The width of the viewport.
+     * @param h The height of the viewport.
+     * @return true if the viewport was pushed, false if too many viewports are nested.
+     */
+    bool push_viewport(int16_t x, int16_t y, int16_t w, int16_t h) {
+        record(EinkDisplay::DrawCall::PUSH_VIEWPORT, {x, y, w, h});
+        if (!m_target->pushViewport(x, y, w, h)) {
+            debug::Print("Too many nested viewports.\n");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Pops the last pushed viewport.
+     */
+    void pop_viewport() {
+        record(EinkDisplay::DrawCall::POP_VIEWPORT, {});
+        m_target->popViewport();
     }
 
     /**
@@ -287,7 +766,30 @@ public:
      * @param font Pointer to the GFXfont structure representing the font.
      */
     void set_font(const GFXfont* font) {
-        m_canvas->setFont(font);
+        if (m_recorder != nullptr) {
+            record(EinkDisplay::DrawCall::FONT, {m_recorder->font_index(font)});
+        }
+        m_font = font;
+        m_compact_font = nullptr;
+        m_metrics.set_font(font);
+        m_target->setFont(font);
+    }
+
+    /**
+     * @brief Sets compact font for text rendering, text is then UTF-8.
+     *
+     * Compact font keeps only needed codepoints with compressed glyphs, e.g. Latin Extended
+     * for localized texts. Glyphs are decoded while drawing, without allocation.
+     * Fonts are generated by tools/compact_font_convert.py.
+     *
+     * @param font The font, it has to outlive the handle.
+     */
+    void set_font(const EinkDisplay::CompactFont& font) {
+        record(EinkDisplay::DrawCall::FONT, {-2});
+        m_font = nullptr;
+        m_compact_font = &font;
+        m_metrics.set_font(font);
+        m_target->setFont(nullptr);
     }
 
     /**
@@ -312,6 +814,105 @@ public:
         print(x, y, color, buffer);
     }
 
+    /**
+     * @brief Prints typed fields on the canvas, without printf formatting.
+     *
+     * Fields are formatted into a stack buffer whose size is known at compile time,
+     * bounds are computed from glyph metrics of the font while the glyphs are drawn.
+     *
+     * Usage example:
+     * @code
+     * display.print_fields(70, 90, EinkColor::BLACK, EinkFormat::Time<>{hour, minute, second});
+     * display.print_fields(10, 30, EinkColor::BLACK, EinkFormat::Fixed<1>{temperature}, 'C');
+     * @endcode
+     * @param x The x-coordinate of the text.
+     * @param y The y-coordinate of the text.
+     * @param color The color of the text.
+     * @param fields Fields from EinkFormat namespace or characters.
+     */
+    template <typename... Fields>
+    void print_fields(int16_t x, int16_t y, EinkColor color, const Fields&... fields) {
+        static_assert(sizeof...(Fields) > 0, "At least one field is required");
+        char text[EinkFormat::max_length<Fields...>()];
+        uint16_t length = 0;
+        ((length += EinkFormat::format(text + length, fields)), ...);
+        draw_text(x, y, color, text, length);
+    }
+
+    /**
+     * @brief Prints text wrapped into a box on the canvas.
+     *
+     * Lines are broken at spaces, words wider than the box are broken at any character,
+     * '\n' starts a new line. Lines are aligned horizontally inside of the box, lines which
+     * do not fit into the box vertically are not drawn. Text is measured by precomputed
+     * metrics of the current font and laid out in a single pass.
+     *
+     * @param x The x-coordinate of the top-left corner of the box.
+     * @param y The y-coordinate of the top-left corner of the box.
+     * @param w The width of the box.
+     * @param h The height of the box.
+     * @param color The color of the text.
+     * @param text The text to be printed.
+     * @param align Horizontal alignment of lines.
+     * @return Pointer to the first character which did not fit into the box, end of the text if all fit.
+     */
+    const char* print_box(int16_t x, int16_t y, int16_t w, int16_t h, EinkColor color, const char* text,
+                          EinkDisplay::TextAlign align = EinkDisplay::TextAlign::LEFT) {
+        if(text == nullptr) {
+            debug::Print("Text is null.\n");
+            return nullptr;
+        }
+        int16_t baseline = y + m_metrics.ascent();
+        while (*text != '\0' && baseline + m_metrics.descent() <= y + h) {
+            const char* end = text;
+            const char* space = nullptr;
+            uint16_t width = 0;
+            uint16_t space_width = 0;
+            while (*end != '\0' && *end != '\n') {
+                if (*end == ' ') {
+                    space = end;
+                    space_width = width;
+                }
+                const char* next_char = end;
+                const uint8_t advance = m_metrics.advance(next_char);
+                if (width + advance > w && end != text) break;
+                width += advance;
+                end = next_char;
+            }
+
+            const char* next = end;
+            if (*end == '\n') {
+                next = end + 1;
+            } else if (*end != '\0') {
+                // Line is full, break at the last space if there is any
+                if (space != nullptr) {
+                    end = space;
+                    width = space_width;
+                }
+                next = end;
+                while (*next == ' ') next++;
+            }
+
+            int16_t offset = 0;
+            if (align == EinkDisplay::TextAlign::CENTER) offset = (w - width) / 2;
+            else if (align == EinkDisplay::TextAlign::RIGHT) offset = w - width;
+            draw_text(x + offset, baseline, color, text, end - text);
+
+            text = next;
+            baseline += m_metrics.line_height();
+        }
+        return text;
+    }
+
+    /**
+     * @brief Get width of the text in the current font.
+     * @param text The text to measure.
+     * @return Width of the text in pixels.
+     */
+    uint16_t get_text_width(const char* text) const {
+        return text == nullptr ? 0 : m_metrics.text_width(text, strlen(text));
+    }
+
     /**
      * @brief Prints text on the canvas.
      *
@@ -325,17 +926,21 @@ public:
             debug::Print("Text is null.\n");
             return;
         }
+        if (m_compact_font != nullptr) {
+            draw_text(x, y, color, text, strlen(text));
+            return;
+        }
+        record(EinkDisplay::DrawCall::PRINT, {x, y, color.value()}, (const uint8_t*)text, strlen(text));
         int16_t ul_x, ul_y;
         uint16_t w, h;
-        m_canvas->getTextBounds(text, x, y, &ul_x, &ul_y, &w, &h);
+        m_target->getTextBounds(text, x, y, &ul_x, &ul_y, &w, &h);
         if (x < 0) x = 0;
         if (y < 0) y = 0;
-        update_bounding_box(ul_x, ul_y);
-        update_bounding_box(ul_x + w, ul_y + h);
+        mark_dirty(ul_x, ul_y, ul_x + w - 1, ul_y + h - 1);
 
-        m_canvas->setTextColor(color.value());
-        m_canvas->setCursor(x, y);
-        m_canvas->print(text);
+        m_target->setTextColor(color.value());
+        m_target->setCursor(x, y);
+        m_target->print(text);
     }
 
     /**
@@ -354,9 +959,207 @@ public:
             debug::Print("Bitmap is null.\n");
             return;
         }
-        update_bounding_box(x, y);
-        update_bounding_box(x + w, y + h);
-        m_canvas->drawBitmap(x, y, bitmap, w, h, fw_color.value(), bg_color.value());
+        record(EinkDisplay::DrawCall::BITMAP, {x, y, w, h, fw_color.value(), bg_color.value()}, bitmap, (uint32_t)(w + 7) / 8 * h);
+        mark_dirty(x, y, x + w - 1, y + h - 1);
+        m_target->drawBitmap(x, y, bitmap, w, h, fw_color.value(), bg_color.value());
+    }
+
+    /**
+     * @brief Draws a grayscale image on the canvas, converted to black and white by dithering.
+     *
+     * Image is requested row by row, so it can be generated or read from a file without
+     * keeping the whole image in memory. The ditherer with a single gray row and error rows
+     * is allocated by the first call for rows as long as the longer side of the display,
+     * later calls reuse it.
+     *
+     * Usage example:
+     * @code
+     * display.draw_grayscale(0, 0, 200, 50, EinkCanvas::DitherMethod::FLOYD_STEINBERG,
+     *     [](uint16_t row, uint8_t* gray) {
+     *         for (uint16_t x = 0; x < 200; x++) gray[x] = x + row; // gradient
+     *     });
+     * @endcode
+     * @param x The x-coordinate of the top-left corner.
+     * @param y The y-coordinate of the top-left corner.
+     * @param w The width of the image, at most the longer side of the display, wider images are not drawn.
+     * @param h The height of the image.
+     * @param method Dithering method.
+     * @param source Callable void(uint16_t row, uint8_t* gray) filling w gray values of the row,
+     *        0 is black and 255 is white.
+     */
+    template <typename RowSource>
+    void draw_grayscale(int16_t x, int16_t y, uint16_t w, uint16_t h, EinkCanvas::DitherMethod method, RowSource&& source) {
+        if (w == 0 || h == 0) {
+            return;
+        }
+        if (m_ditherer == nullptr) {
+            // Rows as long as the display fit in every rotation
+            m_ditherer = new EinkCanvas::Ditherer(std::max(m_driver.get_width(), m_driver.get_height()));
+        }
+        if (!m_ditherer->start(method, w)) {
+            return;
+        }
+        for (uint16_t row = 0; row < h; row++) {
+            source(row, m_ditherer->row());
+            m_target->writeRow(x, y + row, m_ditherer->dither_row(), w);
+        }
+        mark_dirty(x, y, x + w - 1, y + h - 1);
+        record_rows(x, y, w, h);
+    }
+
+    /**
+     * @brief Draws a black and white image from a file, e.g. on LittleFS.
+     *
+     * Supported formats are binary PBM (P4) and uncompressed 1-bit BMP. Image is decoded
+     * in small chunks directly into the canvas, so it never has to fit into memory.
+     * Parts of the image outside of the canvas are skipped.
+     * @param fs Filesystem with the image.
+     * @param path Path of the image file.
+     * @param x The x-coordinate of the top-left corner.
+     * @param y The y-coordinate of the top-left corner.
+     * @return true if the whole image was drawn, false if the file is missing, not supported
+     *         or truncated. Truncated image is drawn partially.
+     */
+    bool draw_image(fs::FS& fs, const char* path, int16_t x, int16_t y) {
+        fs::File file = fs.open(path, "r");
+        if (!file) {
+            debug::Print("Cannot open image file.\n");
+            return false;
+        }
+        EinkDisplay::ImageDecoder decoder(file);
+        if (!decoder.read_header()) {
+            file.close();
+            return false;
+        }
+        EinkDisplay::ImageChunk chunk;
+        while (decoder.next_chunk(chunk)) {
+            m_target->writeRow(x + chunk.x, y + chunk.row, chunk.bits, chunk.width);
+        }
+        file.close();
+        mark_dirty(x, y, x + decoder.width() - 1, y + decoder.height() - 1);
+        record_rows(x, y, decoder.width(), decoder.height());
+        return decoder.is_complete();
+    }
+
+    /**
+     * @brief Writes a rectangle of pixels rendered by another graphics library.
+     *
+     * Pixels are converted to black and white by threshold and written into the canvas,
+     * the area is merged into changed area of the display. This fits flush callbacks of
+     * libraries with their own partial rendering, e.g. LVGL.
+     *
+     * Usage example:
+     * @code
+     * void flush_cb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* pixels) {
+     *     display.push_pixels(area->x1, area->y1, area->x2 - area->x1 + 1, area->y2 - area->y1 + 1,
+     *                         EinkCanvas::PixelFormat::RGB565, pixels);
+     *     if (lv_disp_flush_is_last(drv)) display.display_frame();
+     *     lv_disp_flush_ready(drv);
+     * }
+     * @endcode
+     * @param x The x-coordinate of the top-left corner.
+     * @param y The y-coordinate of the top-left corner.
+     * @param w The width of the rectangle.
+     * @param h The height of the rectangle.
+     * @param format Format of the pixels.
+     * @param pixels Pixels of the rectangle, rows follow each other.
+     * @param stride Distance between rows in bytes, 0 if rows are not padded.
+     * @param threshold Gray level or luma from which pixels are white, not used for EinkCanvas::PixelFormat::MONO.
+     */
+    void push_pixels(int16_t x, int16_t y, uint16_t w, uint16_t h, EinkCanvas::PixelFormat format,
+                     const void* pixels, uint32_t stride = 0, uint8_t threshold = 128) {
+        if (pixels == nullptr) {
+            debug::Print("Pixels are null.\n");
+            return;
+        }
+        if (w == 0 || h == 0) {
+            return;
+        }
+        if (stride == 0) {
+            stride = EinkCanvas::row_size(format, w);
+        }
+        const uint8_t* row = static_cast<const uint8_t*>(pixels);
+        // Row of the canvas fits the buffer, wider rows are converted in pieces
+        uint8_t bits[M_PUSH_ROW_SIZE];
+        const uint16_t piece = M_PUSH_ROW_SIZE * 8;
+        const uint8_t pixel_size = format == EinkCanvas::PixelFormat::GRAY8 ? 1 : 2;
+        for (uint16_t i = 0; i < h; i++, row += stride) {
+            if (format == EinkCanvas::PixelFormat::MONO) {
+                m_target->writeRow(x, y + i, row, w);
+                continue;
+            }
+            for (uint32_t start = 0; start < w && x + (int32_t)start <= INT16_MAX; start += piece) {
+                const uint16_t count = std::min<uint32_t>(piece, w - start);
+                const uint8_t* pixel = row + start * pixel_size;
+                switch (format) {
+                case EinkCanvas::PixelFormat::GRAY8:
+                    EinkCanvas::pack_gray8(pixel, count, threshold, bits);
+                    break;
+                default:
+                    EinkCanvas::pack_rgb565(pixel, count, threshold, format == EinkCanvas::PixelFormat::RGB565_SWAPPED, bits);
+                    break;
+                }
+                m_target->writeRow(x + start, y + i, bits, count);
+            }
+        }
+        mark_dirty(x, y, x + w - 1, y + h - 1);
+        record_rows(x, y, w, h);
+    }
+
+    /**
+     * @brief Applies frames streamed from a host, it does not block.
+     *
+     * Host renders whole frames and sends only XOR deltas of changed tiles, which are applied
+     * directly into the canvas, respectively the selected layer. Only the tiles are marked
+     * as changed. Display is updated when the frame is complete. Canvas on the host has
+     * the size of the rotated canvas and its width has to be a multiple of 8.
+     *
+     * Usage example:
+     * @code
+     * EinkDisplay::FrameReceiver receiver(Serial);
+     * void loop() {
+     *     display.receive_frames(receiver);
+     * }
+     * @endcode
+     * @param receiver The receiver of the stream.
+     * @return true if the display was updated.
+     */
+    bool receive_frames(EinkDisplay::FrameReceiver& receiver) {
+        if (m_canvas->width() % 8 != 0) {
+            debug::Print("Canvas width is not a multiple of 8.\n");
+            return false;
+        }
+        EinkDisplay::Packet packet;
+        bool updated = false;
+        while (receiver.poll(packet)) {
+            switch (packet.type) {
+            case EinkDisplay::PacketType::TILE: {
+                uint16_t x0, y0, x1, y1;
+                if (!EinkDisplay::apply_tile(packet.payload, packet.length, m_target->getBuffer(),
+                                             m_canvas->width() / 8, m_canvas->height(), x0, y0, x1, y1)) {
+                    receiver.acknowledge(false);
+                    break;
+                }
+                update_bounding_box(x0, y0);
+                update_bounding_box(x1, y1);
+                update_deadline();
+                break;
+            }
+            case EinkDisplay::PacketType::RESET:
+                clear_buffer(color_of(packet.length > 0 ? packet.payload[0] : EinkColor::WHITE.value()));
+                break;
+            case EinkDisplay::PacketType::END:
+                display_frame(packet.length > 0 ? (EinkDisplay::RefreshMode)packet.payload[0] : EinkDisplay::RefreshMode::AUTO);
+                receiver.acknowledge(true);
+                updated = true;
+                break;
+            default:
+                debug::Print("Unknown packet.\n");
+                receiver.acknowledge(false);
+                break;
+            }
+        }
+        return updated;
     }
 
     /**
@@ -368,14 +1171,16 @@ public:
     }
 
     /**
-     * @brief Set the internal canvas to a specific color.
-     * This will also reset the bounding box of canvas.
+     * @brief Set the internal canvas, respectively the selected layer, to a specific color.
+     * Whole canvas is marked as changed, but only tiles which really differ from the display
+     * after redrawing will be refreshed.
      * Nothing will be drawn on the display. This just resets the canvas.
      * @param color The color to fill the canvas with.
      */
     void clear_buffer(EinkColor color = EinkColor::WHITE) {
-        m_canvas->fillScreen(EinkColor::WHITE.value());
-        reset_bounding_box();
+        record(EinkDisplay::DrawCall::CLEAR_BUFFER, {color.value()});
+        m_target->fillScreen(color.value());
+        mark_all_dirty();
     }
 
     /**
@@ -383,7 +1188,7 @@ public:
      * @return The width of the canvas in pixels.
      */
     uint16_t get_canvas_width() const {
-        return m_driver.get_width();
+        return m_canvas->width();
     }
 
     /**
@@ -391,29 +1196,503 @@ public:
      * @return The height of the canvas in pixels.
      */
     uint16_t get_canvas_height() const {
-        return m_driver.get_height();
+        return m_canvas->height();
     }
 
+    /**
+     * @brief Starts or stops capturing of calls into a draw log.
+     *
+     * Every drawing call, font change and display_frame() is recorded with its arguments
+     * and timestamp, so the sequence can be replayed by replay() later.
+     *
+     * Usage example:
+     * @code
+     * const GFXfont* fonts[] = {&FreeMono9pt7b, &FreeMonoBold12pt7b};
+     * fs::File log = LittleFS.open("/screen.log", "w");
+     * EinkDisplay::DrawRecorder recorder(log, fonts, 2);
+     * display.set_recorder(&recorder);
+     * @endcode
+     * @param recorder The recorder, nullptr stops capturing. It has to outlive capturing.
+     */
+    void set_recorder(EinkDisplay::DrawRecorder* recorder) {
+        m_recorder = recorder;
+    }
+
+    /**
+     * @brief Replays a draw log and reports metrics of every updated frame.
+     *
+     * Calls are replayed as fast as possible in the recorded order, timestamps are only
+     * reported. Drawing is measured from the first call after the previous frame. Replay
+     * is not captured by the recorder.
+     *
+     * Usage example:
+     * @code
+     * fs::File log = LittleFS.open("/screen.log", "r");
+     * display.replay(log, fonts, 2, [](const EinkDisplay::FrameReport& report) {
+     *     Serial.printf("%u %lu %lu %lu\n", report.frame, report.raster_time, report.dirty_area, report.spi_bytes);
+     * });
+     * @endcode
+     * @param in The input with the log.
+     * @param fonts Table of fonts given to the recorder.
+     * @param font_count Number of fonts in the table.
+     * @param on_frame Callable void(const EinkDisplay::FrameReport&) called after every display_frame().
+     * @return true if the whole log was replayed, false if it is not a draw log or it is corrupted.
+     */
+    template <typename FrameCallback>
+    bool replay(Stream& in, const GFXfont* const* fonts, uint8_t font_count, FrameCallback&& on_frame) {
+        EinkDisplay::DrawReader reader(in, frame_size());
+        if (!reader.read_header()) {
+            return false;
+        }
+        EinkDisplay::DrawRecorder* recorder = m_recorder;
+        m_recorder = nullptr;
+        EinkDisplay::DrawRecord record;
+        EinkDisplay::FrameReport report = {};
+        bool valid = true;
+        while (reader.next(record)) {
+            if (record.arg_count != EinkDisplay::argument_count(record.call)) {
+                debug::Print("Invalid record in draw log.\n");
+                valid = false;
+                break;
+            }
+            const int32_t* a = record.args;
+            if (record.call == EinkDisplay::DrawCall::DISPLAY_FRAME) {
+                report.recorded_time = record.time;
+                report.dirty_area = is_bounding_box_valid() ?
+                    (uint32_t)(m_max_bounding_box_x - m_min_bounding_box_x + 1) * (m_max_bounding_box_y - m_min_bounding_box_y + 1) : 0;
+                const uint32_t bytes = m_spi.getBytesSent();
+                const uint32_t start = micros();
+                display_frame((EinkDisplay::RefreshMode)a[0]);
+                report.refresh_time = micros() - start;
+                report.spi_bytes = m_spi.getBytesSent() - bytes;
+                on_frame(report);
+                report.frame++;
+                report.raster_time = 0;
+                continue;
+            }
+            const GFXfont* font = nullptr;
+            if (record.call == EinkDisplay::DrawCall::FONT) {
+                if (a[0] < -1 || a[0] >= font_count) {
+                    debug::Print("Unknown font in draw log.\n");
+                    continue;
+                }
+                font = a[0] == -1 ? nullptr : fonts[a[0]];
+            }
+            const uint32_t start = micros();
+            if (!apply(record.call, a, record.data, record.length, font)) {
+                valid = false;
+                break;
+            }
+            report.raster_time += micros() - start;
+        }
+        m_recorder = recorder;
+        return valid && !reader.failed();
+    }
+
+    /**
+     * @brief Draws commands queued by other tasks, it has to be called only from the renderer task.
+     *
+     * Queued commands are applied in order. Display is updated once after the batch if any
+     * of them requested it, full refresh wins over other requested modes. Producers are never
+     * blocked by drawing or refreshing, see EinkDisplay::DrawQueue.
+     * @param queue The queue.
+     * @param max_commands Maximal number of commands applied in this call.
+     * @return Number of applied commands.
+     */
+    uint16_t drain(EinkDisplay::DrawQueue& queue, uint16_t max_commands = UINT16_MAX) {
+        EinkDisplay::DrawCommand command;
+        int32_t args[EinkDisplay::DrawCommand::M_MAX_ARGS];
+        bool update = false;
+        EinkDisplay::RefreshMode mode = EinkDisplay::RefreshMode::AUTO;
+        uint16_t count = 0;
+        while (count < max_commands && queue.pop(command)) {
+            count++;
+            if (command.call == EinkDisplay::DrawCall::DISPLAY_FRAME) {
+                if (!update || mode != EinkDisplay::RefreshMode::FULL) {
+                    mode = (EinkDisplay::RefreshMode)command.args[0];
+                }
+                update = true;
+                continue;
+            }
+            std::copy(command.args, command.args + EinkDisplay::DrawCommand::M_MAX_ARGS, args);
+            const uint8_t* data = nullptr;
+            uint32_t length = command.length;
+            const GFXfont* font = nullptr;
+            if (command.call == EinkDisplay::DrawCall::TEXT) {
+                data = (const uint8_t*)command.text;
+            } else if (command.call == EinkDisplay::DrawCall::BITMAP) {
+                data = (const uint8_t*)command.pointer;
+                length = bitmap_size(args[2], args[3]);
+            } else if (command.call == EinkDisplay::DrawCall::FONT) {
+                font = (const GFXfont*)command.pointer;
+            }
+            apply(command.call, args, data, length, font);
+        }
+        if (update) {
+            display_frame(mode);
+        }
+        return count;
+    }
+
+    /// Maximal number of windows uploaded in one partial refresh
+    static constexpr uint8_t M_MAX_WINDOWS = 8;
+
+    /// Bytes of the row buffer of push_pixels(), a row of the canvas fits in every rotation
+    static constexpr uint16_t M_PUSH_ROW_SIZE =
+        ((DriverType::M_WIDTH > DriverType::M_HEIGHT ? DriverType::M_WIDTH : DriverType::M_HEIGHT) + 7) / 8;
+
 private:
 
+    /**
+     * @brief Run a recorded or queued call.
+     * @param call Type of the call.
+     * @param a Arguments of the call, see EinkDisplay::DrawCall.
+     * @param data Data of the call, e.g. text.
+     * @param length Length of the data.
+     * @param font Font of FONT call.
+     * @return false if the call was not run, its data is shorter than the call reads or the call is unknown.
+     */
+    bool apply(EinkDisplay::DrawCall call, const int32_t* a, const uint8_t* data, uint32_t length, const GFXfont* font) {
+        // Data of the call has to cover what the call reads, logs may come from other devices
+        uint64_t needed = 0;
+        switch (call) {
+        case EinkDisplay::DrawCall::PRINT:
+        case EinkDisplay::DrawCall::TEXT: needed = length <= UINT16_MAX ? length : UINT64_MAX; break;
+        case EinkDisplay::DrawCall::BITMAP:
+        case EinkDisplay::DrawCall::ROWS: needed = bitmap_size(a[2], a[3]); break;
+        default: break;
+        }
+        if (needed > length || (needed > 0 && data == nullptr)) {
+            debug::Print("Invalid data of draw call.\n");
+            return false;
+        }
+        switch (call) {
+        case EinkDisplay::DrawCall::CLEAR_FRAME: clear_frame(color_of(a[0])); break;
+        case EinkDisplay::DrawCall::CLEAR_BUFFER: clear_buffer(color_of(a[0])); break;
+        case EinkDisplay::DrawCall::PIXEL: draw_pixel(a[0], a[1], color_of(a[2])); break;
+        case EinkDisplay::DrawCall::LINE: draw_line(a[0], a[1], a[2], a[3], color_of(a[4])); break;
+        case EinkDisplay::DrawCall::RECT: draw_rect(a[0], a[1], a[2], a[3], color_of(a[4])); break;
+        case EinkDisplay::DrawCall::FILL_RECT: fill_rect(a[0], a[1], a[2], a[3], color_of(a[4])); break;
+        case EinkDisplay::DrawCall::CIRCLE: draw_circle(a[0], a[1], a[2], color_of(a[3])); break;
+        case EinkDisplay::DrawCall::FILL_CIRCLE: fill_circle(a[0], a[1], a[2], color_of(a[3])); break;
+        case EinkDisplay::DrawCall::SCROLL: scroll_region(a[0], a[1], a[2], a[3], a[4], a[5], color_of(a[6])); break;
+        case EinkDisplay::DrawCall::PRINT: {
+            char* text = new char[length + 1];
+            if (length > 0) {
+                memcpy(text, data, length);
+            }
+            text[length] = '\0';
+            print(a[0], a[1], color_of(a[2]), text);
+            delete[] text;
+            break;
+        }
+        case EinkDisplay::DrawCall::TEXT: draw_text(a[0], a[1], color_of(a[2]), (const char*)data, length); break;
+        case EinkDisplay::DrawCall::BITMAP: draw_bitmap(a[0], a[1], data, a[2], a[3], color_of(a[4]), color_of(a[5])); break;
+        case EinkDisplay::DrawCall::ROWS: {
+            const uint16_t stride = (a[2] + 7) / 8;
+            for (int32_t row = 0; row < a[3]; row++) {
+                m_target->writeRow(a[0], a[1] + row, data + row * stride, a[2]);
+            }
+            mark_dirty(a[0], a[1], a[0] + a[2] - 1, a[1] + a[3] - 1);
+            break;
+        }
+        case EinkDisplay::DrawCall::FONT: set_font(font); break;
+        case EinkDisplay::DrawCall::ROTATION: set_rotation(a[0]); break;
+        case EinkDisplay::DrawCall::PUSH_VIEWPORT: push_viewport(a[0], a[1], a[2], a[3]); break;
+        case EinkDisplay::DrawCall::POP_VIEWPORT: pop_viewport(); break;
+        case EinkDisplay::DrawCall::ADD_LAYER: add_layer((EinkCanvas::BlendOp)a[0]); break;
+        case EinkDisplay::DrawCall::SELECT_LAYER: select_layer(a[0]); break;
+        case EinkDisplay::DrawCall::LAYER_OP: set_layer_op(a[0], (EinkCanvas::BlendOp)a[1]); break;
+        case EinkDisplay::DrawCall::LAYER_VISIBLE: set_layer_visible(a[0], a[1]); break;
+        default:
+            debug::Print("Unknown draw call.\n");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Record a call if capturing is enabled, see set_recorder().
+     */
+    void record(EinkDisplay::DrawCall call, std::initializer_list<int32_t> args,
+                const uint8_t* data = nullptr, uint32_t length = 0) {
+        if (m_recorder != nullptr) {
+            m_recorder->record(call, args, data, length);
+        }
+    }
+
+    /**
+     * @brief Get size of a packed bitmap, UINT64_MAX if the size is negative or too large.
+     */
+    static uint64_t bitmap_size(int32_t w, int32_t h) {
+        if (w < 0 || h < 0 || w > INT16_MAX || h > INT16_MAX) {
+            return UINT64_MAX;
+        }
+        return (uint64_t)((w + 7) / 8) * h;
+    }
+
+    /**
+     * @brief Get color of a recorded color value.
+     */
+    static EinkColor color_of(int32_t value) {
+        return value ? EinkColor::WHITE : EinkColor::BLACK;
+    }
+
+    /**
+     * @brief Record resulting pixels of a rectangle, for calls drawing from external sources.
+     * @param x The x-coordinate of the top-left corner.
+     * @param y The y-coordinate of the top-left corner.
+     * @param w The width of the rectangle.
+     * @param h The height of the rectangle.
+     */
+    void record_rows(int16_t x, int16_t y, uint16_t w, uint16_t h) {
+        if (m_recorder == nullptr || w == 0 || h == 0) {
+            return;
+        }
+        const uint16_t stride = (w + 7) / 8;
+        uint8_t* rows = new uint8_t[(uint32_t)stride * h];
+        for (uint16_t row = 0; row < h; row++) {
+            m_target->readRow(x, y + row, rows + (uint32_t)row * stride, w);
+        }
+        m_recorder->record(EinkDisplay::DrawCall::ROWS, {x, y, w, h}, rows, (uint32_t)stride * h);
+        delete[] rows;
+    }
+
+    /**
+     * @brief Fill polygons of the rasterizer and mark their exact bounding box as changed.
+     * @param rasterizer Rasterizer with contours in viewport coordinates.
+     * @param color The color to fill with.
+     */
+    void fill_rasterized(EinkCanvas::ScanlineRasterizer& rasterizer, EinkColor color) {
+        int16_t x0, y0, x1, y1;
+        if (!m_target->fillPolygon(rasterizer, color.value(), x0, y0, x1, y1)) {
+            return;
+        }
+        update_bounding_box(x0, y0);
+        update_bounding_box(x1, y1);
+        update_deadline();
+        int16_t origin_x, origin_y;
+        m_target->getOrigin(origin_x, origin_y);
+        record_rows(x0 - origin_x, y0 - origin_y, x1 - x0 + 1, y1 - y0 + 1);
+    }
+
+    /**
+     * @brief Draw text glyph by glyph and update the bounding box by glyph metrics.
+     * @param x The x-coordinate of the text.
+     * @param y The y-coordinate of the text, baseline for GFX fonts, top for the built-in font.
+     * @param color The color of the text.
+     * @param text Characters to draw, UTF-8 for compact font.
+     * @param length Number of bytes.
+     */
+    void draw_text(int16_t x, int16_t y, EinkColor color, const char* text, uint16_t length) {
+        record(EinkDisplay::DrawCall::TEXT, {x, y, color.value()}, (const uint8_t*)text, length);
+        if (m_compact_font != nullptr) {
+            draw_compact_text(x, y, color, text, length);
+            return;
+        }
+        if (m_font == nullptr) {
+            // Built-in 5x7 font in 6x8 cells
+            for (uint16_t i = 0; i < length; i++) {
+                m_target->drawChar(x + i * 6, y, text[i], color.value(), color.value(), 1);
+            }
+            mark_dirty(x, y, x + length * 6 - 1, y + 7);
+            return;
+        }
+        int16_t min_x = INT16_MAX, min_y = INT16_MAX, max_x = INT16_MIN, max_y = INT16_MIN;
+        for (uint16_t i = 0; i < length; i++) {
+            const uint8_t c = text[i];
+            if (c < m_font->first || c > m_font->last) continue;
+            const GFXglyph& glyph = m_font->glyph[c - m_font->first];
+            if (glyph.width > 0 && glyph.height > 0) {
+                min_x = std::min<int16_t>(min_x, x + glyph.xOffset);
+                min_y = std::min<int16_t>(min_y, y + glyph.yOffset);
+                max_x = std::max<int16_t>(max_x, x + glyph.xOffset + glyph.width - 1);
+                max_y = std::max<int16_t>(max_y, y + glyph.yOffset + glyph.height - 1);
+            }
+            x += m_target->drawGlyph(x, y, m_font, c, color.value());
+        }
+        if (min_x <= max_x) {
+            mark_dirty(min_x, min_y, max_x, max_y);
+        }
+    }
+
+    /**
+     * @brief Draw UTF-8 text in the compact font and update the bounding box by glyph metrics.
+     * @param x The x-coordinate of the text.
+     * @param y The y-coordinate of the baseline.
+     * @param color The color of the text.
+     * @param text Characters to draw, not terminated, a sequence cut by the end is drawn as U+FFFD.
+     * @param length Number of bytes.
+     */
+    void draw_compact_text(int16_t x, int16_t y, EinkColor color, const char* text, uint16_t length) {
+        int16_t min_x = INT16_MAX, min_y = INT16_MAX, max_x = INT16_MIN, max_y = INT16_MIN;
+        const char* end = text + length;
+        while (text < end) {
+            const EinkDisplay::CompactGlyph* glyph = EinkDisplay::find_glyph(*m_compact_font, EinkDisplay::utf8_next(text, end));
+            if (glyph == nullptr) continue;
+            if (glyph->width > 0 && glyph->height > 0) {
+                min_x = std::min<int16_t>(min_x, x + glyph->x_offset);
+                min_y = std::min<int16_t>(min_y, y + glyph->y_offset);
+                max_x = std::max<int16_t>(max_x, x + glyph->x_offset + glyph->width - 1);
+                max_y = std::max<int16_t>(max_y, y + glyph->y_offset + glyph->height - 1);
+            }
+            x += m_target->drawCompactGlyph(x, y, *m_compact_font, *glyph, color.value());
+        }
+        if (min_x <= max_x) {
+            mark_dirty(min_x, min_y, max_x, max_y);
+        }
+    }
+
+    /**
+     * @brief Plan windows for upload of changed tiles inside of the bounding box.
+     *
+     * Neighbouring changed tiles in a tile row form one window. Pairs of windows are then
+     * merged into their bounding window while it is cheaper to upload than both windows
+     * separately, according to the cost model of the driver.
+     * @param windows Array for M_MAX_WINDOWS + 1 windows.
+     * @return Number of planned windows.
+     */
+    uint8_t plan_windows(EinkDriver::Window* windows) const {
+        const uint16_t tile_width = EinkDisplay::TileHashes::M_TILE_BYTES * 8;
+        const uint16_t tile_height = EinkDisplay::TileHashes::M_TILE_ROWS;
+        uint8_t count = 0;
+
+        for (uint16_t ty = 0; ty < m_tiles->tiles_y(); ty++) {
+            for (uint16_t tx = 0; tx < m_tiles->tiles_x(); tx++) {
+                if (!m_tiles->is_changed(tx, ty)) {
+                    continue;
+                }
+                EinkDriver::Window tile = {
+                    std::max<uint16_t>(m_min_bounding_box_x, tx * tile_width),
+                    std::max<uint16_t>(m_min_bounding_box_y, ty * tile_height),
+                    std::min<uint16_t>(m_max_bounding_box_x, (tx + 1) * tile_width - 1),
+                    std::min<uint16_t>(m_max_bounding_box_y, (ty + 1) * tile_height - 1)};
+                if (count > 0 && windows[count - 1].y_start == tile.y_start &&
+                    windows[count - 1].x_end + 1 == tile.x_start) {
+                    windows[count - 1].x_end = tile.x_end;
+                    continue;
+                }
+                windows[count++] = tile;
+                if (count > M_MAX_WINDOWS) {
+                    merge_cheapest_windows(windows, count, true);
+                }
+            }
+        }
+        while (count > 1 && merge_cheapest_windows(windows, count, false));
+        return count;
+    }
+
+    /**
+     * @brief Merge the pair of windows which is the cheapest to merge.
+     * @param windows Array of windows.
+     * @param count Number of windows, decremented if windows were merged.
+     * @param force If true, merge even if uploading merged window costs more than both windows.
+     * @return true if windows were merged, false otherwise.
+     */
+    bool merge_cheapest_windows(EinkDriver::Window* windows, uint8_t& count, bool force) const {
+        int32_t best_gain = INT32_MAX;
+        uint8_t best_i = 0, best_j = 0;
+        EinkDriver::Window best_window;
+
+        for (uint8_t i = 0; i < count; i++) {
+            for (uint8_t j = i + 1; j < count; j++) {
+                EinkDriver::Window merged = {
+                    std::min(windows[i].x_start, windows[j].x_start),
+                    std::min(windows[i].y_start, windows[j].y_start),
+                    std::max(windows[i].x_end, windows[j].x_end),
+                    std::max(windows[i].y_end, windows[j].y_end)};
+                int32_t gain = (int32_t)m_driver.upload_cost(merged) -
+                               (int32_t)m_driver.upload_cost(windows[i]) - (int32_t)m_driver.upload_cost(windows[j]);
+                if (gain < best_gain) {
+                    best_gain = gain;
+                    best_i = i;
+                    best_j = j;
+                    best_window = merged;
+                }
+            }
+        }
+        if (best_gain == INT32_MAX || (!force && best_gain > 0)) {
+            return false;
+        }
+        windows[best_i] = best_window;
+        windows[best_j] = windows[--count];
+        return true;
+    }
+
+    /**
+     * @brief Size of the canvas buffer in bytes.
+     * @return The size of the buffer.
+     */
+    size_t frame_size() const {
+        return (m_canvas->width() * m_canvas->height() + 7) / 8;
+    }
+
+    /**
+     * @brief Save the canvas as the displayed frame, if frame store is set.
+     */
+    void save_frame() {
+        if (m_frame_store != nullptr) {
+            m_frame_store->save(m_canvas->getBuffer(), frame_size(), m_refresh_number);
+        }
+    }
+
+    /**
+     * @brief Set the bounding box to the whole canvas.
+     */
+    void mark_all_dirty() {
+        update_bounding_box(0, 0);
+        update_bounding_box(m_canvas->width() - 1, m_canvas->height() - 1);
+        update_deadline();
+    }
+
+    /**
+     * @brief Move the deadline of pending changes earlier, if the current update delay requires it.
+     */
+    void update_deadline() {
+        const uint32_t deadline = millis() + m_update_delay;
+        if (!m_update_pending || (int32_t)(deadline - m_deadline) < 0) {
+            m_deadline = deadline;
+            m_update_pending = true;
+        }
+    }
+
     /**
      * @brief Reset the bounding box to the maximum size of the display.
      * This funtion reset minimal bounding box to default settings.
      */
     void reset_bounding_box() {
-        m_min_bounding_box_x = m_driver.get_width();
-        m_min_bounding_box_y = m_driver.get_height();
+        m_min_bounding_box_x = m_canvas->width();
+        m_min_bounding_box_y = m_canvas->height();
         m_max_bounding_box_x = 0;
         m_max_bounding_box_y = 0;
+        m_update_pending = false;
+    }
+
+    /**
+     * @brief Mark a rectangle of the selected viewport as changed.
+     * Rectangle is translated and clipped by the viewport first, so drawing outside
+     * of the canvas does not inflate the bounding box.
+     * @param x0 Left column, inclusive
+     * @param y0 Top row, inclusive
+     * @param x1 Right column, inclusive
+     * @param y1 Bottom row, inclusive
+     */
+    void mark_dirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+        if (!m_target->clipRect(x0, y0, x1, y1)) {
+            return;
+        }
+        update_bounding_box(x0, y0);
+        update_bounding_box(x1, y1);
+        update_deadline();
     }
 
     /**
      * @brief Update the bounding box with new coordinates.
      * This will ensure that the bounding box always contains the drawn content.
-     * @param x X coordinate
-     * @param y Y coordinate
+     * @param x X coordinate in the canvas, it has to be inside of the canvas
+     * @param y Y coordinate in the canvas, it has to be inside of the canvas
      */
-    void update_bounding_box(int16_t x, int16_t y) {
+    void update_bounding_box(uint16_t x, uint16_t y) {
         if (x < m_min_bounding_box_x) m_min_bounding_box_x = x;
         if (y < m_min_bounding_box_y) m_min_bounding_box_y = y;
         if (x > m_max_bounding_box_x) m_max_bounding_box_x = x;
@@ -429,29 +1708,51 @@ private:
     }
     
     /**
-     * @brief Check if the bounding box is above the threshold box.
-     * @return true if the bounding box is above the threshold, false otherwise.
+     * @brief Get area of the whole display.
+     * @return The area in pixels.
      */
-    bool bounding_above_threshold() const {
-        if (!is_bounding_box_valid()) {
-            return false;
+    uint32_t display_area() const {
+        return (uint32_t)m_canvas->width() * m_canvas->height();
+    }
+
+    /**
+     * @brief Get total area of the windows.
+     * @param windows Array of windows.
+     * @param count Number of windows.
+     * @return The area in pixels.
+     */
+    static uint32_t windows_area(const EinkDriver::Window* windows, uint8_t count) {
+        uint32_t area = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            area += (uint32_t)(windows[i].x_end - windows[i].x_start + 1) * (windows[i].y_end - windows[i].y_start + 1);
         }
-        uint16_t width = m_max_bounding_box_x - m_min_bounding_box_x;
-        uint16_t height = m_max_bounding_box_y - m_min_bounding_box_y;
-        return (width > full_refresh_threshold_width) && (height > full_refresh_threshold_height);
+        return area;
     }
 
     EinkSPI::SPIController m_spi;
     DriverType m_driver;
     EinkCanvas::GFXCanvasBW* m_canvas;
+    EinkCanvas::GFXCanvasBW* m_target;  ///< Canvas or layer where drawing goes
+    EinkCanvas::Compositor* m_layers = nullptr;
+    EinkDisplay::FrameStore* m_frame_store = nullptr;
+    EinkDisplay::DrawRecorder* m_recorder = nullptr;
+    EinkDisplay::TileHashes* m_tiles;
+    EinkCanvas::Ditherer* m_ditherer = nullptr;
+    const GFXfont* m_font = nullptr;
+    const EinkDisplay::CompactFont* m_compact_font = nullptr;
+    EinkDisplay::FontMetrics m_metrics;
 
     uint16_t m_min_bounding_box_x;
     uint16_t m_min_bounding_box_y; 
     uint16_t m_max_bounding_box_x;
     uint16_t m_max_bounding_box_y;
 
-    uint16_t full_refresh_threshold_height;
-    uint16_t full_refresh_threshold_width;
+    uint32_t m_full_refresh_area;
+    bool m_auto_threshold = true;
+    uint32_t m_update_delay = 0;
+    uint32_t m_deadline = 0;
+    bool m_update_pending = false;
+    EinkDisplay::RefreshProfiler m_profiler;
 
     uint8_t m_refresh_number;
     const uint8_t m_refresh_threshold;
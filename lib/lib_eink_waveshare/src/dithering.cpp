@@ -0,0 +1,152 @@
+#include "dithering.h"
+
+#include "my_utils.h"
+
+namespace EinkCanvas {
+
+namespace {
+
+/// Bayer matrix 8x8 scaled to thresholds 2..254
+constexpr uint8_t BAYER_THRESHOLDS[8][8] = {
+    {  2, 130,  34, 162,  10, 138,  42, 170},
+    {194,  66, 226,  98, 202,  74, 234, 106},
+    { 50, 178,  18, 146,  58, 186,  26, 154},
+    {242, 114, 210,  82, 250, 122, 218,  90},
+    { 14, 142,  46, 174,   6, 134,  38, 166},
+    {206,  78, 238, 110, 198,  70, 230, 102},
+    { 62, 190,  30, 158,  54, 182,  22, 150},
+    {254, 126, 222,  94, 246, 118, 214,  86},
+};
+
+constexpr uint8_t HALF_THRESHOLDS[8] = {128, 128, 128, 128, 128, 128, 128, 128};
+
+/// Error buffers are padded on both sides, so neighbours of edge pixels need no checks
+constexpr uint8_t ERROR_PADDING = 2;
+
+} // namespace
+
+Ditherer::Ditherer(uint16_t max_width) :
+    m_max_width(max_width) {
+    // Row is padded to whole bytes, padding is never shown
+    const uint16_t padded = (max_width + 7) & ~0x07;
+    m_gray = new uint8_t[padded + padded / 8];
+    m_bits = m_gray + padded;
+    const uint16_t row = max_width + 2 * ERROR_PADDING;
+    m_errors[0] = new int16_t[3 * row];
+    m_errors[1] = m_errors[0] + row;
+    m_errors[2] = m_errors[1] + row;
+}
+
+Ditherer::Ditherer(DitherMethod method, uint16_t width) :
+    Ditherer(width) {
+    start(method, width);
+}
+
+Ditherer::~Ditherer() {
+    delete[] m_gray;
+    delete[] m_errors[0];
+}
+
+bool Ditherer::start(DitherMethod method, uint16_t width) {
+    if (width > m_max_width) {
+        debug::Print("Dithered row is too wide.\n");
+        return false;
+    }
+    m_method = method;
+    m_width = width;
+    m_row = 0;
+    memset(m_gray, 0, (width + 7) & ~0x07);
+    if (method == DitherMethod::FLOYD_STEINBERG || method == DitherMethod::ATKINSON) {
+        memset(m_errors[0], 0, 3 * (m_max_width + 2 * ERROR_PADDING) * sizeof(int16_t));
+    }
+    return true;
+}
+
+void Ditherer::dither_row(uint8_t* bits) {
+    switch (m_method) {
+    case DitherMethod::THRESHOLD:
+        threshold_row(bits, HALF_THRESHOLDS);
+        break;
+    case DitherMethod::ORDERED:
+        threshold_row(bits, BAYER_THRESHOLDS[m_row & 0x07]);
+        break;
+    case DitherMethod::FLOYD_STEINBERG:
+        floyd_steinberg_row(bits);
+        break;
+    case DitherMethod::ATKINSON:
+        atkinson_row(bits);
+        break;
+    }
+    m_row++;
+}
+
+void Ditherer::threshold_row(uint8_t* bits, const uint8_t* thresholds) {
+    // Branchless inner loop over 8 pixels, compilers vectorize it on the host
+    const uint16_t bytes = (m_width + 7) / 8;
+    for (uint16_t i = 0; i < bytes; i++) {
+        const uint8_t* gray = m_gray + i * 8;
+        uint8_t out = 0;
+        for (uint8_t b = 0; b < 8; b++) {
+            out |= (uint8_t)(gray[b] >= thresholds[b]) << (7 - b);
+        }
+        bits[i] = out;
+    }
+}
+
+void Ditherer::floyd_steinberg_row(uint8_t* bits) {
+    // Errors are kept multiplied by 16, weights are 7 right, 3 down left, 5 down, 1 down right
+    int16_t* current = m_errors[m_row & 1] + ERROR_PADDING;
+    int16_t* next = m_errors[(m_row + 1) & 1] + ERROR_PADDING;
+    memset(next - ERROR_PADDING, 0, (m_width + 2 * ERROR_PADDING) * sizeof(int16_t));
+
+    int16_t right = 0;
+    uint8_t out = 0;
+    for (uint16_t x = 0; x < m_width; x++) {
+        const int16_t value = m_gray[x] + (current[x] + right) / 16;
+        const bool white = value >= 128;
+        const int16_t error = white ? value - 255 : value;
+        right = error * 7;
+        next[x - 1] += error * 3;
+        next[x] += error * 5;
+        next[x + 1] += error;
+
+        out = (out << 1) | white;
+        if ((x & 7) == 7) {
+            bits[x / 8] = out;
+        }
+    }
+    if (m_width & 7) {
+        bits[m_width / 8] = out << (8 - (m_width & 7));
+    }
+}
+
+void Ditherer::atkinson_row(uint8_t* bits) {
+    // Errors are kept multiplied by 8, 1/8 goes to 6 neighbours: 2 right, 3 below, 1 two rows below
+    int16_t* current = m_errors[m_row % 3] + ERROR_PADDING;
+    int16_t* next = m_errors[(m_row + 1) % 3] + ERROR_PADDING;
+    int16_t* after_next = m_errors[(m_row + 2) % 3] + ERROR_PADDING;
+    memset(after_next - ERROR_PADDING, 0, (m_width + 2 * ERROR_PADDING) * sizeof(int16_t));
+
+    uint8_t out = 0;
+    for (uint16_t x = 0; x < m_width; x++) {
+        const int16_t value = m_gray[x] + current[x] / 8;
+        const bool white = value >= 128;
+        const int16_t error = white ? value - 255 : value;
+        current[x + 1] += error;
+        current[x + 2] += error;
+        next[x - 1] += error;
+        next[x] += error;
+        next[x + 1] += error;
+        after_next[x] += error;
+
+        out = (out << 1) | white;
+        if ((x & 7) == 7) {
+            bits[x / 8] = out;
+        }
+    }
+    if (m_width & 7) {
+        bits[m_width / 8] = out << (8 - (m_width & 7));
+    }
+}
+
+} // namespace EinkCanvas
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace EinkCanvas{
+
+/**
+ * @brief Method of converting grayscale to black and white.
+ */
+enum class DitherMethod : uint8_t {
+    THRESHOLD,       ///< Plain threshold at half of the range
+    ORDERED,         ///< Ordered dithering by 8x8 Bayer matrix
+    FLOYD_STEINBERG, ///< Error diffusion by Floyd and Steinberg
+    ATKINSON         ///< Error diffusion by Atkinson, diffuses only 3/4 of the error, more contrast
+};
+
+/**
+ * @class Ditherer
+ * @brief Streaming conversion of 8-bit grayscale rows to packed 1-bit rows.
+ *
+ * Rows are converted one by one from top to bottom. Error diffusion keeps errors only for
+ * two rows below the current one, so memory does not depend on height of the image.
+ * Buffers are allocated once for the longest row, start() then begins another image of any
+ * method without allocating.
+ * Gray value 255 is white and gives bit 1, same as EinkColor::WHITE.
+ */
+class Ditherer {
+public:
+    /**
+     * @brief Construct ditherer for rows up to given width, start() has to be called before use.
+     * @param max_width Maximal width of the rows in pixels.
+     */
+    explicit Ditherer(uint16_t max_width);
+
+    /**
+     * @brief Construct ditherer for rows of given width and start an image.
+     * @param method Dithering method.
+     * @param width Width of the rows in pixels.
+     */
+    Ditherer(DitherMethod method, uint16_t width);
+
+    ~Ditherer();
+
+    Ditherer(const Ditherer&) = delete;
+    Ditherer& operator=(const Ditherer&) = delete;
+
+    /**
+     * @brief Start a new image, errors of the previous one are dropped.
+     * @param method Dithering method.
+     * @param width Width of the rows in pixels.
+     * @return false if the rows are wider than the buffers.
+     */
+    bool start(DitherMethod method, uint16_t width);
+
+    /**
+     * @brief Get maximal width of the rows.
+     * @return The width in pixels given to the constructor.
+     */
+    uint16_t max_width() const {
+        return m_max_width;
+    }
+
+    /**
+     * @brief Get buffer for the next grayscale row, it has to be filled with width values.
+     * @return Pointer to the row buffer.
+     */
+    uint8_t* row() {
+        return m_gray;
+    }
+
+    /**
+     * @brief Convert the row in the row buffer and move to the next row.
+     * @param bits Output for (width + 7) / 8 bytes, MSB is the leftmost pixel.
+     */
+    void dither_row(uint8_t* bits);
+
+    /**
+     * @brief Convert the row in the row buffer into the internal bit row and move to the next row.
+     * @return Pointer to (width + 7) / 8 bytes, valid until the next conversion.
+     */
+    const uint8_t* dither_row() {
+        dither_row(m_bits);
+        return m_bits;
+    }
+
+private:
+    void threshold_row(uint8_t* bits, const uint8_t* thresholds);
+    void floyd_steinberg_row(uint8_t* bits);
+    void atkinson_row(uint8_t* bits);
+
+    DitherMethod m_method = DitherMethod::THRESHOLD;
+    uint16_t m_max_width;
+    uint16_t m_width = 0;
+    uint16_t m_row = 0;
+    uint8_t* m_gray;
+    uint8_t* m_bits;
+    int16_t* m_errors[3];
+};
+
+} // namespace EinkCanvas
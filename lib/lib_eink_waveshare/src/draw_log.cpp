@@ -0,0 +1,199 @@
+#include "draw_log.h"
+
+#include "my_utils.h"
+
+namespace EinkDisplay {
+
+namespace {
+
+constexpr uint8_t M_MAGIC[4] = {'E', 'K', 'D', 'L'};
+constexpr uint16_t M_VERSION = 1;
+constexpr uint8_t M_HAS_DATA = 0x80;
+
+uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+} // namespace
+
+int8_t argument_count(DrawCall call) {
+    switch (call) {
+    case DrawCall::POP_VIEWPORT: return 0;
+    case DrawCall::CLEAR_FRAME:
+    case DrawCall::DISPLAY_FRAME:
+    case DrawCall::CLEAR_BUFFER:
+    case DrawCall::FONT:
+    case DrawCall::ROTATION:
+    case DrawCall::ADD_LAYER:
+    case DrawCall::SELECT_LAYER: return 1;
+    case DrawCall::LAYER_OP:
+    case DrawCall::LAYER_VISIBLE: return 2;
+    case DrawCall::PIXEL:
+    case DrawCall::PRINT:
+    case DrawCall::TEXT: return 3;
+    case DrawCall::CIRCLE:
+    case DrawCall::FILL_CIRCLE:
+    case DrawCall::ROWS:
+    case DrawCall::PUSH_VIEWPORT: return 4;
+    case DrawCall::LINE:
+    case DrawCall::RECT:
+    case DrawCall::FILL_RECT: return 5;
+    case DrawCall::BITMAP: return 6;
+    case DrawCall::SCROLL: return 7;
+    }
+    return -1;
+}
+
+DrawRecorder::DrawRecorder(Print& out, const GFXfont* const* fonts, uint8_t font_count):
+    m_out(out), m_fonts(fonts), m_font_count(font_count) {}
+
+void DrawRecorder::record(DrawCall call, std::initializer_list<int32_t> args, const uint8_t* data, uint32_t length) {
+    const uint32_t now = micros();
+    if (!m_started) {
+        m_out.write(M_MAGIC, sizeof(M_MAGIC));
+        m_out.write((const uint8_t*)&M_VERSION, sizeof(M_VERSION));
+        m_bytes += sizeof(M_MAGIC) + sizeof(M_VERSION);
+        m_last_time = now;
+        m_started = true;
+    }
+    const uint8_t arg_count = args.size() < DrawRecord::M_MAX_ARGS ? args.size() : DrawRecord::M_MAX_ARGS;
+    const uint8_t head[2] = {(uint8_t)((uint8_t)call | (data != nullptr ? M_HAS_DATA : 0)), arg_count};
+    m_out.write(head, sizeof(head));
+    m_bytes += sizeof(head);
+    write_varint(now - m_last_time);
+    m_last_time = now;
+    for (const int32_t* arg = args.begin(); arg != args.begin() + arg_count; arg++) {
+        write_varint(zigzag(*arg));
+    }
+    if (data != nullptr) {
+        write_varint(length);
+        m_out.write(data, length);
+        m_bytes += length;
+    }
+}
+
+int32_t DrawRecorder::font_index(const GFXfont* font) const {
+    if (font == nullptr) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < m_font_count; i++) {
+        if (m_fonts[i] == font) {
+            return i;
+        }
+    }
+    return -2;
+}
+
+void DrawRecorder::write_varint(uint32_t value) {
+    while (value >= 0x80) {
+        m_out.write((uint8_t)(value | 0x80));
+        value >>= 7;
+        m_bytes++;
+    }
+    m_out.write((uint8_t)value);
+    m_bytes++;
+}
+
+DrawReader::DrawReader(Stream& in, uint32_t max_data): m_in(in), m_max_data(max_data) {}
+
+DrawReader::~DrawReader() {
+    delete[] m_data;
+}
+
+bool DrawReader::read_header() {
+    uint8_t header[sizeof(M_MAGIC) + sizeof(M_VERSION)];
+    if (m_in.readBytes(header, sizeof(header)) != sizeof(header) || memcmp(header, M_MAGIC, sizeof(M_MAGIC)) != 0) {
+        debug::Print("Not a draw log.\n");
+        m_failed = true;
+        return false;
+    }
+    uint16_t version;
+    memcpy(&version, header + sizeof(M_MAGIC), sizeof(version));
+    if (version != M_VERSION) {
+        debug::Print("Unsupported version of draw log.\n");
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool DrawReader::next(DrawRecord& record) {
+    const int head = m_in.read();
+    if (head < 0 || m_failed) {
+        return false;
+    }
+    uint8_t arg_count;
+    uint32_t delta;
+    if (!read_byte(arg_count) || arg_count > DrawRecord::M_MAX_ARGS || !read_varint(delta)) {
+        m_failed = true;
+        return false;
+    }
+    m_time += delta;
+    record.call = (DrawCall)(head & ~M_HAS_DATA);
+    record.time = m_time;
+    record.arg_count = arg_count;
+    for (uint8_t i = 0; i < arg_count; i++) {
+        uint32_t value;
+        if (!read_varint(value)) {
+            m_failed = true;
+            return false;
+        }
+        record.args[i] = unzigzag(value);
+    }
+    record.length = 0;
+    record.data = nullptr;
+    if (head & M_HAS_DATA) {
+        if (!read_varint(record.length)) {
+            m_failed = true;
+            return false;
+        }
+        if (record.length > m_max_data) {
+            debug::Print("Data of draw log record is too long.\n");
+            m_failed = true;
+            return false;
+        }
+        if (record.length > m_data_capacity) {
+            delete[] m_data;
+            m_data = new uint8_t[record.length];
+            m_data_capacity = record.length;
+        }
+        if (m_in.readBytes(m_data, record.length) != record.length) {
+            debug::Print("Draw log is truncated.\n");
+            m_failed = true;
+            return false;
+        }
+        record.data = m_data;
+    }
+    return true;
+}
+
+bool DrawReader::read_byte(uint8_t& value) {
+    const int c = m_in.read();
+    if (c < 0) {
+        debug::Print("Draw log is truncated.\n");
+        return false;
+    }
+    value = c;
+    return true;
+}
+
+bool DrawReader::read_varint(uint32_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 32; shift += 7) {
+        uint8_t byte;
+        if (!read_byte(byte)) {
+            return false;
+        }
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace EinkDisplay
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <Arduino.h>
+#include <initializer_list>
+
+#include <Adafruit_GFX.h>
+
+namespace EinkDisplay{
+
+/**
+ * @brief Recorded call of DisplayHandle.
+ *
+ * Calls drawing from external sources (grayscale, images, pushed pixels, plots) are
+ * recorded as ROWS, the resulting pixels of their rectangle.
+ */
+enum class DrawCall : uint8_t {
+    CLEAR_FRAME = 1, ///< color
+    DISPLAY_FRAME,   ///< mode
+    CLEAR_BUFFER,    ///< color
+    PIXEL,           ///< x, y, color
+    LINE,            ///< x0, y0, x1, y1, color
+    RECT,            ///< x, y, w, h, color
+    FILL_RECT,       ///< x, y, w, h, color
+    CIRCLE,          ///< x, y, r, color
+    FILL_CIRCLE,     ///< x, y, r, color
+    SCROLL,          ///< x, y, w, h, dx, dy, background, data is none
+    PRINT,           ///< x, y, color, data is the text
+    TEXT,            ///< x, y, color, data is the text drawn glyph by glyph
+    BITMAP,          ///< x, y, w, h, foreground, background, data is the bitmap
+    ROWS,            ///< x, y, w, h, data is packed rows of the rectangle
+    FONT,            ///< index in the font table, -1 is the built-in font, -2 unknown font
+    ROTATION,        ///< rotation
+    PUSH_VIEWPORT,   ///< x, y, w, h
+    POP_VIEWPORT,    ///< no arguments
+    ADD_LAYER,       ///< blend operation
+    SELECT_LAYER,    ///< index
+    LAYER_OP,        ///< index, blend operation
+    LAYER_VISIBLE    ///< index, visible
+};
+
+/**
+ * @brief Get number of arguments of a call, see DrawCall.
+ * @param call Type of the call.
+ * @return The number of arguments, -1 for unknown call.
+ */
+int8_t argument_count(DrawCall call);
+
+/**
+ * @brief One call read from the log.
+ */
+struct DrawRecord {
+    static constexpr uint8_t M_MAX_ARGS = 8;
+
+    DrawCall call;
+    uint32_t time;            ///< Microseconds since the first recorded call
+    uint8_t arg_count;
+    int32_t args[M_MAX_ARGS];
+    uint32_t length;          ///< Length of data, 0 if the call has none
+    const uint8_t* data;      ///< Valid until the next record is read
+};
+
+/**
+ * @brief Metrics of one replayed DisplayHandle::display_frame().
+ */
+struct FrameReport {
+    uint16_t frame;         ///< Number of the frame since start of the replay
+    uint32_t recorded_time; ///< Time of the call in the log, microseconds since the first call
+    uint32_t raster_time;   ///< Time spent by drawing calls since the previous frame, microseconds
+    uint32_t dirty_area;    ///< Area of the bounding box of changes, pixels
+    uint32_t spi_bytes;     ///< Bytes sent to the display
+    uint32_t refresh_time;  ///< Time of display_frame() including waiting for the display, microseconds
+};
+
+/**
+ * @class DrawRecorder
+ * @brief Writes calls of DisplayHandle into a compact binary log.
+ *
+ * Log starts with magic "EKDL" and version. Every record is call type (top bit set if
+ * data follows), number of arguments, time since the previous record as varint,
+ * arguments as zigzag varints and optionally length of data as varint and the data.
+ * Small coordinates take a single byte. Log is replayed by DisplayHandle::replay()
+ * and can be listed by tools/draw_log_decode.py.
+ *
+ * Fonts are recorded as indices into a font table, the same table has to be given
+ * to the replay. Compact fonts are recorded as unknown fonts.
+ */
+class DrawRecorder {
+public:
+    /**
+     * @brief Construct a new recorder, header is written with the first record.
+     *
+     * @param out Output of the log, e.g. file or Serial.
+     * @param fonts Table of fonts used by the recorded code.
+     * @param font_count Number of fonts in the table.
+     */
+    DrawRecorder(Print& out, const GFXfont* const* fonts = nullptr, uint8_t font_count = 0);
+
+    /**
+     * @brief Write one record.
+     *
+     * @param call Type of the call.
+     * @param args Arguments of the call, at most DrawRecord::M_MAX_ARGS.
+     * @param data Data of the call, e.g. text.
+     * @param length Length of the data.
+     */
+    void record(DrawCall call, std::initializer_list<int32_t> args, const uint8_t* data = nullptr, uint32_t length = 0);
+
+    /**
+     * @brief Find a font in the font table.
+     *
+     * @param font The font, nullptr is the built-in font.
+     * @return Index in the table, -1 for the built-in font, -2 if the font is not in the table.
+     */
+    int32_t font_index(const GFXfont* font) const;
+
+    /**
+     * @brief Get number of bytes written to the log.
+     */
+    uint32_t get_bytes_written() const {
+        return m_bytes;
+    }
+
+private:
+    void write_varint(uint32_t value);
+
+    Print& m_out;
+    const GFXfont* const* m_fonts;
+    uint8_t m_font_count;
+    bool m_started = false;
+    uint32_t m_last_time = 0;
+    uint32_t m_bytes = 0;
+};
+
+/**
+ * @class DrawReader
+ * @brief Reads records of a log written by DrawRecorder.
+ */
+class DrawReader {
+public:
+    /**
+     * @brief Construct a new reader.
+     *
+     * @param in Input with the log, e.g. file.
+     * @param max_data Maximal length of data of a record, longer data is treated as corrupted log.
+     */
+    DrawReader(Stream& in, uint32_t max_data = M_MAX_DATA);
+
+    ~DrawReader();
+
+    DrawReader(const DrawReader&) = delete;
+    DrawReader& operator=(const DrawReader&) = delete;
+
+    /**
+     * @brief Read and check the header.
+     * @return true if the input is a log of supported version.
+     */
+    bool read_header();
+
+    /**
+     * @brief Read the next record.
+     *
+     * @param record Output record, its data is owned by the reader.
+     * @return true if the record was read, false at the end of the log or if it is corrupted.
+     */
+    bool next(DrawRecord& record);
+
+    /**
+     * @brief Check if reading stopped on corrupted or truncated log.
+     */
+    bool failed() const {
+        return m_failed;
+    }
+
+    /// Default limit of data length, enough for pixels of the whole 200x200 display
+    static constexpr uint32_t M_MAX_DATA = 200 * 200 / 8;
+
+private:
+    bool read_byte(uint8_t& value);
+    bool read_varint(uint32_t& value);
+
+    Stream& m_in;
+    uint32_t m_max_data;
+    uint32_t m_time = 0;
+    uint8_t* m_data = nullptr;
+    uint32_t m_data_capacity = 0;
+    bool m_failed = false;
+};
+
+} // namespace EinkDisplay
@@ -0,0 +1,109 @@
+#include "draw_queue.h"
+
+#include "my_utils.h"
+
+namespace EinkDisplay {
+
+DrawQueue::DrawQueue(uint16_t capacity) {
+    uint32_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_mask = size - 1;
+    m_slots = new Slot[size];
+    for (uint32_t i = 0; i < size; i++) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+DrawQueue::~DrawQueue() {
+    delete[] m_slots;
+}
+
+bool DrawQueue::push(const DrawCommand& command) {
+    uint32_t position = m_tail.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = m_slots[position & m_mask];
+        const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const int32_t difference = (int32_t)(sequence - position);
+        if (difference == 0) {
+            // Slot is free, claim it unless another producer was faster
+            if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.command = command;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            // Slot still holds a command from the previous round
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool DrawQueue::push(DrawCall call, std::initializer_list<int16_t> args) {
+    DrawCommand command = {};
+    command.call = call;
+    uint8_t i = 0;
+    for (const int16_t arg : args) {
+        if (i == DrawCommand::M_MAX_ARGS) break;
+        command.args[i++] = arg;
+    }
+    return push(command);
+}
+
+bool DrawQueue::push_text(int16_t x, int16_t y, EinkColor color, const char* text) {
+    if (text == nullptr) {
+        debug::Print("Text is null.\n");
+        return false;
+    }
+    DrawCommand command = {};
+    command.call = DrawCall::TEXT;
+    command.args[0] = x;
+    command.args[1] = y;
+    command.args[2] = color.value();
+    command.length = strnlen(text, DrawCommand::M_TEXT_SIZE);
+    memcpy(command.text, text, command.length);
+    return push(command);
+}
+
+bool DrawQueue::push_font(const GFXfont* font) {
+    DrawCommand command = {};
+    command.call = DrawCall::FONT;
+    command.pointer = font;
+    return push(command);
+}
+
+bool DrawQueue::push_bitmap(int16_t x, int16_t y, const uint8_t* bitmap, uint16_t w, uint16_t h,
+                            EinkColor fw_color, EinkColor bg_color) {
+    if (bitmap == nullptr) {
+        debug::Print("Bitmap is null.\n");
+        return false;
+    }
+    DrawCommand command = {};
+    command.call = DrawCall::BITMAP;
+    command.args[0] = x;
+    command.args[1] = y;
+    command.args[2] = w;
+    command.args[3] = h;
+    command.args[4] = fw_color.value();
+    command.args[5] = bg_color.value();
+    command.pointer = bitmap;
+    return push(command);
+}
+
+bool DrawQueue::pop(DrawCommand& command) {
+    Slot& slot = m_slots[m_head & m_mask];
+    if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) {
+        return false;
+    }
+    command = slot.command;
+    // Slot is free for the producer one round later
+    slot.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+    m_head++;
+    return true;
+}
+
+} // namespace EinkDisplay
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <initializer_list>
+
+#include <Adafruit_GFX.h>
+
+#include "draw_log.h"
+#include "eink_driver.h"
+
+namespace EinkDisplay{
+
+/**
+ * @brief Drawing command passed from a producer task to the renderer, 40 bytes.
+ *
+ * Arguments are the same as in the draw log, see EinkDisplay::DrawCall. Text is kept
+ * inline, fonts and bitmaps are passed by pointer and have to outlive the command.
+ */
+struct DrawCommand {
+    static constexpr uint8_t M_MAX_ARGS = 7;
+    static constexpr uint8_t M_TEXT_SIZE = 24;
+
+    DrawCall call;
+    uint8_t length;               ///< Length of the text
+    int16_t args[M_MAX_ARGS];
+    union {
+        char text[M_TEXT_SIZE];   ///< TEXT, not terminated
+        const void* pointer;      ///< FONT and BITMAP
+    };
+};
+
+/**
+ * @class DrawQueue
+ * @brief Bounded lock-free queue of drawing commands with many producers and one consumer.
+ *
+ * FreeRTOS tasks push commands without blocking, a single renderer task drains them
+ * into the display by DisplayHandle::drain(). Every slot has a sequence number, producers
+ * claim slots by compare and swap of the tail, so no task ever waits for another one.
+ * Push fails if the queue is full, failed pushes are counted.
+ *
+ * Usage example:
+ * @code
+ * EinkDisplay::DrawQueue queue(64);
+ *
+ * void sensor_task(void*) {
+ *     for (;;) {
+ *         queue.push(EinkDisplay::DrawCall::FILL_RECT, {0, 60, 200, 20, 1});
+ *         queue.push_text(4, 75, EinkColor::BLACK, "21.5 C");
+ *         queue.push(EinkDisplay::DrawCall::DISPLAY_FRAME, {0});
+ *         vTaskDelay(pdMS_TO_TICKS(5000));
+ *     }
+ * }
+ *
+ * void render_task(void*) {
+ *     for (;;) {
+ *         display.drain(queue);
+ *         vTaskDelay(pdMS_TO_TICKS(20));
+ *     }
+ * }
+ * @endcode
+ */
+class DrawQueue {
+public:
+    /**
+     * @brief Construct a new queue.
+     *
+     * @param capacity Number of commands, rounded up to a power of two.
+     */
+    DrawQueue(uint16_t capacity);
+
+    ~DrawQueue();
+
+    DrawQueue(const DrawQueue&) = delete;
+    DrawQueue& operator=(const DrawQueue&) = delete;
+
+    /**
+     * @brief Push a command, can be called from any task.
+     *
+     * @param command The command.
+     * @return true if the command was queued, false if the queue is full.
+     */
+    bool push(const DrawCommand& command);
+
+    /**
+     * @brief Push a command without data.
+     *
+     * @param call Type of the call.
+     * @param args Arguments of the call, at most DrawCommand::M_MAX_ARGS.
+     * @return true if the command was queued, false if the queue is full.
+     */
+    bool push(DrawCall call, std::initializer_list<int16_t> args);
+
+    /**
+     * @brief Push a single line of text, drawn by the current font.
+     *
+     * @param x The x-coordinate of the text.
+     * @param y The y-coordinate of the text.
+     * @param color The color of the text.
+     * @param text The text, longer text is cut to DrawCommand::M_TEXT_SIZE bytes.
+     * @return true if the command was queued, false if the queue is full.
+     */
+    bool push_text(int16_t x, int16_t y, EinkColor color, const char* text);
+
+    /**
+     * @brief Push a change of the font.
+     *
+     * @param font The font, nullptr is the built-in font.
+     * @return true if the command was queued, false if the queue is full.
+     */
+    bool push_font(const GFXfont* font);
+
+    /**
+     * @brief Push a bitmap, see DisplayHandle::draw_bitmap().
+     *
+     * @return true if the command was queued, false if the queue is full.
+     */
+    bool push_bitmap(int16_t x, int16_t y, const uint8_t* bitmap, uint16_t w, uint16_t h,
+                     EinkColor fw_color, EinkColor bg_color);
+
+    /**
+     * @brief Pop the oldest command, it can be called only from one task.
+     *
+     * @param command Output command.
+     * @return true if a command was popped, false if the queue is empty.
+     */
+    bool pop(DrawCommand& command);
+
+    /**
+     * @brief Get number of commands which did not fit into the queue.
+     */
+    uint32_t get_dropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        DrawCommand command;
+    };
+
+    Slot* m_slots;
+    uint32_t m_mask;
+    std::atomic<uint32_t> m_tail{0};
+    uint32_t m_head = 0;
+    std::atomic<uint32_t> m_dropped{0};
+};
+
+} // namespace EinkDisplay
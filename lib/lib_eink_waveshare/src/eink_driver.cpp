@@ -1,4 +1,7 @@
 #include "eink_driver.h"
+#include "init_script.h"
+
+#include <algorithm>
 
 namespace EinkDriver {
 
@@ -10,34 +13,100 @@ Eink1in54::Eink1in54(uint8_t rst, uint8_t busy, EinkSPI::SPIController& spi_cont
     digitalWrite(m_epd_rst, HIGH);
 }
 
-void Eink1in54::init(bool partial_update) {
+namespace {
+
+/// Size of the lookup table of a waveform
+constexpr size_t LUT_SIZE = 30;
+
+/// Initialization common for all waveforms
+constexpr uint8_t INIT_SCRIPT[] = {
+    0x01, 3, (Eink1in54::M_HEIGHT - 1) & 0xFF, ((Eink1in54::M_HEIGHT - 1) >> 8) & 0xFF, 0x00, // DRIVER_OUTPUT_CONTROL
+    0x0C, 3, 0xD7, 0xD6, 0x9D, // BOOSTER_SOFT_START_CONTROL
+    0x2C, 1, 0xA8, // WRITE_VCOM_REGISTER
+};
+
+/// Writes of lookup tables of waveforms, indexed by Waveform
+constexpr uint8_t WAVEFORM_SCRIPTS[][2 + LUT_SIZE] = {
+    { // Full refresh
+        0x32, LUT_SIZE, // WRITE_LUT_REGISTER
+        0x02, 0x02, 0x01, 0x11, 0x12, 0x12, 0x22, 0x22,
+        0x66, 0x69, 0x69, 0x59, 0x58, 0x99, 0x99, 0x88,
+        0x00, 0x00, 0x00, 0x00, 0xF8, 0xB4, 0x13, 0x51,
+        0x35, 0x51, 0x51, 0x19, 0x01, 0x00
+    },
+    { // Partial refresh
+        0x32, LUT_SIZE,
+        0x10, 0x18, 0x18, 0x08, 0x18, 0x18, 0x08, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x13, 0x14, 0x44, 0x12,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+    { // Fast partial refresh, only first phases of the partial waveform
+        0x32, LUT_SIZE,
+        0x10, 0x18, 0x18, 0x08, 0x18, 0x18, 0x08, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x13, 0x11, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    },
+};
+
+/**
+ * @brief Frame timing for a temperature range.
+ */
+struct FrameTiming {
+    int8_t min_temperature;     ///< Lowest temperature of the range in degrees Celsius
+    uint8_t script[6];          ///< SET_DUMMY_LINE_PERIOD and SET_GATE_TIME
+};
+
+/// Frame timings ordered from the warmest, colder panel needs slower frames
+constexpr FrameTiming FRAME_TIMINGS[] = {
+    {10, {0x3A, 1, 0x1A, 0x3B, 1, 0x08}}, // 2uS gate time
+    {0, {0x3A, 1, 0x24, 0x3B, 1, 0x08}},
+    {INT8_MIN, {0x3A, 1, 0x30, 0x3B, 1, 0x08}},
+};
+
+/// DATA_ENTRY_MODE_SETTING, X increment, Y increment
+constexpr uint8_t ENTRY_INCREMENT_SCRIPT[] = {0x11, 1, 0x03};
+
+/// DATA_ENTRY_MODE_SETTING, X decrement, Y decrement
+constexpr uint8_t ENTRY_DECREMENT_SCRIPT[] = {0x11, 1, 0x00};
+
+/// Refresh of the display by the loaded waveform
+constexpr uint8_t REFRESH_SCRIPT[] = {
+    0x22, 1 | Script::DELAY, 0xC4, 10, // DISPLAY_UPDATE_CONTROL_2
+    0x20, 0, // MASTER_ACTIVATION
+    0xFF, 0, // NOP, terminates the activation
+};
+
+} // namespace
+
+void Eink1in54::init(Waveform waveform) {
     panel_reset();
-    debug::Print("Eink1in54 initialized\n");
-    debug::Print("Busy pin state: ");
-    debug::Print(digitalRead(m_epd_busy) == HIGH ? "BUSY\n" : "IDLE\n");
-
-    m_SPI_controller.sendCommandWithData(0x01, {(M_HEIGHT - 1) & 0xFF, ((M_HEIGHT - 1) >> 8) & 0xFF, 0x00}); // DRIVER_OUTPUT_CONTROL
-    m_SPI_controller.sendCommandWithData(0x0C, {0xD7, 0xD6, 0x9D}); // BOOSTER_SOFT_START_CONTROL
-    m_SPI_controller.sendCommandWithData(0x2C, {0xA8}); // WRITE_VCOM_REGISTER
-    m_SPI_controller.sendCommandWithData(0x3A, {0x1A}); // SET_DUMMY_LINE_PERIOD, 4 dummy lines per gate
-    m_SPI_controller.sendCommandWithData(0x3B, {0x08}); // SET_GATE_TIME, to 2uS per line
-    m_SPI_controller.sendCommandWithData(0x11, {0x03}); // DATA_ENTRY_MODE_SETTING, X increment, Y increment
-
-    if(partial_update){
-        m_SPI_controller.sendCommandWithData(0x32, { // Lut for partial refresh
-            0x10, 0x18, 0x18, 0x08, 0x18, 0x18, 0x08, 0x00, 
-            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-            0x00, 0x00, 0x00, 0x00, 0x13, 0x14, 0x44, 0x12, 
-            0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-        });
+    if constexpr (EINK_TRACE_LEVEL >= 2) {
+        debug::Print("Eink1in54 initialized\n");
+        debug::Print("Busy pin state: ");
+        debug::Print(digitalRead(m_epd_busy) == HIGH ? "BUSY\n" : "IDLE\n");
     }
-    else {
-        m_SPI_controller.sendCommandWithData(0x32, { // Lut for full refresh
-            0x02, 0x02, 0x01, 0x11, 0x12, 0x12, 0x22, 0x22,
-            0x66, 0x69, 0x69, 0x59, 0x58, 0x99, 0x99, 0x88,
-            0x00, 0x00, 0x00, 0x00, 0xF8, 0xB4, 0x13, 0x51,
-            0x35, 0x51, 0x51, 0x19, 0x01, 0x00});
+
+    const FrameTiming* timing = FRAME_TIMINGS;
+    while (m_temperature < timing->min_temperature) {
+        timing++;
     }
+
+    // Parts selected by temperature, rotation and waveform are joined and sent in a single transfer
+    uint8_t script[sizeof(INIT_SCRIPT) + sizeof(timing->script) + sizeof(ENTRY_INCREMENT_SCRIPT) + sizeof(WAVEFORM_SCRIPTS[0])];
+    uint8_t* end = script;
+    end = std::copy(INIT_SCRIPT, INIT_SCRIPT + sizeof(INIT_SCRIPT), end);
+    end = std::copy(timing->script, timing->script + sizeof(timing->script), end);
+    const uint8_t* entry = m_rotation == 2 ? ENTRY_DECREMENT_SCRIPT : ENTRY_INCREMENT_SCRIPT;
+    end = std::copy(entry, entry + sizeof(ENTRY_INCREMENT_SCRIPT), end);
+    const uint8_t* lut = WAVEFORM_SCRIPTS[(uint8_t)waveform];
+    end = std::copy(lut, lut + sizeof(WAVEFORM_SCRIPTS[0]), end);
+    Script::run(m_SPI_controller, m_epd_busy, script, end - script);
+}
+
+void Eink1in54::set_temperature(int8_t celsius) {
+    m_temperature = celsius;
 }
 
 void Eink1in54::set_frame_memory(const uint8_t* image_buffer){
@@ -45,12 +114,16 @@ void Eink1in54::set_frame_memory(const uint8_t* image_buffer){
         debug::Print("Image buffer is null.\n");
         return;
     }
-    
-    set_window(0, 0, M_WIDTH-1, M_HEIGHT-1);
-    set_cursor(0, 0);
-    m_SPI_controller.sendCommand(0x24); // WRITE_RAM command
+    if (m_rotation != 0) {
+        // Window is clamped to the rotated screen
+        set_frame_memory(image_buffer, 0, 0, UINT16_MAX, UINT16_MAX);
+        return;
+    }
+
+    trace::log(trace::Event::UPLOAD_START, 0, 0, 0, M_WIDTH - 1, M_HEIGHT - 1);
+    begin_ram_write(0, 0, M_WIDTH-1, M_HEIGHT-1);
     m_SPI_controller.sendData(image_buffer, M_WIDTH * M_HEIGHT / 8); // Send image data
-    debug::Print("Image data sent.\n");
+    trace::log(trace::Event::UPLOAD_END);
 }
 
 /**
@@ -71,6 +144,45 @@ inline uint16_t ceilToMultipleOf8(uint16_t n) {
     return (n + 7) & ~0x07;
 }
 
+/**
+ * @brief Reverses order of bits in a byte.
+ * @param b The byte to reverse.
+ * @return The mirrored byte.
+ */
+inline uint8_t reverseBits(uint8_t b) {
+    b = ((b & 0xF0) >> 4) | ((b & 0x0F) << 4);
+    b = ((b & 0xCC) >> 2) | ((b & 0x33) << 2);
+    b = ((b & 0xAA) >> 1) | ((b & 0x55) << 1);
+    return b;
+}
+
+/**
+ * @brief Transposes 8x8 block of pixels, MSB is the leftmost pixel.
+ * Row j of the output is column j of the input.
+ * @param in Pointer to the first row of the block.
+ * @param stride Distance between rows of the block in bytes, may be negative.
+ * @param out Output array of 8 rows.
+ */
+inline void transpose8x8(const uint8_t* in, int stride, uint8_t* out) {
+    uint32_t x = ((uint32_t)in[0] << 24) | ((uint32_t)in[stride] << 16) |
+                 ((uint32_t)in[2 * stride] << 8) | in[3 * stride];
+    uint32_t y = ((uint32_t)in[4 * stride] << 24) | ((uint32_t)in[5 * stride] << 16) |
+                 ((uint32_t)in[6 * stride] << 8) | in[7 * stride];
+    uint32_t t;
+
+    // Swap 1x1, then 2x2 and finally 4x4 sub-blocks
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0] = x >> 24; out[1] = x >> 16; out[2] = x >> 8; out[3] = x;
+    out[4] = y >> 24; out[5] = y >> 16; out[6] = y >> 8; out[7] = y;
+}
+
 void Eink1in54::set_frame_memory(
     const uint8_t* image_buffer,
     uint16_t x_start, uint16_t y_start,
@@ -81,63 +193,204 @@ void Eink1in54::set_frame_memory(
         return;
     }
 
-    // Align to byte boundaries
-    x_start = floorToMultipleOf8(x_start);
-    x_end   = ceilToMultipleOf8(x_end);
+    // Size of the rotated screen, the image buffer has this layout
+    const uint16_t width  = (m_rotation & 1) ? M_HEIGHT : M_WIDTH;
+    const uint16_t height = (m_rotation & 1) ? M_WIDTH : M_HEIGHT;
 
-    // Compute width/height of the rect
-    uint16_t width  = x_end - x_start;
-    uint16_t height = y_end - y_start + 1;
+    if (x_end >= width)  x_end = width - 1;
+    if (y_end >= height) y_end = height - 1;
 
     // Sanity‐check
-    if (width  > M_WIDTH  || height > M_HEIGHT) {
+    if (x_start > x_end || y_start > y_end) {
         debug::Print("Image dimensions exceed display size.\n");
         return;
     }
 
-    // Tell the display which window we’ll update
-    set_window(x_start, y_start, x_end - 1, y_end);
-    set_cursor(x_start, y_start);
-    m_SPI_controller.sendCommand(0x24); // WRITE_RAM
+    trace::log(trace::Event::UPLOAD_START, m_rotation, x_start, y_start, x_end, y_end);
+
+    // Align to byte boundaries, x_end becomes exclusive
+    x_start = floorToMultipleOf8(x_start);
+    x_end   = ceilToMultipleOf8(x_end + 1);
+
+    if (m_rotation & 1) {
+        set_frame_memory_transposed(image_buffer, x_start, floorToMultipleOf8(y_start), x_end, ceilToMultipleOf8(y_end + 1));
+        trace::log(trace::Event::UPLOAD_END);
+        return;
+    }
 
     // How many bytes each full row occupies in image_buffer
-    const uint16_t bytes_per_row = M_WIDTH / 8;
+    const uint16_t bytes_per_row = width / 8;
+    const uint16_t row_bytes = (x_end - x_start) / 8;
 
-    // For each scan‐line in our rectangle...
-    for (uint16_t row = y_start; row <= y_end; row++) {
-        // For each byte‐column in our rectangle...
-        for (uint16_t x = x_start; x < x_end; x += 8) {
-            // Compute the index into image_buffer
-            uint16_t byte_index = row * bytes_per_row + (x / 8);
-            uint8_t pixel_byte = image_buffer[byte_index];
-            // Push that byte out
-            m_SPI_controller.sendData(pixel_byte);
+    if (m_rotation == 0) {
+        // Tell the display which window we’ll update
+        begin_ram_write(x_start, y_start, x_end - 1, y_end);
+        for (uint16_t row = y_start; row <= y_end; row++) {
+            m_SPI_controller.sendData(image_buffer + row * bytes_per_row + x_start / 8, row_bytes);
         }
     }
-    debug::Print("Partial image data sent\n");
+    else {
+        // Controller walks the mirrored window backwards, only pixels inside of bytes need mirroring
+        begin_ram_write(width - x_end, height - 1 - y_end, width - 1 - x_start, height - 1 - y_start);
+        uint8_t line[M_WIDTH / 8];
+        for (uint16_t row = y_start; row <= y_end; row++) {
+            const uint8_t* src = image_buffer + row * bytes_per_row + x_start / 8;
+            for (uint16_t i = 0; i < row_bytes; i++) {
+                line[i] = reverseBits(src[i]);
+            }
+            m_SPI_controller.sendData(line, row_bytes);
+        }
+    }
+    trace::log(trace::Event::UPLOAD_END);
+}
+
+void Eink1in54::set_frame_memory(const uint8_t* image_buffer, const Window* windows, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        set_frame_memory(image_buffer, windows[i].x_start, windows[i].y_start, windows[i].x_end, windows[i].y_end);
+    }
 }
 
+uint32_t Eink1in54::upload_cost(const Window& window) const {
+    const uint32_t width = ceilToMultipleOf8(window.x_end + 1) - floorToMultipleOf8(window.x_start);
+    uint32_t bytes, transactions;
+    if (m_rotation & 1) {
+        // Window is sent in bands of 8 columns, one transaction per panel row, rows are aligned too
+        const uint32_t height = ceilToMultipleOf8(window.y_end + 1) - floorToMultipleOf8(window.y_start);
+        bytes = 14 + width * height / 8;
+        transactions = 5 + width;
+    }
+    else {
+        const uint32_t rows = window.y_end - window.y_start + 1;
+        bytes = 14 + rows * width / 8;
+        transactions = 5 + rows;
+    }
+    return bytes * 8000 / (m_SPI_controller.getFrequency() / 1000) + transactions * M_TRANSACTION_OVERHEAD_US;
+}
+
+void Eink1in54::set_frame_memory_transposed(
+    const uint8_t* image_buffer,
+    uint16_t x_start, uint16_t y_start,
+    uint16_t x_end,   uint16_t y_end)
+{
+    // Columns of the logical screen are rows of the panel, so 8 logical columns
+    // give 8 panel rows. They are transposed block by block into the band and then streamed out.
+    const int bytes_per_row = M_HEIGHT / 8;
+    const uint16_t band_bytes = (y_end - y_start) / 8;
+    uint8_t band[8][M_WIDTH / 8];
+    uint8_t block[8];
+
+    if (m_rotation == 1) {
+        // Logical pixel (x, y) lies on the panel at (M_WIDTH - 1 - y, x)
+        begin_ram_write(M_WIDTH - y_end, x_start, M_WIDTH - 1 - y_start, x_end - 1);
+        for (uint16_t x = x_start; x < x_end; x += 8) {
+            for (uint16_t k = 0; k < band_bytes; k++) {
+                transpose8x8(image_buffer + (y_end - 1 - 8 * k) * bytes_per_row + x / 8, -bytes_per_row, block);
+                for (uint8_t j = 0; j < 8; j++) {
+                    band[j][k] = block[j];
+                }
+            }
+            for (uint8_t j = 0; j < 8; j++) {
+                m_SPI_controller.sendData(band[j], band_bytes);
+            }
+        }
+    }
+    else {
+        // Logical pixel (x, y) lies on the panel at (y, M_HEIGHT - 1 - x)
+        begin_ram_write(y_start, M_HEIGHT - x_end, y_end - 1, M_HEIGHT - 1 - x_start);
+        for (uint16_t x = x_end; x > x_start; x -= 8) {
+            for (uint16_t k = 0; k < band_bytes; k++) {
+                transpose8x8(image_buffer + (y_start + 8 * k) * bytes_per_row + (x - 8) / 8, bytes_per_row, block);
+                for (uint8_t j = 0; j < 8; j++) {
+                    band[j][k] = block[j];
+                }
+            }
+            for (int8_t j = 7; j >= 0; j--) {
+                m_SPI_controller.sendData(band[j], band_bytes);
+            }
+        }
+    }
+}
 
 void Eink1in54::clear_frame(EinkColor color) {
-    uint8_t val = 0xFF; // Default to white
-    if(color == EinkColor::BLACK) {
-        uint8_t val = 0x00; // Set to black
+    const uint16_t width  = (m_rotation & 1) ? M_HEIGHT : M_WIDTH;
+    const uint16_t height = (m_rotation & 1) ? M_WIDTH : M_HEIGHT;
+    fill_window({0, 0, (uint16_t)(width - 1), (uint16_t)(height - 1)}, color);
+}
+
+void Eink1in54::fill_window(const Window& window, EinkColor color) {
+    const uint16_t width  = (m_rotation & 1) ? M_HEIGHT : M_WIDTH;
+    const uint16_t height = (m_rotation & 1) ? M_WIDTH : M_HEIGHT;
+    const uint16_t x_start = window.x_start;
+    const uint16_t y_start = window.y_start;
+    uint16_t x_end = window.x_end;
+    uint16_t y_end = window.y_end;
+    if (x_end >= width)  x_end = width - 1;
+    if (y_end >= height) y_end = height - 1;
+    if (x_start > x_end || y_start > y_end) {
+        debug::Print("Window exceeds display size.\n");
+        return;
     }
-    set_window(0, 0, M_WIDTH-1, M_HEIGHT-1);
-    set_cursor(0, 0);
-    m_SPI_controller.sendCommand(0x24); // WRITE_RAM command
-    for (uint16_t i = 0; i < (M_WIDTH * M_HEIGHT / 8); i++) {
-        m_SPI_controller.sendData(val); // Send color data
+    trace::log(trace::Event::UPLOAD_START, m_rotation, x_start, y_start, x_end, y_end);
+
+    // Window on the panel, the color is same everywhere, so only position matters
+    uint16_t panel_x_start, panel_y_start, panel_x_end, panel_y_end;
+    switch (m_rotation) {
+    case 1:
+        panel_x_start = M_WIDTH - 1 - y_end;
+        panel_x_end = M_WIDTH - 1 - y_start;
+        panel_y_start = x_start;
+        panel_y_end = x_end;
+        break;
+    case 2:
+        panel_x_start = M_WIDTH - 1 - x_end;
+        panel_x_end = M_WIDTH - 1 - x_start;
+        panel_y_start = M_HEIGHT - 1 - y_end;
+        panel_y_end = M_HEIGHT - 1 - y_start;
+        break;
+    case 3:
+        panel_x_start = y_start;
+        panel_x_end = y_end;
+        panel_y_start = M_HEIGHT - 1 - x_end;
+        panel_y_end = M_HEIGHT - 1 - x_start;
+        break;
+    default:
+        panel_x_start = x_start;
+        panel_x_end = x_end;
+        panel_y_start = y_start;
+        panel_y_end = y_end;
+        break;
     }
-    debug::Print("Image data cleared.\n");
+    panel_x_start = floorToMultipleOf8(panel_x_start);
+    panel_x_end = ceilToMultipleOf8(panel_x_end + 1) - 1;
+
+    begin_ram_write(panel_x_start, panel_y_start, panel_x_end, panel_y_end);
+    const uint32_t bytes = (uint32_t)(panel_x_end + 1 - panel_x_start) / 8 * (panel_y_end - panel_y_start + 1);
+    m_SPI_controller.sendRepeatedData(color == EinkColor::BLACK ? 0x00 : 0xFF, bytes);
+    trace::log(trace::Event::UPLOAD_END);
+}
+
+void Eink1in54::set_rotation(uint8_t rotation) {
+    m_rotation = rotation & 0x03;
 }
 
 void Eink1in54::display_frame() {
-    m_SPI_controller.sendCommandWithData(0x22, {0xC4}); // DISPLAY_REFRESH command
-    delay(10);
-    m_SPI_controller.sendCommand(0x20); // Trigger display refresh
-    m_SPI_controller.sendCommand(0xFF); // Wait for the display to be ready
-    wait_until_idle();
+    Script::run(m_SPI_controller, m_epd_busy, REFRESH_SCRIPT);
+    trace::log(trace::Event::BUSY_START);
+    m_busy_time = wait_until_idle();
+    trace::log(trace::Event::BUSY_END, 0, m_busy_time);
+}
+
+void Eink1in54::begin_ram_write(uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end) {
+    if (m_rotation == 2) {
+        // Address counters are decremented, start from the opposite corner
+        set_window(x_end, y_end, x_start, y_start);
+        set_cursor(x_end, y_end);
+    }
+    else {
+        set_window(x_start, y_start, x_end, y_end);
+        set_cursor(x_start, y_start);
+    }
+    m_SPI_controller.sendCommand(0x24); // WRITE_RAM command
 }
 
 void Eink1in54::set_window(uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end) {
@@ -171,10 +424,12 @@ void Eink1in54::panel_reset() {
 
 
 
-void Eink1in54::wait_until_idle() {
+uint32_t Eink1in54::wait_until_idle() {
+    const uint32_t start = millis();
     while (digitalRead(m_epd_busy) == HIGH) {
     delay(1);
     }
+    return millis() - start;
 }
 
 
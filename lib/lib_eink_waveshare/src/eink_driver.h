@@ -40,6 +40,26 @@ constexpr EinkColor EinkColor::WHITE(1);
 
 namespace EinkDriver {
 
+/**
+ * @brief Waveforms used for refreshing the display, ordered from the best quality to the fastest.
+ */
+enum class Waveform : uint8_t {
+    FULL,    ///< Full refresh, slow but clears ghosting
+    PARTIAL, ///< Partial refresh of changed pixels
+    FAST     ///< Shortened partial refresh, for rapidly changing content, more ghosting
+};
+
+/**
+ * @struct Window
+ * @brief Rectangular area of the frame, all coordinates are inclusive.
+ */
+struct Window {
+    uint16_t x_start;
+    uint16_t y_start;
+    uint16_t x_end;
+    uint16_t y_end;
+};
+
 /**
  * @class Interface
  * @brief Interface for E-ink display drivers.
@@ -57,9 +77,17 @@ public:
 
     /**
      * @brief Initialize the display.
-     * @param partial_update If true, enables partial update mode (if supported by hardware).
+     * @param waveform Waveform used by the next refresh. Drivers without the waveform fall back
+     *        to the nearest waveform of better quality.
      */
-    virtual void init(bool partial_update) = 0;
+    virtual void init(Waveform waveform) = 0;
+
+    /**
+     * @brief Set temperature of the panel, waveform timing is chosen according to it.
+     * Takes effect with the next call of init().
+     * @param celsius Temperature in degrees Celsius.
+     */
+    virtual void set_temperature(int8_t celsius) = 0;
     
     /**
      * @brief Set the display frame buffer with provided image data.
@@ -77,18 +105,56 @@ public:
      * @param y_end End y coordinate for the image.
      */
     virtual void set_frame_memory(const uint8_t* image_buffer, uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end) = 0;
+
+    /**
+     * @brief Partially update the display memory in several windows.
+     * All windows are uploaded before a single display_frame().
+     * @param image_buffer Pointer to buffer containing the image data to display.
+     * @param windows Array of windows to upload.
+     * @param count Number of windows.
+     */
+    virtual void set_frame_memory(const uint8_t* image_buffer, const Window* windows, uint8_t count) = 0;
+
+    /**
+     * @brief Estimate cost of uploading one window at the current SPI clock.
+     * Includes setup of the window and cursor as well as the image data.
+     * @param window Window to upload.
+     * @return Estimated time in microseconds.
+     */
+    virtual uint32_t upload_cost(const Window& window) const = 0;
     
     /**
      * @brief Clear the entire display to a specific color.
      * @param color The color to fill the display with.
      */
     virtual void clear_frame(EinkColor color) = 0;
+
+    /**
+     * @brief Fill a window of the display memory with a color, without any image buffer.
+     * @param window Window in coordinates of the rotated screen, it is aligned to whole bytes.
+     * @param color The color to fill the window with.
+     */
+    virtual void fill_window(const Window& window, EinkColor color) = 0;
+
+    /**
+     * @brief Set orientation of the frame buffers passed to the driver.
+     * Buffers are always drawn in unrotated byte layout of the rotated (logical) screen,
+     * driver maps them onto the panel while uploading.
+     * @param rotation Rotation in steps of 90 degrees clockwise (0-3), same meaning as in Adafruit GFX.
+     */
+    virtual void set_rotation(uint8_t rotation) = 0;
     
     /**
      * @brief Update the physical display with current frame buffer contents.
      */
     virtual void display_frame() = 0;
     
+    /**
+     * @brief Get duration of the last display_frame(), time the display was busy refreshing.
+     * @return Duration in milliseconds.
+     */
+    virtual uint32_t get_busy_time() const = 0;
+
     /**
      * @brief Put the display into sleep mode to save power.
      */
@@ -129,9 +195,19 @@ public:
     /**
      * @brief Initialize the display.
      * This function initializes the display and sets it to a known state.
-     * @param partial_update If true, enables partial update mode.
+     * Lookup table of the waveform is loaded and frame timing is set according to temperature.
+     * @param waveform Waveform used by the next refresh.
+     */
+    void init(Waveform waveform = Waveform::FULL);
+
+    /**
+     * @brief Set temperature of the panel.
+     * Colder panel needs longer waveform phases, so more dummy lines are used per gate.
+     * @note Temperature register of the controller can not be read on this module, because
+     *       data line is write only. Temperature has to be measured by the application.
+     * @param celsius Temperature in degrees Celsius.
      */
-    void init(bool partial_update = false);
+    void set_temperature(int8_t celsius);
 
     /**
      * @brief Set the frame memory with the provided image buffer.
@@ -154,6 +230,25 @@ public:
      */
     void set_frame_memory(const uint8_t* image_buffer, uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end);
 
+    /**
+     * @brief Set the frame memory in several windows of the provided image buffer.
+     * Every window costs commands 0x44, 0x45, 0x4E and 0x4F before its image data.
+     * @param image_buffer Pointer to the image buffer to be displayed.
+     * @param windows Array of windows to upload.
+     * @param count Number of windows.
+     */
+    void set_frame_memory(const uint8_t* image_buffer, const Window* windows, uint8_t count);
+
+    /**
+     * @brief Estimate cost of uploading one window at the current SPI clock.
+     * Window setup is 14 command and data bytes in 5 transactions, every row of image data
+     * is one more transaction. In rotation 1 and 3 rows of the panel are columns of the window,
+     * both sides are aligned to 8 pixels and every column is one transaction.
+     * @param window Window to upload.
+     * @return Estimated time in microseconds.
+     */
+    uint32_t upload_cost(const Window& window) const;
+
     /**
      * @brief Clear the display frame with a specific color.
      * This function fills the entire display with the specified color.
@@ -161,6 +256,25 @@ public:
      */
     void clear_frame(EinkColor color);
 
+    /**
+     * @brief Fill a window of the display memory with a color.
+     * Controller has no command filling its memory with a pattern, so the color is streamed
+     * in a single SPI transaction.
+     * @param window Window in coordinates of the rotated screen, it is aligned to whole bytes.
+     * @param color The color to fill the window with (BLACK or WHITE).
+     */
+    void fill_window(const Window& window, EinkColor color);
+
+    /**
+     * @brief Set orientation of the frame buffers passed to the driver.
+     * Rotation by 180 degrees is done by the controller itself, data entry mode is set to
+     * decrement both X and Y address counters. Rotation by 90 and 270 degrees transposes
+     * uploaded window in 8x8 pixel blocks.
+     * Takes effect with the next call of init().
+     * @param rotation Rotation in steps of 90 degrees clockwise (0-3).
+     */
+    void set_rotation(uint8_t rotation);
+
     /**
      * @brief Clear the display frame.
      * This function fills the entire display with white color.
@@ -174,6 +288,14 @@ public:
      */
     void sleep();
 
+    /**
+     * @brief Get duration of the last display_frame(), measured on the busy pin.
+     * @return Duration in milliseconds.
+     */
+    uint32_t get_busy_time() const {
+        return m_busy_time;
+    }
+
     /**
      * @brief Get the width of the display.
      * @return The width of the display in pixels.
@@ -193,7 +315,31 @@ public:
     static constexpr uint16_t M_WIDTH = 200;
     static constexpr uint16_t M_HEIGHT = 200;
 
+    /// Estimated fixed overhead of one SPI transaction (CS and DC toggling, driver call) in microseconds
+    static constexpr uint16_t M_TRANSACTION_OVERHEAD_US = 5;
+
 private:
+    /**
+     * @brief Prepare controller for writing into RAM window given in panel coordinates.
+     * Sets window and cursor according to current data entry mode and sends WRITE_RAM command.
+     * @param x_start Start x coordinate, multiple of 8
+     * @param y_start Start y coordinate
+     * @param x_end End x coordinate, multiple of 8 minus 1
+     * @param y_end End y coordinate
+     */
+    void begin_ram_write(uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end);
+
+    /**
+     * @brief Upload window of buffer rotated by 90 or 270 degrees.
+     * Coordinates are in logical (rotated) space and must be aligned to 8 pixels.
+     * @param image_buffer Pointer to the image buffer in logical layout.
+     * @param x_start Start x coordinate
+     * @param y_start Start y coordinate
+     * @param x_end End x coordinate, exclusive
+     * @param y_end End y coordinate, exclusive
+     */
+    void set_frame_memory_transposed(const uint8_t* image_buffer, uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end);
+
     /**
      * @brief Set the window for drawing.
      * @param x_start Start x coordinate
@@ -218,11 +364,15 @@ private:
 
     /**
      * @brief Blocking wait until the display is idle.
+     * @return Time spent waiting in milliseconds.
      */
-    void wait_until_idle();
+    uint32_t wait_until_idle();
 
     uint8_t m_epd_rst;
     uint8_t m_epd_busy;
+    uint8_t m_rotation = 0;
+    int8_t m_temperature = 20;
+    uint32_t m_busy_time = 0;
     EinkSPI::SPIController& m_SPI_controller;
 };
 
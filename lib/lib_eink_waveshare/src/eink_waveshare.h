@@ -2,6 +2,24 @@
 
 #include <Arduino.h>
 #include "eink_driver.h"
+#include "init_script.h"
+#include "canvas_bw.h"
 #include "spi_controller.h"
 #include "my_utils.h"
+#include "frame_store.h"
+#include "tile_hashes.h"
+#include "text_format.h"
+#include "compact_font.h"
+#include "polygon.h"
+#include "text_layout.h"
+#include "refresh_profiler.h"
+#include "dithering.h"
+#include "image_decoder.h"
+#include "compositor.h"
+#include "pixel_convert.h"
+#include "time_plot.h"
+#include "draw_log.h"
+#include "draw_queue.h"
+#include "frame_stream.h"
+#include "surface_arena.h"
 #include "display_wrapper.h"
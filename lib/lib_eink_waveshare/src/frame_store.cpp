@@ -0,0 +1,87 @@
+#include "frame_store.h"
+
+namespace EinkDisplay {
+
+namespace {
+
+constexpr uint32_t FRAME_MAGIC = 0x454B4652; // "EKFR"
+
+/**
+ * @brief Header stored in front of the frame.
+ */
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t hash;
+    uint8_t refresh_number;
+};
+
+/**
+ * @brief Frame kept in RTC slow memory, survives deep sleep but not power loss.
+ */
+struct RtcFrame {
+    FrameHeader header;
+    uint8_t data[RtcFrameStore::M_CAPACITY];
+};
+
+RTC_NOINIT_ATTR RtcFrame rtc_frame;
+
+} // namespace
+
+
+bool RtcFrameStore::load(uint8_t* frame, size_t size, uint8_t& refresh_number) {
+    if (rtc_frame.header.magic != FRAME_MAGIC || rtc_frame.header.size != size || size > M_CAPACITY) {
+        debug::Print("No frame in RTC memory.\n");
+        return false;
+    }
+    if (fnv1a(rtc_frame.data, size) != rtc_frame.header.hash) {
+        debug::Print("Frame in RTC memory is corrupted.\n");
+        return false;
+    }
+    memcpy(frame, rtc_frame.data, size);
+    refresh_number = rtc_frame.header.refresh_number;
+    return true;
+}
+
+void RtcFrameStore::save(const uint8_t* frame, size_t size, uint8_t refresh_number) {
+    if (size > M_CAPACITY) {
+        debug::Print("Frame does not fit into RTC memory.\n");
+        return;
+    }
+    memcpy(rtc_frame.data, frame, size);
+    rtc_frame.header = {FRAME_MAGIC, (uint32_t)size, fnv1a(frame, size), refresh_number};
+}
+
+
+bool FileFrameStore::load(uint8_t* frame, size_t size, uint8_t& refresh_number) {
+    fs::File file = m_fs.open(m_path, "r");
+    if (!file) {
+        debug::Print("No frame file.\n");
+        return false;
+    }
+    FrameHeader header;
+    bool valid = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                 header.magic == FRAME_MAGIC && header.size == size &&
+                 file.read(frame, size) == size && fnv1a(frame, size) == header.hash;
+    file.close();
+    if (!valid) {
+        debug::Print("Frame file is not valid.\n");
+        return false;
+    }
+    refresh_number = header.refresh_number;
+    return true;
+}
+
+void FileFrameStore::save(const uint8_t* frame, size_t size, uint8_t refresh_number) {
+    fs::File file = m_fs.open(m_path, "w");
+    if (!file) {
+        debug::Print("Cannot open frame file.\n");
+        return;
+    }
+    FrameHeader header = {FRAME_MAGIC, (uint32_t)size, fnv1a(frame, size), refresh_number};
+    file.write((const uint8_t*)&header, sizeof(header));
+    file.write(frame, size);
+    file.close();
+}
+
+} // namespace EinkDisplay
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "my_utils.h"
+
+namespace EinkDisplay{
+
+/**
+ * @brief Computes 32-bit FNV-1a hash of the data.
+ * @param data Pointer to the data.
+ * @param size Number of bytes to hash.
+ * @param hash Starting value, allows hashing of data in multiple chunks.
+ * @return The hash of the data.
+ */
+inline uint32_t fnv1a(const uint8_t* data, size_t size, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @class FrameStore
+ * @brief Interface for storage keeping the last displayed frame across deep sleep.
+ *
+ * The display keeps its image without power, but the microcontroller forgets it while sleeping.
+ * Frame store keeps copy of the displayed frame, so after wake up only real differences
+ * have to be refreshed.
+ */
+class FrameStore {
+public:
+    virtual ~FrameStore() = default;
+
+    /**
+     * @brief Load the stored frame.
+     * @param frame Buffer to load the frame into.
+     * @param size Size of the frame in bytes.
+     * @param refresh_number Number of partial refreshes done since the last full one.
+     * @return true if stored frame is valid and has the requested size, false otherwise.
+     */
+    virtual bool load(uint8_t* frame, size_t size, uint8_t& refresh_number) = 0;
+
+    /**
+     * @brief Store the frame.
+     * @param frame Pointer to the frame.
+     * @param size Size of the frame in bytes.
+     * @param refresh_number Number of partial refreshes done since the last full one.
+     */
+    virtual void save(const uint8_t* frame, size_t size, uint8_t refresh_number) = 0;
+};
+
+/**
+ * @class RtcFrameStore
+ * @brief Keeps the frame in RTC slow memory of ESP32, which is powered during deep sleep.
+ *
+ * Memory is not initialized on boot, so content is validated by hash. After power loss
+ * loading fails and the display has to be cleared. All instances share the same memory.
+ * @note RTC slow memory has 8 kB, frame of 200x200 display takes 5000 bytes.
+ */
+class RtcFrameStore: public FrameStore {
+public:
+    bool load(uint8_t* frame, size_t size, uint8_t& refresh_number) override;
+    void save(const uint8_t* frame, size_t size, uint8_t refresh_number) override;
+
+    static constexpr size_t M_CAPACITY = 5000;
+};
+
+/**
+ * @class FileFrameStore
+ * @brief Keeps the frame in a file, e.g. on LittleFS flash partition.
+ *
+ * File holds small header with hash of the frame followed by the frame itself.
+ * @note Every displayed frame is written to flash, so mind wear of the flash for frequent updates.
+ */
+class FileFrameStore: public FrameStore {
+public:
+    /**
+     * @brief Constructor for the FileFrameStore class.
+     * @param fs Mounted filesystem.
+     * @param path Path of the file, string has to outlive the store.
+     */
+    FileFrameStore(fs::FS& fs, const char* path): m_fs(fs), m_path(path) {}
+
+    bool load(uint8_t* frame, size_t size, uint8_t& refresh_number) override;
+    void save(const uint8_t* frame, size_t size, uint8_t refresh_number) override;
+
+private:
+    fs::FS& m_fs;
+    const char* m_path;
+};
+
+} // namespace EinkDisplay
@@ -0,0 +1,172 @@
+#include "frame_stream.h"
+
+#include "my_utils.h"
+
+namespace EinkDisplay {
+
+namespace {
+
+constexpr uint8_t M_SYNC[2] = {0xA5, 0x5A};
+constexpr uint8_t M_TILE_HEADER = 6;
+
+/**
+ * @brief Fletcher-16 checksum, sums are continued from the previous value.
+ */
+uint16_t fletcher16(const uint8_t* data, uint16_t length, uint16_t checksum = 0) {
+    uint16_t low = checksum & 0xFF;
+    uint16_t high = checksum >> 8;
+    for (uint16_t i = 0; i < length; i++) {
+        low = (low + data[i]) % 255;
+        high = (high + low) % 255;
+    }
+    return (high << 8) | low;
+}
+
+/**
+ * @brief Decode run-length encoded delta, XOR is applied only if buffer is not null.
+ * @return Number of decoded bytes, or -1 if the encoding is malformed.
+ */
+int32_t decode_delta(const uint8_t* data, uint16_t length, uint8_t* buffer, uint16_t stride,
+                     uint16_t x_byte, uint16_t y, uint16_t width) {
+    uint32_t position = 0;
+    uint16_t i = 0;
+    while (i < length) {
+        const uint8_t control = data[i++];
+        const bool literal = control & 0x80;
+        const bool repeat = !literal && (control & 0x40);
+        const uint8_t count = (literal ? control & 0x7F : control & 0x3F) + 1;
+        if ((literal && length - i < count) || (repeat && i == length)) {
+            return -1;
+        }
+        if (buffer == nullptr || (!literal && !repeat)) {
+            i += literal ? count : (repeat ? 1 : 0);
+            position += count;
+            continue;
+        }
+        for (uint8_t k = 0; k < count; k++, position++) {
+            const uint32_t index = (uint32_t)(y + position / width) * stride + x_byte + position % width;
+            buffer[index] ^= literal ? data[i + k] : data[i];
+        }
+        i += literal ? count : 1;
+    }
+    return position;
+}
+
+} // namespace
+
+FrameReceiver::FrameReceiver(Stream& stream, uint16_t max_payload):
+    m_stream(stream), m_max_payload(max_payload) {
+    m_payload = new uint8_t[max_payload];
+}
+
+FrameReceiver::~FrameReceiver() {
+    delete[] m_payload;
+}
+
+bool FrameReceiver::poll(Packet& packet) {
+    while (m_stream.available() > 0) {
+        const int c = m_stream.read();
+        if (c < 0) {
+            break;
+        }
+        m_bytes_received++;
+        const uint8_t byte = c;
+        switch (m_state) {
+        case State::SYNC:
+            if (byte == M_SYNC[0]) m_state = State::SYNC_SECOND;
+            break;
+        case State::SYNC_SECOND:
+            m_state = byte == M_SYNC[1] ? State::HEADER : (byte == M_SYNC[0] ? State::SYNC_SECOND : State::SYNC);
+            m_received = 0;
+            break;
+        case State::HEADER:
+            m_header[m_received++] = byte;
+            if (m_received == sizeof(m_header)) {
+                const uint16_t length = m_header[1] | (m_header[2] << 8);
+                if (length > m_max_payload) {
+                    debug::Print("Packet is too long.\n");
+                    reject();
+                    break;
+                }
+                m_received = 0;
+                m_state = length == 0 ? State::CHECKSUM : State::PAYLOAD;
+            }
+            break;
+        case State::PAYLOAD:
+            m_payload[m_received++] = byte;
+            if (m_received == (m_header[1] | (m_header[2] << 8))) {
+                m_received = 0;
+                m_state = State::CHECKSUM;
+            }
+            break;
+        case State::CHECKSUM:
+            m_checksum[m_received++] = byte;
+            if (m_received == sizeof(m_checksum)) {
+                const uint16_t length = m_header[1] | (m_header[2] << 8);
+                const uint16_t checksum = fletcher16(m_payload, length, fletcher16(m_header, sizeof(m_header)));
+                if (checksum != (m_checksum[0] | (m_checksum[1] << 8))) {
+                    debug::Print("Packet checksum does not match.\n");
+                    reject();
+                    break;
+                }
+                m_state = State::SYNC;
+                if (m_resync && m_header[0] != (uint8_t)PacketType::RESET) {
+                    // Rest of the rejected frame
+                    break;
+                }
+                m_resync = false;
+                packet = {(PacketType)m_header[0], m_payload, length};
+                return true;
+            }
+            break;
+        }
+    }
+    return false;
+}
+
+void FrameReceiver::acknowledge(bool ok) {
+    if (ok) {
+        m_stream.write(M_ACK);
+        return;
+    }
+    m_errors++;
+    // Host gets a single answer per frame, it is not confused by answers to the rest of it
+    if (!m_resync) {
+        m_stream.write(M_NAK);
+        m_resync = true;
+    }
+}
+
+void FrameReceiver::reject() {
+    m_state = State::SYNC;
+    acknowledge(false);
+}
+
+bool apply_tile(const uint8_t* payload, uint16_t length, uint8_t* buffer, uint16_t stride, uint16_t rows,
+                uint16_t& x0, uint16_t& y0, uint16_t& x1, uint16_t& y1) {
+    if (length < M_TILE_HEADER) {
+        return false;
+    }
+    const uint16_t x_byte = payload[0];
+    const uint16_t y = payload[1] | (payload[2] << 8);
+    const uint16_t width = payload[3];
+    const uint16_t height = payload[4] | (payload[5] << 8);
+    if (width == 0 || height == 0 || x_byte + width > stride || y + height > rows) {
+        debug::Print("Tile is outside of the frame.\n");
+        return false;
+    }
+    const uint8_t* data = payload + M_TILE_HEADER;
+    const uint16_t data_length = length - M_TILE_HEADER;
+    if (decode_delta(data, data_length, nullptr, stride, x_byte, y, width) != (int32_t)width * height) {
+        debug::Print("Tile is malformed.\n");
+        return false;
+    }
+    decode_delta(data, data_length, buffer, stride, x_byte, y, width);
+    x0 = x_byte * 8;
+    y0 = y;
+    x1 = (x_byte + width) * 8 - 1;
+    y1 = y + height - 1;
+    return true;
+}
+
+} // namespace EinkDisplay
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace EinkDisplay{
+
+/**
+ * @brief Type of a packet of the frame stream.
+ */
+enum class PacketType : uint8_t {
+    TILE = 1,  ///< XOR delta of a rectangle against the previous frame, run-length encoded
+    END = 2,   ///< Frame is complete, payload is the refresh mode, device answers by ACK
+    RESET = 3  ///< Canvas is filled by a color in payload, following deltas are against it
+};
+
+/**
+ * @brief Packet of the frame stream, its payload is owned by the receiver.
+ */
+struct Packet {
+    PacketType type;
+    const uint8_t* payload;
+    uint16_t length;
+};
+
+/**
+ * @class FrameReceiver
+ * @brief Receives frames rendered on a host as delta-compressed tiles, e.g. over Serial.
+ *
+ * Every packet is sync bytes 0xA5 0x5A, type, payload length (16-bit little endian),
+ * payload and Fletcher-16 checksum of type, length and payload (little endian).
+ *
+ * Payload of TILE is x in bytes, y (16-bit), width in bytes, height (16-bit) and encoded
+ * XOR of the tile with the previous frame, row by row. Encoding is a sequence of:
+ * - 00nnnnnn: n + 1 unchanged bytes
+ * - 01nnnnnn b: n + 1 bytes b
+ * - 1nnnnnnn b...: n + 1 literal bytes
+ *
+ * Device answers ACK (0x06) after END is applied and NAK (0x15) for a corrupted packet.
+ * Packets following the NAK are dropped without answer, host has to start again by RESET
+ * and a whole frame, see tools/frame_stream_send.py.
+ */
+class FrameReceiver {
+public:
+    static constexpr uint8_t M_ACK = 0x06;
+    static constexpr uint8_t M_NAK = 0x15;
+
+    /**
+     * @brief Construct a new receiver.
+     *
+     * @param stream Stream with packets, answers are written into it.
+     * @param max_payload Longest accepted payload, longer packets are rejected.
+     */
+    FrameReceiver(Stream& stream, uint16_t max_payload = 1024);
+
+    ~FrameReceiver();
+
+    FrameReceiver(const FrameReceiver&) = delete;
+    FrameReceiver& operator=(const FrameReceiver&) = delete;
+
+    /**
+     * @brief Read available bytes without blocking until a packet is complete.
+     *
+     * Corrupted packets are answered by NAK and skipped, then packets are skipped until RESET.
+     * @param packet Output packet, valid until the next call.
+     * @return true if a packet was received, false if more bytes are needed.
+     */
+    bool poll(Packet& packet);
+
+    /**
+     * @brief Answer the last packet.
+     *
+     * @param ok true for ACK, false for NAK, packets are then skipped until RESET.
+     */
+    void acknowledge(bool ok);
+
+    /**
+     * @brief Get number of received bytes, including rejected packets.
+     */
+    uint32_t get_bytes_received() const {
+        return m_bytes_received;
+    }
+
+    /**
+     * @brief Get number of rejected packets.
+     */
+    uint32_t get_errors() const {
+        return m_errors;
+    }
+
+private:
+    enum class State : uint8_t {
+        SYNC,
+        SYNC_SECOND,
+        HEADER,
+        PAYLOAD,
+        CHECKSUM
+    };
+
+    void reject();
+
+    Stream& m_stream;
+    uint8_t* m_payload;
+    uint16_t m_max_payload;
+    State m_state = State::SYNC;
+    uint8_t m_header[3];
+    uint8_t m_checksum[2];
+    uint16_t m_received = 0;
+    uint32_t m_bytes_received = 0;
+    uint32_t m_errors = 0;
+    bool m_resync = false;
+};
+
+/**
+ * @brief Apply a TILE payload to a frame buffer.
+ *
+ * Payload is checked first, the buffer is changed only if the whole tile is valid.
+ * @param payload Payload of the packet.
+ * @param length Length of the payload.
+ * @param buffer Frame buffer, 1 bit per pixel.
+ * @param stride Bytes per row of the buffer.
+ * @param rows Number of rows of the buffer.
+ * @param x0 Output left column of the tile in pixels.
+ * @param y0 Output top row of the tile.
+ * @param x1 Output right column of the tile in pixels, inclusive.
+ * @param y1 Output bottom row of the tile, inclusive.
+ * @return true if the tile was applied, false if it is malformed or outside of the buffer.
+ */
+bool apply_tile(const uint8_t* payload, uint16_t length, uint8_t* buffer, uint16_t stride, uint16_t rows,
+                uint16_t& x0, uint16_t& y0, uint16_t& x1, uint16_t& y1);
+
+} // namespace EinkDisplay
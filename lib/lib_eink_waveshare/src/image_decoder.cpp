@@ -0,0 +1,164 @@
+#include "image_decoder.h"
+
+#include <algorithm>
+
+namespace EinkDisplay {
+
+namespace {
+
+constexpr uint8_t BMP_FILE_HEADER_SIZE = 14;
+constexpr uint8_t BMP_INFO_HEADER_SIZE = 40;
+
+inline uint16_t read_le16(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+}
+
+inline uint32_t read_le32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/**
+ * @brief Check if BGRA palette entry is closer to white than to black.
+ */
+inline bool is_light(const uint8_t* entry) {
+    // Integer approximation of luma
+    return (entry[0] * 29 + entry[1] * 150 + entry[2] * 77) >= 128 * 256;
+}
+
+} // namespace
+
+
+bool ImageDecoder::read_header() {
+    m_rows_read = 0;
+    m_row_offset = 0;
+    uint8_t magic[2];
+    if (m_file.read(magic, sizeof(magic)) != sizeof(magic)) {
+        debug::Print("Image file is empty.\n");
+        return false;
+    }
+    if (magic[0] == 'P' && magic[1] == '4') {
+        return read_pbm_header();
+    }
+    if (magic[0] == 'B' && magic[1] == 'M') {
+        return read_bmp_header();
+    }
+    debug::Print("Unsupported image format.\n");
+    return false;
+}
+
+bool ImageDecoder::read_pbm_number(uint16_t& value) {
+    int c = m_file.read();
+    // Skip whitespace and comments
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '#') {
+        if (c == '#') {
+            while (c >= 0 && c != '\n') c = m_file.read();
+        }
+        c = m_file.read();
+    }
+    if (c < '0' || c > '9') {
+        return false;
+    }
+    uint32_t number = 0;
+    while (c >= '0' && c <= '9') {
+        number = number * 10 + (c - '0');
+        if (number > UINT16_MAX) {
+            return false;
+        }
+        c = m_file.read();
+    }
+    value = number;
+    // Single whitespace after the number was consumed, pixels start after the height
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool ImageDecoder::read_pbm_header() {
+    if (!read_pbm_number(m_width) || !read_pbm_number(m_height) || m_width == 0) {
+        debug::Print("Invalid PBM header.\n");
+        return false;
+    }
+    m_row_bytes = (m_width + 7) / 8;
+    m_row_padding = 0;
+    m_and = 0xFF;
+    m_xor = 0xFF; // 1 is black in PBM
+    m_bottom_up = false;
+    return true;
+}
+
+bool ImageDecoder::read_bmp_header() {
+    uint8_t header[BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE - 2];
+    if (m_file.read(header, sizeof(header)) != sizeof(header)) {
+        debug::Print("BMP header is truncated.\n");
+        return false;
+    }
+    // Offsets are from the start of the file, first two bytes were already read
+    const uint8_t* info = header + BMP_FILE_HEADER_SIZE - 2;
+    const uint32_t data_offset = read_le32(header + 8);
+    const uint32_t info_size = read_le32(info);
+    const int32_t width = read_le32(info + 4);
+    const int32_t height = read_le32(info + 8);
+    const uint16_t bits_per_pixel = read_le16(info + 14);
+    const uint32_t compression = read_le32(info + 16);
+
+    if (info_size < BMP_INFO_HEADER_SIZE || bits_per_pixel != 1 || compression != 0) {
+        debug::Print("Only uncompressed 1-bit BMP is supported.\n");
+        return false;
+    }
+    if (width <= 0 || width > UINT16_MAX || height == 0 || height > UINT16_MAX || height < -UINT16_MAX) {
+        debug::Print("Invalid BMP size.\n");
+        return false;
+    }
+
+    uint8_t palette[8];
+    if (!m_file.seek(BMP_FILE_HEADER_SIZE + info_size) || m_file.read(palette, sizeof(palette)) != sizeof(palette)) {
+        debug::Print("BMP palette is missing.\n");
+        return false;
+    }
+    const bool light0 = is_light(palette);
+    const bool light1 = is_light(palette + 4);
+    // Bit selects palette entry, masks map it to 1 for white, or both entries to the same color
+    m_and = light0 == light1 ? 0x00 : 0xFF;
+    m_xor = light0 ? 0xFF : 0x00;
+
+    if (!m_file.seek(data_offset)) {
+        debug::Print("BMP pixel data is missing.\n");
+        return false;
+    }
+    m_width = width;
+    m_height = height < 0 ? -height : height;
+    m_bottom_up = height > 0;
+    m_row_bytes = (m_width + 7) / 8;
+    m_row_padding = (4 - m_row_bytes % 4) % 4;
+    return true;
+}
+
+bool ImageDecoder::next_chunk(ImageChunk& chunk) {
+    if (m_rows_read >= m_height) {
+        return false;
+    }
+    const uint16_t length = std::min<uint16_t>(M_CHUNK_SIZE, m_row_bytes - m_row_offset);
+    if (m_file.read(m_buffer, length) != length) {
+        debug::Print("Image data is truncated.\n");
+        return false;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        m_buffer[i] = (m_buffer[i] & m_and) ^ m_xor;
+    }
+
+    chunk.row = m_bottom_up ? m_height - 1 - m_rows_read : m_rows_read;
+    chunk.x = m_row_offset * 8;
+    chunk.width = std::min<uint16_t>(length * 8, m_width - chunk.x);
+    chunk.bits = m_buffer;
+
+    m_row_offset += length;
+    if (m_row_offset == m_row_bytes) {
+        m_row_offset = 0;
+        m_rows_read++;
+        if (m_row_padding > 0) {
+            uint8_t padding[3];
+            m_file.read(padding, m_row_padding);
+        }
+    }
+    return true;
+}
+
+} // namespace EinkDisplay
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "my_utils.h"
+
+namespace EinkDisplay{
+
+/**
+ * @brief Part of an image row decoded by ImageDecoder.
+ */
+struct ImageChunk {
+    uint16_t row;       ///< Row in the image, 0 is the top row
+    uint16_t x;         ///< Column of the first pixel, always multiple of 8
+    uint16_t width;     ///< Number of pixels
+    const uint8_t* bits; ///< Packed pixels, MSB is the leftmost pixel, 1 is white
+};
+
+/**
+ * @class ImageDecoder
+ * @brief Streaming decoder of black and white images from a file.
+ *
+ * Supported formats are binary PBM (P4) and uncompressed 1-bit BMP, both top-down and bottom-up.
+ * Pixels are read in chunks of at most M_CHUNK_SIZE bytes into a fixed buffer, so memory does
+ * not depend on size of the image. Bits are converted to the canvas convention, 1 is white.
+ *
+ * Usage example:
+ * @code
+ * fs::File file = LittleFS.open("/logo.bmp", "r");
+ * EinkDisplay::ImageDecoder decoder(file);
+ * EinkDisplay::ImageChunk chunk;
+ * if (decoder.read_header()) {
+ *     while (decoder.next_chunk(chunk)) {
+ *         canvas.writeRow(chunk.x, chunk.row, chunk.bits, chunk.width);
+ *     }
+ * }
+ * @endcode
+ */
+class ImageDecoder {
+public:
+    /**
+     * @brief Constructor for the ImageDecoder class.
+     * @param file Opened image file, it has to outlive the decoder.
+     */
+    explicit ImageDecoder(fs::File& file) : m_file(file) {}
+
+    /**
+     * @brief Read header of the image and move to the pixel data.
+     * @return true if the image is in supported format, false otherwise.
+     */
+    bool read_header();
+
+    /**
+     * @brief Read next chunk of pixels, rows are read in order they are stored in the file.
+     * @param chunk Output chunk, its bits are valid until the next call.
+     * @return true if chunk was read, false at the end of the image or on read error.
+     */
+    bool next_chunk(ImageChunk& chunk);
+
+    /**
+     * @brief Check if all pixels of the image were read.
+     * @return true if the whole image was read.
+     */
+    bool is_complete() const {
+        return m_rows_read == m_height;
+    }
+
+    /**
+     * @brief Get width of the image, valid after read_header().
+     * @return The width in pixels.
+     */
+    uint16_t width() const {
+        return m_width;
+    }
+
+    /**
+     * @brief Get height of the image, valid after read_header().
+     * @return The height in pixels.
+     */
+    uint16_t height() const {
+        return m_height;
+    }
+
+    /// Size of the read buffer in bytes
+    static constexpr uint8_t M_CHUNK_SIZE = 64;
+
+private:
+    bool read_pbm_header();
+    bool read_bmp_header();
+    bool read_pbm_number(uint16_t& value);
+
+    fs::File& m_file;
+    uint8_t m_buffer[M_CHUNK_SIZE];
+    uint16_t m_width = 0;
+    uint16_t m_height = 0;
+    uint16_t m_row_bytes = 0;    ///< Bytes of pixels in a row
+    uint8_t m_row_padding = 0;   ///< Bytes after pixels of each row
+    uint8_t m_and = 0xFF;        ///< Mask applied to read bytes, 0 if both colors are same
+    uint8_t m_xor = 0;           ///< Mask applied after m_and to get 1 for white
+    bool m_bottom_up = false;
+    uint16_t m_rows_read = 0;
+    uint16_t m_row_offset = 0;   ///< Bytes of the current row already read
+};
+
+} // namespace EinkDisplay
@@ -0,0 +1,49 @@
+#include "init_script.h"
+
+#include "my_utils.h"
+
+namespace EinkDriver {
+
+bool Script::run(EinkSPI::SPIController& spi, uint8_t busy, const uint8_t* script, size_t size) {
+    const uint8_t* end = script + size;
+    spi.beginTransfer();
+    while (script < end) {
+        if (end - script < 2) {
+            debug::Print("Script is truncated.\n");
+            spi.endTransfer();
+            return false;
+        }
+        const uint8_t command = script[0];
+        const uint8_t flags = script[1];
+        const uint8_t length = flags & LENGTH;
+        script += 2;
+        if (end - script < length + ((flags & DELAY) ? 1 : 0)) {
+            debug::Print("Script is truncated.\n");
+            spi.endTransfer();
+            return false;
+        }
+        spi.writeCommand(command);
+        spi.writeData(script, length);
+        script += length;
+        if (!(flags & (DELAY | WAIT))) {
+            continue;
+        }
+        spi.endTransfer();
+        if (flags & DELAY) {
+            delay(*script++);
+        }
+        if (flags & WAIT) {
+            while (digitalRead(busy) == HIGH) {
+                delay(1);
+            }
+        }
+        if (script == end) {
+            return true;
+        }
+        spi.beginTransfer();
+    }
+    spi.endTransfer();
+    return true;
+}
+
+} // namespace EinkDriver
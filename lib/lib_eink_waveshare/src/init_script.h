@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "spi_controller.h"
+
+namespace EinkDriver{
+
+/**
+ * @brief Command scripts of panel controllers.
+ *
+ * Script is a constexpr byte array in flash, e.g. initialization of a panel or switch of
+ * its waveform. Every entry is a command byte, a length byte and the data:
+ * @code
+ * constexpr uint8_t INIT_SCRIPT[] = {
+ *     0x0C, 3, 0xD7, 0xD6, 0x9D,              // BOOSTER_SOFT_START_CONTROL
+ *     0x22, 1 | Script::DELAY, 0xC4, 10,      // DISPLAY_UPDATE_CONTROL_2, then 10 ms delay
+ *     0x20, 0 | Script::WAIT,                 // MASTER_ACTIVATION, then wait for busy pin
+ * };
+ * @endcode
+ * Consecutive commands are sent in a single transfer, chip select is released only
+ * for delays and waiting.
+ */
+namespace Script {
+
+constexpr uint8_t LENGTH = 0x3F; ///< Mask of the data length in the length byte
+constexpr uint8_t DELAY = 0x40;  ///< Flag of the length byte, delay in milliseconds follows the data
+constexpr uint8_t WAIT = 0x80;   ///< Flag of the length byte, wait until the busy pin is low after the command
+
+/**
+ * @brief Send a script to the controller.
+ *
+ * @param spi The SPI controller of the panel.
+ * @param busy Busy pin of the panel, high while the controller is busy.
+ * @param script The script.
+ * @param size Size of the script in bytes.
+ * @return true if the whole script was sent, false if it is malformed.
+ */
+bool run(EinkSPI::SPIController& spi, uint8_t busy, const uint8_t* script, size_t size);
+
+/**
+ * @brief Send a script to the controller.
+ */
+template <size_t N>
+bool run(EinkSPI::SPIController& spi, uint8_t busy, const uint8_t (&script)[N]) {
+    return run(spi, busy, script, N);
+}
+
+} // namespace Script
+
+} // namespace EinkDriver
@@ -1,6 +1,45 @@
 #include "my_utils.h"
 
-void debug::Print(const char* msg) {
-    if(DEBUG)
-        Serial.print(msg);
-}
\ No newline at end of file
+namespace trace {
+
+#if EINK_TRACE_LEVEL >= 1
+namespace {
+
+Record records[EINK_TRACE_CAPACITY];
+uint32_t written = 0;
+
+} // namespace
+
+void detail::push(Event event, uint8_t arg, uint16_t a, uint16_t b, uint16_t c, uint16_t d) {
+    Record& record = records[written % EINK_TRACE_CAPACITY];
+    record = {(uint32_t)micros(), (uint16_t)written, (uint8_t)event, arg, {a, b, c, d}};
+    written++;
+}
+#endif
+
+void dump(Print& out) {
+    const uint16_t version = 1;
+    const uint16_t record_size = sizeof(Record);
+    uint32_t count = 0;
+#if EINK_TRACE_LEVEL >= 1
+    count = written < EINK_TRACE_CAPACITY ? written : EINK_TRACE_CAPACITY;
+#endif
+    out.write((const uint8_t*)"EKTR", 4);
+    out.write((const uint8_t*)&version, sizeof(version));
+    out.write((const uint8_t*)&record_size, sizeof(record_size));
+    out.write((const uint8_t*)&count, sizeof(count));
+#if EINK_TRACE_LEVEL >= 1
+    const uint32_t first = written - count;
+    for (uint32_t i = first; i < first + count; i++) {
+        out.write((const uint8_t*)&records[i % EINK_TRACE_CAPACITY], sizeof(Record));
+    }
+#endif
+}
+
+void clear() {
+#if EINK_TRACE_LEVEL >= 1
+    written = 0;
+#endif
+}
+
+} // namespace trace
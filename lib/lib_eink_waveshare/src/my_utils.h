@@ -2,16 +2,99 @@
 
 #include <Arduino.h>
 
-#define DEBUG true
+/**
+ * Trace level of the library, set it by build flag, e.g. -D EINK_TRACE_LEVEL=1
+ * - 0: nothing is traced and no code is generated
+ * - 1: binary events are logged into ring buffer in RAM
+ * - 2: events are logged and text messages are printed to the serial console
+ */
+#ifndef EINK_TRACE_LEVEL
+#define EINK_TRACE_LEVEL 0
+#endif
+
+/// Number of events kept in the ring buffer
+#ifndef EINK_TRACE_CAPACITY
+#define EINK_TRACE_CAPACITY 128
+#endif
 
 
 namespace debug{
 
 /**
- * @brief Prints a message to the serial console if DEBUG macro is defined to true.
+ * @brief Prints a message to the serial console if EINK_TRACE_LEVEL is at least 2.
+ * On lower levels the call generates no code.
  * @note Serial communication must be initialized before calling this function.
  */
-void Print(const char* msg);
+inline void Print(const char* msg) {
+    if constexpr (EINK_TRACE_LEVEL >= 2) {
+        Serial.print(msg);
+    }
+}
+
+}
+
+
+namespace trace{
+
+/**
+ * @brief Type of a traced event.
+ */
+enum class Event : uint8_t {
+    UPLOAD_START = 1, ///< Upload of a window started, data is the window
+    UPLOAD_END,       ///< Upload finished
+    BUSY_START,       ///< Refresh triggered, waiting for the busy pin
+    BUSY_END,         ///< Refresh finished, data[0] is busy time in milliseconds
+    REFRESH,          ///< display_frame() refreshes, arg is the waveform, data is the bounding box
+    UNCHANGED,        ///< display_frame() skipped, nothing changed
+    CLEAR             ///< clear_frame(), arg is the color
+};
+
+/**
+ * @brief One event in the ring buffer, 16 bytes.
+ */
+struct Record {
+    uint32_t time;     ///< Timestamp in microseconds
+    uint16_t sequence; ///< Sequence number of the event, gaps mean overwritten events
+    uint8_t event;     ///< Event type
+    uint8_t arg;       ///< Event argument
+    uint16_t data[4];  ///< Event data
+};
 
+namespace detail {
+
+/**
+ * @brief Store event into the ring buffer.
+ */
+void push(Event event, uint8_t arg, uint16_t a, uint16_t b, uint16_t c, uint16_t d);
+
+} // namespace detail
+
+/**
+ * @brief Log an event if EINK_TRACE_LEVEL is at least 1, otherwise no code is generated.
+ * @param event Type of the event.
+ * @param arg Event argument.
+ * @param a First data word.
+ * @param b Second data word.
+ * @param c Third data word.
+ * @param d Fourth data word.
+ */
+inline void log(Event event, uint8_t arg = 0, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0, uint16_t d = 0) {
+    if constexpr (EINK_TRACE_LEVEL >= 1) {
+        detail::push(event, arg, a, b, c, d);
+    }
+}
+
+/**
+ * @brief Write content of the ring buffer in binary form, oldest event first.
+ * Output starts with magic "EKTR", version, size of record and number of records
+ * followed by the records. It can be decoded by tools/trace_decode.py.
+ * @param out Output, e.g. Serial.
+ */
+void dump(Print& out);
+
+/**
+ * @brief Remove all events from the ring buffer.
+ */
+void clear();
 
 }
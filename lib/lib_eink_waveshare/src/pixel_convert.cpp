@@ -0,0 +1,68 @@
+#include "pixel_convert.h"
+
+namespace EinkCanvas {
+
+namespace {
+
+/**
+ * @brief Pack 8 results of comparison, first one into MSB.
+ */
+inline uint8_t pack8(const uint8_t* values, uint8_t threshold) {
+    uint8_t out = 0;
+    for (uint8_t b = 0; b < 8; b++) {
+        out |= (uint8_t)(values[b] >= threshold) << (7 - b);
+    }
+    return out;
+}
+
+/**
+ * @brief Luma of RGB565 pixel in range 0-255, weights are 77, 150 and 29 of 256.
+ */
+inline uint8_t luma565(uint8_t high, uint8_t low) {
+    const uint16_t pixel = (high << 8) | low;
+    const uint16_t r = (pixel >> 11) & 0x1F;
+    const uint16_t g = (pixel >> 5) & 0x3F;
+    const uint16_t b = pixel & 0x1F;
+    // Weights include scaling of channels to 8 bits, rounded up so white gives 255
+    return (r * 631 + g * 609 + b * 241) >> 8;
+}
+
+} // namespace
+
+
+void pack_gray8(const uint8_t* gray, uint16_t count, uint8_t threshold, uint8_t* bits) {
+    const uint16_t whole = count / 8;
+    for (uint16_t i = 0; i < whole; i++) {
+        bits[i] = pack8(gray + i * 8, threshold);
+    }
+    if (count & 7) {
+        uint8_t tail[8] = {};
+        memcpy(tail, gray + whole * 8, count & 7);
+        bits[whole] = pack8(tail, threshold);
+    }
+}
+
+void pack_rgb565(const uint8_t* pixels, uint16_t count, uint8_t threshold, bool swapped, uint8_t* bits) {
+    // Byte order of the pixels, little endian unless swapped
+    const uint8_t high = swapped ? 0 : 1;
+    const uint8_t low = swapped ? 1 : 0;
+    uint8_t luma[8];
+    const uint16_t whole = count / 8;
+    for (uint16_t i = 0; i < whole; i++) {
+        const uint8_t* pixel = pixels + i * 16;
+        for (uint8_t b = 0; b < 8; b++) {
+            luma[b] = luma565(pixel[b * 2 + high], pixel[b * 2 + low]);
+        }
+        bits[i] = pack8(luma, threshold);
+    }
+    if (count & 7) {
+        const uint8_t* pixel = pixels + whole * 16;
+        memset(luma, 0, sizeof(luma));
+        for (uint8_t b = 0; b < (count & 7); b++) {
+            luma[b] = luma565(pixel[b * 2 + high], pixel[b * 2 + low]);
+        }
+        bits[whole] = pack8(luma, threshold);
+    }
+}
+
+} // namespace EinkCanvas
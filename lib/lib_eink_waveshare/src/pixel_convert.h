@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace EinkCanvas{
+
+/**
+ * @brief Format of pixels pushed from other graphics libraries.
+ */
+enum class PixelFormat : uint8_t {
+    MONO,           ///< 1 bit per pixel, MSB is the leftmost pixel, 1 is white
+    GRAY8,          ///< 8 bits per pixel, 0 is black, 255 is white
+    RGB565,         ///< 16 bits per pixel, little endian as in memory of ESP32
+    RGB565_SWAPPED  ///< 16 bits per pixel with swapped bytes, e.g. LVGL with LV_COLOR_16_SWAP
+};
+
+/**
+ * @brief Get number of bytes of a row of pixels.
+ * @param format Format of the pixels.
+ * @param width Number of pixels in the row.
+ * @return Size of the row in bytes.
+ */
+inline uint32_t row_size(PixelFormat format, uint16_t width) {
+    switch (format) {
+    case PixelFormat::MONO: return (width + 7) / 8;
+    case PixelFormat::GRAY8: return width;
+    default: return width * 2u;
+    }
+}
+
+/**
+ * @brief Convert gray pixels to packed bits by threshold.
+ * @param gray Gray pixels.
+ * @param count Number of pixels.
+ * @param threshold Pixels with value greater or equal are white.
+ * @param bits Output for (count + 7) / 8 bytes, MSB is the leftmost pixel.
+ */
+void pack_gray8(const uint8_t* gray, uint16_t count, uint8_t threshold, uint8_t* bits);
+
+/**
+ * @brief Convert RGB565 pixels to packed bits by threshold of their luma.
+ * @param pixels RGB565 pixels, they do not have to be aligned.
+ * @param count Number of pixels.
+ * @param threshold Pixels with luma greater or equal are white.
+ * @param swapped true if pixels are big endian.
+ * @param bits Output for (count + 7) / 8 bytes, MSB is the leftmost pixel.
+ */
+void pack_rgb565(const uint8_t* pixels, uint16_t count, uint8_t threshold, bool swapped, uint8_t* bits);
+
+} // namespace EinkCanvas
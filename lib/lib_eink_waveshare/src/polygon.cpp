@@ -0,0 +1,231 @@
+#include "polygon.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace EinkCanvas {
+
+namespace {
+
+/// Subpixel precision of the edges
+constexpr int32_t M_SUBPIXELS = 16;
+
+/**
+ * @brief Division rounding towards negative infinity, divisor is positive.
+ */
+int64_t floor_div(int64_t value, int32_t divisor) {
+    int64_t quotient = value / divisor;
+    if (value % divisor < 0) {
+        quotient--;
+    }
+    return quotient;
+}
+
+/**
+ * @brief First pixel whose center is not left of x, x is in 1/16 pixel.
+ */
+int32_t ceil_pixel(int32_t x) {
+    return (x + M_SUBPIXELS - 1) >> 4;
+}
+
+int16_t clamp16(int32_t value) {
+    return std::min<int32_t>(INT16_MAX, std::max<int32_t>(INT16_MIN, value));
+}
+
+} // namespace
+
+ScanlineRasterizer::ScanlineRasterizer(uint16_t max_edges) :
+    m_max_edges(max_edges) {
+    m_edges = new Edge[max_edges];
+    m_active = new uint16_t[max_edges];
+    m_crossings = new Crossing[max_edges];
+    m_spans = new Span[max_edges / 2 + 1];
+}
+
+ScanlineRasterizer::~ScanlineRasterizer() {
+    delete[] m_edges;
+    delete[] m_active;
+    delete[] m_crossings;
+    delete[] m_spans;
+}
+
+void ScanlineRasterizer::clear() {
+    m_count = 0;
+    m_active_count = 0;
+    m_next = 0;
+    m_top = INT16_MAX;
+    m_bottom = INT16_MIN;
+    m_overflow = false;
+}
+
+bool ScanlineRasterizer::add_polygon(const Point* points, uint16_t count) {
+    for (uint16_t i = 0; count >= 3 && i < count; i++) {
+        const Point& a = points[i];
+        const Point& b = points[i + 1 < count ? i + 1 : 0];
+        add_edge(a.x * M_SUBPIXELS, a.y * M_SUBPIXELS, b.x * M_SUBPIXELS, b.y * M_SUBPIXELS);
+    }
+    return !m_overflow;
+}
+
+bool ScanlineRasterizer::add_polyline(const Point* points, uint16_t count, uint16_t thickness) {
+    const float half = thickness * M_SUBPIXELS / 2.0f;
+    int32_t previous_nx = 0, previous_ny = 0;
+    bool joint = false;
+    for (uint16_t i = 0; thickness > 0 && i + 1 < count; i++) {
+        const int32_t ax = points[i].x * M_SUBPIXELS, ay = points[i].y * M_SUBPIXELS;
+        const int32_t bx = points[i + 1].x * M_SUBPIXELS, by = points[i + 1].y * M_SUBPIXELS;
+        const float length = std::sqrt((float)(bx - ax) * (bx - ax) + (float)(by - ay) * (by - ay));
+        if (length == 0) {
+            continue;
+        }
+        // Normal of the segment scaled to half of the thickness
+        const int32_t nx = std::lround(-(by - ay) * half / length);
+        const int32_t ny = std::lround((bx - ax) * half / length);
+        const int32_t quad_x[4] = {ax + nx, bx + nx, bx - nx, ax - nx};
+        const int32_t quad_y[4] = {ay + ny, by + ny, by - ny, ay - ny};
+        add_convex(quad_x, quad_y, 4);
+        if (joint) {
+            // Only one of the triangles lies on the outer side of the turn, the other one is covered
+            const int32_t outer_x[3] = {ax, ax + previous_nx, ax + nx};
+            const int32_t outer_y[3] = {ay, ay + previous_ny, ay + ny};
+            add_convex(outer_x, outer_y, 3);
+            const int32_t inner_x[3] = {ax, ax - previous_nx, ax - nx};
+            const int32_t inner_y[3] = {ay, ay - previous_ny, ay - ny};
+            add_convex(inner_x, inner_y, 3);
+        }
+        previous_nx = nx;
+        previous_ny = ny;
+        joint = true;
+    }
+    return !m_overflow;
+}
+
+void ScanlineRasterizer::start(int16_t row) {
+    // Edges are activated in order of their first row
+    std::sort(m_edges, m_edges + m_count, [](const Edge& a, const Edge& b) {
+        return a.first_row < b.first_row;
+    });
+    m_active_count = 0;
+    m_next = 0;
+    m_row = row;
+}
+
+const Span* ScanlineRasterizer::next_row(uint16_t& count) {
+    for (; m_next < m_count && m_edges[m_next].first_row <= m_row; m_next++) {
+        if (m_edges[m_next].last_row >= m_row) {
+            seek(m_edges[m_next], m_row);
+            m_active[m_active_count++] = m_next;
+        }
+    }
+
+    uint16_t crossings = 0;
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < m_active_count; i++) {
+        Edge& edge = m_edges[m_active[i]];
+        if (edge.last_row < m_row) {
+            continue;
+        }
+        m_active[kept++] = m_active[i];
+        const Crossing crossing = {edge.remainder == 0 ? ceil_pixel(edge.x) : (edge.x >> 4) + 1, edge.winding};
+        // Crossings keep almost the same order from row to row, insertion sort is enough
+        uint16_t j = crossings++;
+        for (; j > 0 && m_crossings[j - 1].x > crossing.x; j--) {
+            m_crossings[j] = m_crossings[j - 1];
+        }
+        m_crossings[j] = crossing;
+
+        edge.x += edge.step;
+        edge.remainder += edge.step_remainder;
+        if (edge.remainder >= edge.dy) {
+            edge.x++;
+            edge.remainder -= edge.dy;
+        }
+    }
+    m_active_count = kept;
+
+    count = 0;
+    int16_t winding = 0;
+    int32_t begin = 0;
+    for (uint16_t i = 0; i < crossings; i++) {
+        const int16_t previous = winding;
+        winding += m_crossings[i].winding;
+        if (previous == 0 && winding != 0) {
+            begin = m_crossings[i].x;
+        } else if (previous != 0 && winding == 0 && m_crossings[i].x > begin) {
+            const int16_t x0 = clamp16(begin);
+            const int16_t x1 = clamp16(m_crossings[i].x - 1);
+            if (count > 0 && m_spans[count - 1].x1 + 1 >= x0) {
+                m_spans[count - 1].x1 = x1;
+            } else {
+                m_spans[count++] = {x0, x1};
+            }
+        }
+    }
+    m_row++;
+    return m_spans;
+}
+
+void ScanlineRasterizer::add_edge(int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    int8_t winding = 1;
+    if (y0 > y1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+        winding = -1;
+    }
+    // Edge covers rows whose centers are in [y0, y1)
+    const int32_t first_row = ceil_pixel(y0);
+    const int32_t last_row = ceil_pixel(y1) - 1;
+    if (first_row > last_row) {
+        return;
+    }
+    if (m_count >= m_max_edges) {
+        m_overflow = true;
+        return;
+    }
+    Edge& edge = m_edges[m_count++];
+    const int32_t dx = x1 - x0;
+    edge.dy = y1 - y0;
+    const int64_t offset = (int64_t)(first_row * M_SUBPIXELS - y0) * dx;
+    const int64_t quotient = floor_div(offset, edge.dy);
+    edge.x = x0 + quotient;
+    edge.remainder = offset - quotient * edge.dy;
+    const int32_t per_row = dx * M_SUBPIXELS;
+    edge.step = floor_div(per_row, edge.dy);
+    edge.step_remainder = per_row - edge.step * edge.dy;
+    edge.first_row = clamp16(first_row);
+    edge.last_row = clamp16(last_row);
+    edge.winding = winding;
+    m_top = std::min(m_top, edge.first_row);
+    m_bottom = std::max(m_bottom, edge.last_row);
+}
+
+void ScanlineRasterizer::add_convex(const int32_t* x, const int32_t* y, uint8_t count) {
+    int64_t area = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t j = i + 1 < count ? i + 1 : 0;
+        area += (int64_t)x[i] * y[j] - (int64_t)x[j] * y[i];
+    }
+    if (area == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t j = i + 1 < count ? i + 1 : 0;
+        if (area > 0) {
+            add_edge(x[i], y[i], x[j], y[j]);
+        } else {
+            add_edge(x[j], y[j], x[i], y[i]);
+        }
+    }
+}
+
+void ScanlineRasterizer::seek(Edge& edge, int16_t row) {
+    const int32_t rows = row - edge.first_row;
+    if (rows <= 0) {
+        return;
+    }
+    const int64_t remainder = edge.remainder + (int64_t)rows * edge.step_remainder;
+    edge.x += (int64_t)rows * edge.step + remainder / edge.dy;
+    edge.remainder = remainder % edge.dy;
+}
+
+} // namespace EinkCanvas
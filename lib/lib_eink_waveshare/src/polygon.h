@@ -0,0 +1,156 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace EinkCanvas{
+
+/**
+ * @brief Vertex of a polygon or polyline.
+ */
+struct Point {
+    int16_t x;
+    int16_t y;
+};
+
+/**
+ * @brief Horizontal run of pixels of a single row, inclusive.
+ */
+struct Span {
+    int16_t x0;
+    int16_t x1;
+};
+
+/**
+ * @class ScanlineRasterizer
+ * @brief Edge table rasterizer of polygons and thick polylines into horizontal spans.
+ *
+ * Edges are kept in 1/16 pixel and stepped from row to row by integer quotient and
+ * remainder, so spans are exact without floating point. Pixel is inside when its center
+ * is inside, edges on the right and bottom are excluded, so polygons sharing an edge do
+ * not overlap. All contours are filled together by the nonzero winding rule.
+ *
+ * Spans are produced row by row and written into the canvas by GFXCanvasBW::fillPolygon(),
+ * see DisplayHandle::fill_polygon() and DisplayHandle::draw_polyline().
+ */
+class ScanlineRasterizer {
+public:
+    /**
+     * @brief Construct a new rasterizer.
+     *
+     * @param max_edges Maximal number of edges of all contours.
+     */
+    ScanlineRasterizer(uint16_t max_edges);
+
+    ~ScanlineRasterizer();
+
+    ScanlineRasterizer(const ScanlineRasterizer&) = delete;
+    ScanlineRasterizer& operator=(const ScanlineRasterizer&) = delete;
+
+    /**
+     * @brief Remove all contours.
+     */
+    void clear();
+
+    /**
+     * @brief Add a closed polygon, the last vertex is connected to the first one.
+     *
+     * @param points Vertices of the polygon, it may be concave or self-intersecting.
+     * @param count Number of vertices.
+     * @return true if all edges were added, false if there are too many edges.
+     */
+    bool add_polygon(const Point* points, uint16_t count);
+
+    /**
+     * @brief Add a polyline of the thickness, centered on the points.
+     *
+     * Segments have flat ends, consecutive segments are joined by a bevel.
+     * @param points Vertices of the polyline.
+     * @param count Number of vertices.
+     * @param thickness Thickness of the line in pixels.
+     * @return true if all edges were added, false if there are too many edges.
+     */
+    bool add_polyline(const Point* points, uint16_t count, uint16_t thickness);
+
+    /**
+     * @brief Get number of edges needed by a polyline, see add_polyline().
+     */
+    static uint16_t polyline_edges(uint16_t count) {
+        return count < 2 ? 0 : 4 * (count - 1) + 6 * (count - 2);
+    }
+
+    /**
+     * @brief Get the first row which may contain spans.
+     */
+    int16_t top() const {
+        return m_top;
+    }
+
+    /**
+     * @brief Get the last row which may contain spans.
+     */
+    int16_t bottom() const {
+        return m_bottom;
+    }
+
+    /**
+     * @brief Start producing spans from the row, rows above it are skipped.
+     *
+     * @param row The first row.
+     */
+    void start(int16_t row);
+
+    /**
+     * @brief Get spans of the current row and move to the next row.
+     *
+     * @param count Output number of spans, they are sorted from left to right.
+     * @return Spans of the row, valid until the next call.
+     */
+    const Span* next_row(uint16_t& count);
+
+private:
+    struct Edge {
+        int32_t x;          ///< Floor of x in 1/16 pixel at the current row
+        int32_t remainder;  ///< Fraction of x, in units of 1/dy
+        int32_t step;       ///< Whole part of x change per row
+        int32_t step_remainder;
+        int32_t dy;
+        int16_t first_row;
+        int16_t last_row;
+        int8_t winding;
+    };
+
+    struct Crossing {
+        int32_t x;          ///< First pixel right of the edge
+        int8_t winding;
+    };
+
+    /**
+     * @brief Add an edge between points in 1/16 pixel.
+     */
+    void add_edge(int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+
+    /**
+     * @brief Add a convex contour in 1/16 pixel, all are oriented the same way so their windings add up.
+     */
+    void add_convex(const int32_t* x, const int32_t* y, uint8_t count);
+
+    /**
+     * @brief Set x of the edge at the row.
+     */
+    static void seek(Edge& edge, int16_t row);
+
+    Edge* m_edges;
+    uint16_t* m_active;
+    Crossing* m_crossings;
+    Span* m_spans;
+    uint16_t m_max_edges;
+    uint16_t m_count = 0;
+    uint16_t m_active_count = 0;
+    uint16_t m_next = 0;
+    int16_t m_row = 0;
+    int16_t m_top = INT16_MAX;
+    int16_t m_bottom = INT16_MIN;
+    bool m_overflow = false;
+};
+
+} // namespace EinkCanvas
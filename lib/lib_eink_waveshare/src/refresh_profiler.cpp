@@ -0,0 +1,62 @@
+#include "refresh_profiler.h"
+
+namespace EinkDisplay {
+
+void RefreshProfiler::record(EinkDriver::Waveform waveform, uint32_t area, uint32_t total_area, uint32_t upload_us, uint32_t busy_ms) {
+    uint8_t bucket = total_area == 0 ? 0 : (uint64_t)area * M_AREA_BUCKETS / (total_area + 1);
+    if (bucket >= M_AREA_BUCKETS) bucket = M_AREA_BUCKETS - 1;
+    Bucket& b = m_buckets[(uint8_t)waveform][bucket];
+    if (b.count == UINT16_MAX) {
+        // Keep averages, forget half of the history
+        b.count /= 2;
+        b.busy_ms /= 2;
+        b.upload_us /= 2;
+    }
+    b.count++;
+    b.busy_ms += busy_ms;
+    b.upload_us += upload_us;
+}
+
+uint32_t RefreshProfiler::mean_cost(EinkDriver::Waveform waveform, uint8_t bucket) const {
+    const Bucket& b = m_buckets[(uint8_t)waveform][bucket];
+    if (b.count == 0) return 0;
+    return (b.busy_ms + b.upload_us / 1000) / b.count;
+}
+
+bool RefreshProfiler::crossover_area(uint32_t total_area, uint8_t refresh_period, uint32_t& area) const {
+    // Full refresh always covers the whole display
+    const uint8_t full_bucket = M_AREA_BUCKETS - 1;
+    if (samples(EinkDriver::Waveform::FULL, full_bucket) < M_MIN_SAMPLES) {
+        return false;
+    }
+    const uint32_t full_cost = mean_cost(EinkDriver::Waveform::FULL, full_bucket);
+    const uint32_t period = refresh_period == 0 ? 1 : refresh_period;
+
+    for (uint8_t bucket = 0; bucket < M_AREA_BUCKETS; bucket++) {
+        if (samples(EinkDriver::Waveform::PARTIAL, bucket) < M_MIN_SAMPLES) continue;
+        // Ghosting of the middle of the bucket
+        const uint32_t ghosting_cost = (uint64_t)full_cost * (2 * bucket + 1) / (2 * M_AREA_BUCKETS * period);
+        if (mean_cost(EinkDriver::Waveform::PARTIAL, bucket) + ghosting_cost >= full_cost) {
+            area = (uint64_t)total_area * bucket / M_AREA_BUCKETS;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RefreshProfiler::print() const {
+    static const char* const names[M_WAVEFORMS] = {"full", "partial", "fast"};
+    char line[64];
+    for (uint8_t w = 0; w < M_WAVEFORMS; w++) {
+        for (uint8_t bucket = 0; bucket < M_AREA_BUCKETS; bucket++) {
+            const Bucket& b = m_buckets[w][bucket];
+            if (b.count == 0) continue;
+            snprintf(line, sizeof(line), "%s %u/%u: %u x, busy %lu ms, upload %lu us\n", names[w],
+                     bucket + 1, M_AREA_BUCKETS, b.count,
+                     (unsigned long)(b.busy_ms / b.count), (unsigned long)(b.upload_us / b.count));
+            debug::Print(line);
+        }
+    }
+}
+
+} // namespace EinkDisplay
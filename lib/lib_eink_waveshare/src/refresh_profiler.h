@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "eink_driver.h"
+
+namespace EinkDisplay{
+
+/**
+ * @class RefreshProfiler
+ * @brief Histograms of measured refresh times per waveform and size of the refreshed area.
+ *
+ * Area of the display is split into M_AREA_BUCKETS buckets of the same size. Every bucket
+ * keeps number of refreshes, total time the display was busy and total upload time.
+ * From the averages the profiler derives area from which full refresh is cheaper than
+ * partial one.
+ */
+class RefreshProfiler {
+public:
+    /**
+     * @brief Record one refresh.
+     * @param waveform Waveform used for the refresh.
+     * @param area Refreshed area in pixels.
+     * @param total_area Area of the whole display in pixels.
+     * @param upload_us Time spent uploading the frame in microseconds.
+     * @param busy_ms Time the display was busy refreshing in milliseconds.
+     */
+    void record(EinkDriver::Waveform waveform, uint32_t area, uint32_t total_area, uint32_t upload_us, uint32_t busy_ms);
+
+    /**
+     * @brief Get number of recorded refreshes.
+     * @param waveform Waveform of the refreshes.
+     * @param bucket Area bucket.
+     * @return The number of refreshes.
+     */
+    uint16_t samples(EinkDriver::Waveform waveform, uint8_t bucket) const {
+        return m_buckets[(uint8_t)waveform][bucket].count;
+    }
+
+    /**
+     * @brief Get average cost of a refresh, busy time plus upload time.
+     * @param waveform Waveform of the refreshes.
+     * @param bucket Area bucket.
+     * @return Average cost in milliseconds, 0 if nothing was recorded.
+     */
+    uint32_t mean_cost(EinkDriver::Waveform waveform, uint8_t bucket) const;
+
+    /**
+     * @brief Derive area from which full refresh is cheaper than partial refresh.
+     *
+     * Cost of a partial refresh includes ghosting it leaves behind, which is cleaned by the
+     * periodic full refresh. Ghosting grows with refreshed area, partial refresh of the whole
+     * display is charged its share of the full refresh, smaller ones proportionally less.
+     * Crossover is only taken from measured buckets, if partial refresh is cheaper in all
+     * of them the area is left unchanged.
+     * @param total_area Area of the whole display in pixels.
+     * @param refresh_period Number of partial refreshes between two full refreshes.
+     * @param area Derived area in pixels, unchanged if no crossover was measured.
+     * @return true if the crossover was measured, false otherwise.
+     */
+    bool crossover_area(uint32_t total_area, uint8_t refresh_period, uint32_t& area) const;
+
+    /**
+     * @brief Print the histograms using debug output.
+     */
+    void print() const;
+
+    static constexpr uint8_t M_AREA_BUCKETS = 8;
+    static constexpr uint8_t M_WAVEFORMS = 3;
+    /// Minimal number of refreshes in a bucket before it is used for calibration
+    static constexpr uint8_t M_MIN_SAMPLES = 3;
+
+private:
+    /**
+     * @brief Measurements of one waveform and area bucket.
+     */
+    struct Bucket {
+        uint16_t count;
+        uint32_t busy_ms;
+        uint32_t upload_us;
+    };
+
+    Bucket m_buckets[M_WAVEFORMS][M_AREA_BUCKETS] = {};
+};
+
+} // namespace EinkDisplay
@@ -7,7 +7,7 @@ SPIController::SPIController(uint8_t cs, uint8_t dc):
     m_SPI_com.begin(SCK, MISO, MOSI, cs);
     m_SPI_com.setBitOrder(MSBFIRST);
     m_SPI_com.setDataMode(SPI_MODE0);
-    m_SPI_com.setFrequency(1000000); // Set frequency to 1MHz
+    m_SPI_com.setFrequency(m_frequency); // Set frequency to 1MHz
     m_SPI_com.setHwCs(false); // Use software CS control, we are controlling CS manually
     pinMode(m_epd_cs, OUTPUT);
     pinMode(m_epd_dc, OUTPUT);
@@ -22,6 +22,7 @@ void SPIController::sendCommand(uint8_t cmd) {
     digitalWrite(m_epd_cs, LOW); // CS low to enable device
     m_SPI_com.write(cmd);
     digitalWrite(m_epd_cs, HIGH);
+    m_bytes_sent++;
 }
 
 void SPIController::sendData(uint8_t data) {
@@ -29,6 +30,7 @@ void SPIController::sendData(uint8_t data) {
     digitalWrite(m_epd_cs, LOW);
     m_SPI_com.write(data);
     digitalWrite(m_epd_cs, HIGH);
+    m_bytes_sent++;
 }
 
 void SPIController::sendData(std::initializer_list<uint8_t> data) {
@@ -36,6 +38,7 @@ void SPIController::sendData(std::initializer_list<uint8_t> data) {
     digitalWrite(m_epd_cs, LOW);
     m_SPI_com.writeBytes(data.begin(), data.size());
     digitalWrite(m_epd_cs, HIGH);
+    m_bytes_sent += data.size();
 }
 
 void SPIController::sendData(const uint8_t *data, size_t size) {
@@ -43,6 +46,42 @@ void SPIController::sendData(const uint8_t *data, size_t size) {
     digitalWrite(m_epd_cs, LOW);
     m_SPI_com.writeBytes(data, size);
     digitalWrite(m_epd_cs, HIGH);
+    m_bytes_sent += size;
+}
+
+void SPIController::sendRepeatedData(uint8_t data, size_t count) {
+    uint8_t chunk[32];
+    memset(chunk, data, sizeof(chunk));
+    digitalWrite(m_epd_dc, HIGH);
+    digitalWrite(m_epd_cs, LOW);
+    m_bytes_sent += count;
+    while (count > 0) {
+        const size_t size = count < sizeof(chunk) ? count : sizeof(chunk);
+        m_SPI_com.writeBytes(chunk, size);
+        count -= size;
+    }
+    digitalWrite(m_epd_cs, HIGH);
+}
+
+void SPIController::beginTransfer() {
+    digitalWrite(m_epd_cs, LOW);
+}
+
+void SPIController::writeCommand(uint8_t cmd) {
+    digitalWrite(m_epd_dc, LOW);
+    m_SPI_com.write(cmd);
+    m_bytes_sent++;
+}
+
+void SPIController::writeData(const uint8_t *data, size_t size) {
+    if (size == 0) return;
+    digitalWrite(m_epd_dc, HIGH);
+    m_SPI_com.writeBytes(data, size);
+    m_bytes_sent += size;
+}
+
+void SPIController::endTransfer() {
+    digitalWrite(m_epd_cs, HIGH);
 }
 
 void SPIController::sendCommandWithData(uint8_t cmd, const std::initializer_list<uint8_t> data) {
@@ -52,6 +91,17 @@ void SPIController::sendCommandWithData(uint8_t cmd, const std::initializer_list
     digitalWrite(m_epd_dc, HIGH); // Data mode
     m_SPI_com.writeBytes(data.begin(), data.size());
     digitalWrite(m_epd_cs, HIGH); // CS high to disable device
+    m_bytes_sent += 1 + data.size();
+}
+
+void SPIController::sendCommandWithData(uint8_t cmd, const uint8_t *data, size_t size) {
+    digitalWrite(m_epd_dc, LOW); // Command mode
+    digitalWrite(m_epd_cs, LOW); // CS low to enable device
+    m_SPI_com.write(cmd);
+    digitalWrite(m_epd_dc, HIGH); // Data mode
+    m_SPI_com.writeBytes(data, size);
+    digitalWrite(m_epd_cs, HIGH); // CS high to disable device
+    m_bytes_sent += 1 + size;
 }
 
 } // namespace EinkSPI
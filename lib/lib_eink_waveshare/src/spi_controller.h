@@ -78,10 +78,70 @@ public:
      */
     void sendCommandWithData(uint8_t cmd, const std::initializer_list<uint8_t> data);
 
+    /**
+     * @brief Sends a command followed by array of data bytes to the e-paper display
+     * @param cmd Command byte to send
+     * @param data Pointer to the array of data bytes
+     * @param size Number of bytes to send
+     */
+    void sendCommandWithData(uint8_t cmd, const uint8_t *data, size_t size);
+
+    /**
+     * @brief Sends the same data byte repeatedly in a single transaction
+     * @param data Data byte to send
+     * @param count Number of repetitions
+     */
+    void sendRepeatedData(uint8_t data, size_t count);
+
+    /**
+     * @brief Starts a transfer, chip select stays low until endTransfer()
+     *
+     * Consecutive commands with data are sent by writeCommand() and writeData() without
+     * toggling chip select between them.
+     */
+    void beginTransfer();
+
+    /**
+     * @brief Writes a command byte inside of a transfer
+     * @param cmd Command byte to send
+     */
+    void writeCommand(uint8_t cmd);
+
+    /**
+     * @brief Writes data bytes inside of a transfer
+     * @param data Pointer to the array of data bytes
+     * @param size Number of bytes to send
+     */
+    void writeData(const uint8_t *data, size_t size);
+
+    /**
+     * @brief Ends a transfer started by beginTransfer()
+     */
+    void endTransfer();
+
+    /**
+     * @brief Get the SPI clock frequency
+     * @return Frequency in Hz
+     */
+    uint32_t getFrequency() const { return m_frequency; }
+
+    /**
+     * @brief Get number of bytes sent to the display, commands included
+     * @return Number of bytes sent since construction or last reset
+     */
+    uint32_t getBytesSent() const { return m_bytes_sent; }
+
+    /**
+     * @brief Reset counter of sent bytes
+     */
+    void resetBytesSent() { m_bytes_sent = 0; }
+
 private:
     SPIClass m_SPI_com;    ///< SPI communication interface
     uint8_t m_epd_cs;      ///< Chip select pin
     uint8_t m_epd_dc;      ///< Data/Command control pin
+    uint32_t m_frequency = 1000000; ///< SPI clock frequency in Hz
+    uint32_t m_bytes_sent = 0;      ///< Number of bytes sent to the display
 };
 
 } // namespace EinkSPI
\ No newline at end of file
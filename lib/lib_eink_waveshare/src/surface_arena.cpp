@@ -0,0 +1,65 @@
+#include "surface_arena.h"
+
+#include <algorithm>
+
+#include "my_utils.h"
+
+namespace EinkCanvas {
+
+SurfaceArena::SurfaceArena(uint32_t size) :
+    m_size(size) {
+    m_memory = new uint8_t[size];
+}
+
+SurfaceArena::~SurfaceArena() {
+    delete[] m_memory;
+}
+
+Surface SurfaceArena::allocate(uint16_t width, uint16_t height, uint16_t color) {
+    Surface surface;
+    if (width == 0 || height == 0) {
+        debug::Print("Surface is empty.\n");
+        return surface;
+    }
+    const uint16_t stride = (width + 7) / 8;
+    const uint32_t size = (uint32_t)stride * height;
+    // Surfaces start at word boundaries
+    const uint32_t start = (m_used + 3) & ~3u;
+    if (start > m_size || size > m_size - start) {
+        debug::Print("Surface arena is full.\n");
+        return surface;
+    }
+    m_used = start + size;
+    surface.bits = m_memory + start;
+    surface.width = width;
+    surface.height = height;
+    surface.stride = stride;
+    memset(surface.bits, color ? 0xFF : 0x00, size);
+    return surface;
+}
+
+void SurfaceArena::release(uint32_t mark) {
+    if (mark > m_used) {
+        debug::Print("Invalid arena mark.\n");
+        return;
+    }
+    m_used = mark;
+}
+
+void blit(Surface& dst, int16_t x, int16_t y, const Surface& src, BlendOp op) {
+    if (!dst.valid() || !src.valid()) {
+        debug::Print("Surface is empty.\n");
+        return;
+    }
+    const int32_t x0 = std::max<int32_t>(0, x);
+    const int32_t y0 = std::max<int32_t>(0, y);
+    const int32_t x1 = std::min<int32_t>(dst.width - 1, (int32_t)x + src.width - 1);
+    const int32_t y1 = std::min<int32_t>(dst.height - 1, (int32_t)y + src.height - 1);
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+    blit_bits(dst.bits, dst.stride * 8, x0, y0, src.bits, src.stride * 8, x0 - x, y0 - y,
+              x1 - x0 + 1, y1 - y0 + 1, op);
+}
+
+} // namespace EinkCanvas
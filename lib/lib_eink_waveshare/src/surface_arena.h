@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "compositor.h"
+
+namespace EinkCanvas{
+
+/**
+ * @brief Offscreen 1 bit per pixel surface, its memory is owned by the arena it was carved from.
+ *
+ * Rows are padded to whole bytes, white is 1 as in the canvas. Surface can be drawn into
+ * by a canvas sharing its memory, see GFXCanvasBW(uint16_t, uint16_t, uint8_t*).
+ */
+struct Surface {
+    uint8_t* bits = nullptr;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint16_t stride = 0;    ///< Bytes per row
+
+    /**
+     * @brief Check if the surface was allocated.
+     */
+    bool valid() const {
+        return bits != nullptr;
+    }
+};
+
+/**
+ * @class SurfaceArena
+ * @brief Fixed block of memory from which offscreen surfaces are carved.
+ *
+ * Memory is allocated once by the constructor. Surfaces are carved one after another
+ * without any per surface allocation, and are freed together by release() back to
+ * an earlier mark, so the heap does not fragment by pre-rendered icons, menus or saved
+ * backgrounds. Surfaces are shown by DisplayHandle::blit().
+ *
+ * Usage example:
+ * @code
+ * EinkCanvas::SurfaceArena arena(4096);
+ * EinkCanvas::Surface icon = arena.allocate(32, 32);
+ * EinkCanvas::GFXCanvasBW painter(icon.stride * 8, icon.height, icon.bits);
+ * painter.fillCircle(16, 16, 12, 0);
+ * ...
+ * display.blit(icon, x, y, EinkCanvas::BlendOp::AND); // no re-render
+ *
+ * const uint32_t mark = arena.get_used();
+ * EinkCanvas::Surface background = arena.allocate(120, 80);
+ * display.capture(background, 40, 60);
+ * draw_menu();
+ * ...
+ * display.blit(background, 40, 60);                    // menu is closed
+ * arena.release(mark);
+ * @endcode
+ */
+class SurfaceArena {
+public:
+    /**
+     * @brief Construct a new arena.
+     *
+     * @param size Size of the arena in bytes.
+     */
+    SurfaceArena(uint32_t size);
+
+    ~SurfaceArena();
+
+    SurfaceArena(const SurfaceArena&) = delete;
+    SurfaceArena& operator=(const SurfaceArena&) = delete;
+
+    /**
+     * @brief Carve a new surface, it is filled by the color.
+     *
+     * @param width Width of the surface in pixels.
+     * @param height Height of the surface in pixels.
+     * @param color Color of the surface (any non-zero value is treated as "on").
+     * @return The surface, invalid if the arena has not enough space.
+     */
+    Surface allocate(uint16_t width, uint16_t height, uint16_t color = 1);
+
+    /**
+     * @brief Free all surfaces allocated after the mark, they must not be used anymore.
+     *
+     * @param mark Value of get_used() before the surfaces were allocated.
+     */
+    void release(uint32_t mark);
+
+    /**
+     * @brief Free all surfaces.
+     */
+    void reset() {
+        release(0);
+    }
+
+    /**
+     * @brief Get number of used bytes, it also marks the current state for release().
+     */
+    uint32_t get_used() const {
+        return m_used;
+    }
+
+    /**
+     * @brief Get size of the arena in bytes.
+     */
+    uint32_t get_size() const {
+        return m_size;
+    }
+
+private:
+    uint8_t* m_memory;
+    uint32_t m_size;
+    uint32_t m_used = 0;
+};
+
+/**
+ * @brief Blit a surface into another one, parts outside of the destination are skipped.
+ *
+ * @param dst Destination surface.
+ * @param x X coordinate of the source in the destination.
+ * @param y Y coordinate of the source in the destination.
+ * @param src Source surface, it must not be the destination.
+ * @param op Blend operation.
+ */
+void blit(Surface& dst, int16_t x, int16_t y, const Surface& src, BlendOp op = BlendOp::COPY);
+
+} // namespace EinkCanvas
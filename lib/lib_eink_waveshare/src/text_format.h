@@ -0,0 +1,182 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace EinkFormat{
+
+/**
+ * @brief Compute 10 to the power of n at compile time.
+ * @param n Exponent.
+ * @return The power of 10.
+ */
+constexpr uint32_t pow10(uint8_t n) {
+    return n == 0 ? 1 : 10 * pow10(n - 1);
+}
+
+/**
+ * @struct Int
+ * @brief Integer field, right aligned to Width characters using Pad character.
+ *
+ * Usage example:
+ * @code
+ * EinkFormat::Int<3, '0'>{7} // "007"
+ * @endcode
+ */
+template <uint8_t Width = 0, char Pad = ' '>
+struct Int {
+    int32_t value;
+
+    static constexpr uint8_t M_MAX_LENGTH = Width > 11 ? Width : 11;
+};
+
+/**
+ * @struct Fixed
+ * @brief Fixed point field, value is scaled by 10^Decimals.
+ * Field is right aligned to Width characters using Pad character.
+ *
+ * Usage example:
+ * @code
+ * EinkFormat::Fixed<1>{-215} // "-21.5"
+ * @endcode
+ */
+template <uint8_t Decimals, uint8_t Width = 0, char Pad = ' '>
+struct Fixed {
+    int32_t value;
+
+    static_assert(Decimals > 0 && Decimals < 10, "Decimals has to be between 1 and 9");
+    static constexpr uint8_t M_MAX_LENGTH = Width > 13 ? Width : 13;
+};
+
+/**
+ * @struct Time
+ * @brief Time field with zero padded parts, formatted as HH:MM:SS, or HH:MM without seconds.
+ * Parts are written modulo 100, so each of them takes exactly two characters.
+ */
+template <bool Seconds = true>
+struct Time {
+    uint8_t hours;
+    uint8_t minutes;
+    uint8_t seconds;
+
+    static constexpr uint8_t M_MAX_LENGTH = Seconds ? 8 : 5;
+};
+
+/**
+ * @brief Maximal length of a field in characters, known at compile time.
+ */
+template <typename T>
+struct FieldLength {
+    static constexpr uint8_t value = T::M_MAX_LENGTH;
+};
+
+/**
+ * @brief Single character, used for separators.
+ */
+template <>
+struct FieldLength<char> {
+    static constexpr uint8_t value = 1;
+};
+
+/**
+ * @brief Maximal length of all fields together.
+ */
+template <typename... Fields>
+constexpr uint16_t max_length() {
+    return (FieldLength<Fields>::value + ... + 0);
+}
+
+/**
+ * @brief Write unsigned number, right aligned to width.
+ * @param out Output buffer.
+ * @param value The value to write.
+ * @param min_digits Minimal number of digits, zeros are prepended.
+ * @param width Minimal width of the output, pad characters are prepended.
+ * @param pad Padding character.
+ * @param negative If true, minus sign is written in front of the digits.
+ * @return Number of written characters.
+ */
+inline uint8_t format_unsigned(char* out, uint32_t value, uint8_t min_digits, uint8_t width, char pad, bool negative) {
+    char digits[10];
+    uint8_t count = 0;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0 || count < min_digits);
+
+    uint8_t length = count + (negative ? 1 : 0);
+    uint8_t written = 0;
+    if (negative && pad == '0') {
+        out[written++] = '-';
+    }
+    for (; length < width; length++) {
+        out[written++] = pad;
+    }
+    if (negative && pad != '0') {
+        out[written++] = '-';
+    }
+    while (count > 0) {
+        out[written++] = digits[--count];
+    }
+    return written;
+}
+
+/**
+ * @brief Write a single character.
+ * @param out Output buffer.
+ * @param c The character.
+ * @return Number of written characters.
+ */
+inline uint8_t format(char* out, char c) {
+    out[0] = c;
+    return 1;
+}
+
+/**
+ * @brief Write an integer field.
+ * @param out Output buffer, at least M_MAX_LENGTH characters long.
+ * @param field The field.
+ * @return Number of written characters.
+ */
+template <uint8_t Width, char Pad>
+uint8_t format(char* out, const Int<Width, Pad>& field) {
+    const bool negative = field.value < 0;
+    const uint32_t magnitude = negative ? 0u - (uint32_t)field.value : field.value;
+    return format_unsigned(out, magnitude, 1, Width, Pad, negative);
+}
+
+/**
+ * @brief Write a fixed point field.
+ * @param out Output buffer, at least M_MAX_LENGTH characters long.
+ * @param field The field.
+ * @return Number of written characters.
+ */
+template <uint8_t Decimals, uint8_t Width, char Pad>
+uint8_t format(char* out, const Fixed<Decimals, Width, Pad>& field) {
+    constexpr uint32_t scale = pow10(Decimals);
+    const bool negative = field.value < 0;
+    const uint32_t magnitude = negative ? 0u - (uint32_t)field.value : field.value;
+    const uint8_t integer_width = Width > Decimals + 1 ? Width - Decimals - 1 : 0;
+    uint8_t written = format_unsigned(out, magnitude / scale, 1, integer_width, Pad, negative);
+    out[written++] = '.';
+    return written + format_unsigned(out + written, magnitude % scale, Decimals, 0, '0', false);
+}
+
+/**
+ * @brief Write a time field.
+ * @param out Output buffer, at least M_MAX_LENGTH characters long.
+ * @param field The field.
+ * @return Number of written characters.
+ */
+template <bool Seconds>
+uint8_t format(char* out, const Time<Seconds>& field) {
+    uint8_t written = format_unsigned(out, field.hours % 100, 2, 0, '0', false);
+    out[written++] = ':';
+    written += format_unsigned(out + written, field.minutes % 100, 2, 0, '0', false);
+    if (Seconds) {
+        out[written++] = ':';
+        written += format_unsigned(out + written, field.seconds % 100, 2, 0, '0', false);
+    }
+    return written;
+}
+
+} // namespace EinkFormat
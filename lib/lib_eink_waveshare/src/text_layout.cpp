@@ -0,0 +1,59 @@
+#include "text_layout.h"
+
+namespace EinkDisplay {
+
+void FontMetrics::set_font(const GFXfont* font) {
+    delete[] m_advance;
+    m_advance = nullptr;
+    m_compact = nullptr;
+    if (font == nullptr) {
+        // Built-in font is drawn from the top left corner of 6x8 cell
+        m_ascent = 0;
+        m_descent = 8;
+        m_line_height = 8;
+        return;
+    }
+
+    m_first = font->first;
+    m_last = font->last;
+    m_advance = new uint8_t[m_last - m_first + 1];
+    m_ascent = 0;
+    m_descent = 0;
+    for (uint16_t i = 0; i <= m_last - m_first; i++) {
+        const GFXglyph& glyph = font->glyph[i];
+        m_advance[i] = glyph.xAdvance;
+        if (glyph.height == 0) continue;
+        if (-glyph.yOffset > m_ascent) m_ascent = -glyph.yOffset;
+        if (glyph.yOffset + glyph.height > m_descent) m_descent = glyph.yOffset + glyph.height;
+    }
+    m_line_height = font->yAdvance;
+}
+
+void FontMetrics::set_font(const CompactFont& font) {
+    delete[] m_advance;
+    m_advance = nullptr;
+    m_compact = &font;
+    m_ascent = 0;
+    m_descent = 0;
+    for (uint16_t r = 0; r < font.range_count; r++) {
+        const CompactRange& range = font.ranges[r];
+        for (uint16_t i = 0; i < range.count; i++) {
+            const CompactGlyph& glyph = font.glyphs[range.glyph + i];
+            if (glyph.height == 0) continue;
+            if (-glyph.y_offset > m_ascent) m_ascent = -glyph.y_offset;
+            if (glyph.y_offset + glyph.height > m_descent) m_descent = glyph.y_offset + glyph.height;
+        }
+    }
+    m_line_height = font.y_advance;
+}
+
+uint16_t FontMetrics::text_width(const char* text, size_t length) const {
+    uint16_t width = 0;
+    const char* end = text + length;
+    while (text < end) {
+        width += advance(text, end);
+    }
+    return width;
+}
+
+} // namespace EinkDisplay
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+#include "compact_font.h"
+
+namespace EinkDisplay{
+
+/**
+ * @brief Horizontal alignment of text lines inside of a box.
+ */
+enum class TextAlign : uint8_t {
+    LEFT,
+    CENTER,
+    RIGHT
+};
+
+/**
+ * @class FontMetrics
+ * @brief Metrics of a font, precomputed once when the font is set.
+ *
+ * Keeps compact table of glyph advances and font wide ascent and descent, so text can
+ * be measured without walking the glyph table of GFXfont again. Without font, metrics
+ * describe the built-in 6x8 font of Adafruit GFX. Text in compact font is UTF-8, glyphs
+ * are found by binary search of its ranges.
+ */
+class FontMetrics {
+public:
+    FontMetrics() = default;
+
+    ~FontMetrics() {
+        delete[] m_advance;
+    }
+
+    FontMetrics(const FontMetrics&) = delete;
+    FontMetrics& operator=(const FontMetrics&) = delete;
+
+    /**
+     * @brief Compute metrics of the font.
+     * @param font Pointer to the font, nullptr for the built-in font.
+     */
+    void set_font(const GFXfont* font);
+
+    /**
+     * @brief Compute metrics of the compact font.
+     * @param font The font, it has to outlive the metrics.
+     */
+    void set_font(const CompactFont& font);
+
+    /**
+     * @brief Get horizontal advance of the next character of text and move after it.
+     *
+     * Character is a single byte, or UTF-8 sequence for compact font.
+     * @param text Pointer to the character, moved to the next character.
+     * @return Advance in pixels, 0 if the font does not contain the character.
+     */
+    uint8_t advance(const char*& text) const {
+        if (m_compact != nullptr) {
+            const CompactGlyph* glyph = find_glyph(*m_compact, utf8_next(text));
+            return glyph != nullptr ? glyph->x_advance : 0;
+        }
+        return advance((uint8_t)*text++);
+    }
+
+    /**
+     * @brief Get horizontal advance of the next character of text which does not have to be terminated.
+     * @param text Pointer to the character before the end, moved to the next character.
+     * @param end End of the text, UTF-8 sequence cut by it has advance of U+FFFD.
+     * @return Advance in pixels, 0 if the font does not contain the character.
+     */
+    uint8_t advance(const char*& text, const char* end) const {
+        if (m_compact != nullptr) {
+            const CompactGlyph* glyph = find_glyph(*m_compact, utf8_next(text, end));
+            return glyph != nullptr ? glyph->x_advance : 0;
+        }
+        return advance((uint8_t)*text++);
+    }
+
+    /**
+     * @brief Get horizontal advance of a character.
+     * @param c The character.
+     * @return Advance in pixels, 0 if the font does not contain the character.
+     */
+    uint8_t advance(uint8_t c) const {
+        if (m_advance == nullptr) return 6;
+        if (c < m_first || c > m_last) return 0;
+        return m_advance[c - m_first];
+    }
+
+    /**
+     * @brief Get width of the text as sum of advances.
+     * @param text Characters to measure.
+     * @param length Number of bytes.
+     * @return Width in pixels.
+     */
+    uint16_t text_width(const char* text, size_t length) const;
+
+    /**
+     * @brief Get maximal height of glyphs above the baseline.
+     * @return The ascent in pixels.
+     */
+    uint8_t ascent() const {
+        return m_ascent;
+    }
+
+    /**
+     * @brief Get maximal depth of glyphs below the baseline.
+     * @return The descent in pixels.
+     */
+    uint8_t descent() const {
+        return m_descent;
+    }
+
+    /**
+     * @brief Get distance between baselines of two lines.
+     * @return The line height in pixels.
+     */
+    uint8_t line_height() const {
+        return m_line_height;
+    }
+
+private:
+    uint8_t* m_advance = nullptr;
+    const CompactFont* m_compact = nullptr;
+    uint16_t m_first = 0;
+    uint16_t m_last = 0;
+    uint8_t m_ascent = 0;
+    uint8_t m_descent = 8;
+    uint8_t m_line_height = 8;
+};
+
+} // namespace EinkDisplay
@@ -0,0 +1,80 @@
+#include "tile_hashes.h"
+
+#include <algorithm>
+
+namespace EinkDisplay {
+
+TileHashes::TileHashes(uint16_t width, uint16_t height) :
+    m_width(width), m_height(height) {
+    m_tiles_x = (width / 8 + M_TILE_BYTES - 1) / M_TILE_BYTES;
+    m_tiles_y = (height + M_TILE_ROWS - 1) / M_TILE_ROWS;
+    m_hashes = new uint32_t[m_tiles_x * m_tiles_y];
+    m_changed = new uint8_t[(m_tiles_x * m_tiles_y + 7) / 8];
+    memset(m_changed, 0, (m_tiles_x * m_tiles_y + 7) / 8);
+}
+
+void TileHashes::rehash(const uint8_t* buffer) {
+    for (uint16_t ty = 0; ty < m_tiles_y; ty++) {
+        for (uint16_t tx = 0; tx < m_tiles_x; tx++) {
+            m_hashes[ty * m_tiles_x + tx] = hash_tile(buffer, tx, ty);
+        }
+    }
+    m_valid = true;
+}
+
+bool TileHashes::update(const uint8_t* buffer, uint16_t& x_start, uint16_t& y_start, uint16_t& x_end, uint16_t& y_end) {
+    memset(m_changed, 0, (m_tiles_x * m_tiles_y + 7) / 8);
+    if (x_end >= m_width)  x_end = m_width - 1;
+    if (y_end >= m_height) y_end = m_height - 1;
+    if (x_start > x_end || y_start > y_end) {
+        return false;
+    }
+
+    const uint16_t tile_width = M_TILE_BYTES * 8;
+    uint16_t changed_x_start = m_tiles_x, changed_y_start = m_tiles_y;
+    uint16_t changed_x_end = 0, changed_y_end = 0;
+    bool changed = false;
+
+    for (uint16_t ty = y_start / M_TILE_ROWS; ty <= y_end / M_TILE_ROWS; ty++) {
+        for (uint16_t tx = x_start / tile_width; tx <= x_end / tile_width; tx++) {
+            uint32_t hash = hash_tile(buffer, tx, ty);
+            const uint16_t i = ty * m_tiles_x + tx;
+            if (hash == m_hashes[i]) {
+                continue;
+            }
+            m_hashes[i] = hash;
+            m_changed[i / 8] |= 1 << (i % 8);
+            changed = true;
+            if (tx < changed_x_start) changed_x_start = tx;
+            if (ty < changed_y_start) changed_y_start = ty;
+            if (tx > changed_x_end) changed_x_end = tx;
+            if (ty > changed_y_end) changed_y_end = ty;
+        }
+    }
+    if (!changed) {
+        return false;
+    }
+
+    // Shrink the area to the changed tiles
+    x_start = std::max<uint16_t>(x_start, changed_x_start * tile_width);
+    y_start = std::max<uint16_t>(y_start, changed_y_start * M_TILE_ROWS);
+    x_end = std::min<uint16_t>(x_end, (changed_x_end + 1) * tile_width - 1);
+    y_end = std::min<uint16_t>(y_end, (changed_y_end + 1) * M_TILE_ROWS - 1);
+    return true;
+}
+
+uint32_t TileHashes::hash_tile(const uint8_t* buffer, uint16_t tile_x, uint16_t tile_y) const {
+    const uint16_t bytes_per_row = m_width / 8;
+    const uint16_t first_byte = tile_x * M_TILE_BYTES;
+    const uint16_t bytes = std::min<uint16_t>(M_TILE_BYTES, bytes_per_row - first_byte);
+    const uint16_t first_row = tile_y * M_TILE_ROWS;
+    const uint16_t last_row = std::min<uint16_t>(first_row + M_TILE_ROWS, m_height);
+
+    uint32_t hash = fnv1a(nullptr, 0);
+    for (uint16_t row = first_row; row < last_row; row++) {
+        hash = fnv1a(buffer + row * bytes_per_row + first_byte, bytes, hash);
+    }
+    return hash;
+}
+
+} // namespace EinkDisplay
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "frame_store.h"
+
+namespace EinkDisplay{
+
+/**
+ * @class TileHashes
+ * @brief Table of hashes of the last displayed frame, split into tiles.
+ *
+ * Instead of keeping a full copy of the displayed frame, only hash of every tile is kept.
+ * Tile covers 8 rows and 8 bytes (64 pixels) of the frame, so 200x200 frame needs 100 tiles
+ * and 400 bytes of memory. Dirty area of the frame is compared tile by tile and shrunk to
+ * the tiles which really changed.
+ */
+class TileHashes {
+public:
+    /**
+     * @brief Construct table for frame of given size.
+     * Table is not valid until rehash() is called.
+     * @param width Width of the frame in pixels, multiple of 8.
+     * @param height Height of the frame in pixels.
+     */
+    TileHashes(uint16_t width, uint16_t height);
+
+    ~TileHashes() {
+        delete[] m_hashes;
+        delete[] m_changed;
+    }
+
+    TileHashes(const TileHashes&) = delete;
+    TileHashes& operator=(const TileHashes&) = delete;
+
+    /**
+     * @brief Mark the table as not valid, content of the display is unknown.
+     */
+    void invalidate() {
+        m_valid = false;
+    }
+
+    /**
+     * @brief Check if the table describes content of the display.
+     * @return true if the table is valid, false otherwise.
+     */
+    bool is_valid() const {
+        return m_valid;
+    }
+
+    /**
+     * @brief Hash all tiles of the frame, table becomes valid.
+     * @param buffer Pointer to the frame buffer.
+     */
+    void rehash(const uint8_t* buffer);
+
+    /**
+     * @brief Rehash tiles under the area and shrink the area to the tiles which changed.
+     * Coordinates are inclusive and are clamped to the frame. Changed tiles can be then
+     * queried by is_changed().
+     * @param buffer Pointer to the frame buffer.
+     * @param x_start Start x coordinate of the area.
+     * @param y_start Start y coordinate of the area.
+     * @param x_end End x coordinate of the area.
+     * @param y_end End y coordinate of the area.
+     * @return true if any tile has changed, false otherwise.
+     */
+    bool update(const uint8_t* buffer, uint16_t& x_start, uint16_t& y_start, uint16_t& x_end, uint16_t& y_end);
+
+    /**
+     * @brief Check if the tile changed during the last update().
+     * @param tile_x Column of the tile.
+     * @param tile_y Row of the tile.
+     * @return true if the tile changed, false otherwise.
+     */
+    bool is_changed(uint16_t tile_x, uint16_t tile_y) const {
+        const uint16_t i = tile_y * m_tiles_x + tile_x;
+        return m_changed[i / 8] & (1 << (i % 8));
+    }
+
+    /**
+     * @brief Get number of tile columns.
+     * @return The number of tiles in a row.
+     */
+    uint16_t tiles_x() const {
+        return m_tiles_x;
+    }
+
+    /**
+     * @brief Get number of tile rows.
+     * @return The number of tiles in a column.
+     */
+    uint16_t tiles_y() const {
+        return m_tiles_y;
+    }
+
+    static constexpr uint8_t M_TILE_ROWS = 8;
+    static constexpr uint8_t M_TILE_BYTES = 8;
+
+private:
+    /**
+     * @brief Compute hash of one tile.
+     * @param buffer Pointer to the frame buffer.
+     * @param tile_x Column of the tile.
+     * @param tile_y Row of the tile.
+     * @return The hash of the tile.
+     */
+    uint32_t hash_tile(const uint8_t* buffer, uint16_t tile_x, uint16_t tile_y) const;
+
+    uint32_t* m_hashes;
+    uint8_t* m_changed;
+    uint16_t m_width;
+    uint16_t m_height;
+    uint16_t m_tiles_x;
+    uint16_t m_tiles_y;
+    bool m_valid = false;
+};
+
+} // namespace EinkDisplay
@@ -0,0 +1,85 @@
+#include "time_plot.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace EinkCanvas {
+
+TimePlot::TimePlot(int16_t x, int16_t y, uint16_t w, uint16_t h, float min, float max, uint16_t capacity):
+    m_x(x), m_y(y), m_width(w), m_height(h), m_min(min), m_max(max) {
+    if (w == 0) {
+        w = m_width = 1;
+    }
+    m_per_column = capacity <= w ? 1 : (capacity + w - 1) / w;
+    // Whole columns are kept, plus the last sample before them which the oldest column reaches
+    m_capacity = m_per_column * w;
+    m_samples = new float[m_capacity + 1];
+}
+
+TimePlot::~TimePlot() {
+    delete[] m_samples;
+}
+
+bool TimePlot::append(float value) {
+    const bool new_column = m_total % m_per_column == 0;
+    if (new_column) {
+        const float previous = m_total > 0 ? sample(m_total - 1) : value;
+        m_low = std::min(previous, value);
+        m_high = std::max(previous, value);
+    } else {
+        m_low = std::min(m_low, value);
+        m_high = std::max(m_high, value);
+    }
+    m_samples[m_total % (m_capacity + 1)] = value;
+    m_total++;
+    return new_column;
+}
+
+void TimePlot::draw(GFXCanvasBW& canvas, uint16_t color) const {
+    if (m_total == 0) {
+        return;
+    }
+    const uint32_t oldest = m_total - size();
+    uint32_t column = (m_total - 1) / m_per_column;
+    for (int16_t x = m_x + m_width - 1; x >= m_x; x--, column--) {
+        const uint32_t start = std::max<uint32_t>(column * m_per_column, oldest);
+        const uint32_t end = std::min<uint32_t>((column + 1) * m_per_column, m_total);
+        float low = sample(start);
+        float high = low;
+        for (uint32_t i = start > 0 ? start - 1 : start; i < end; i++) {
+            low = std::min(low, sample(i));
+            high = std::max(high, sample(i));
+        }
+        draw_column(canvas, x, low, high, color);
+        if (start == oldest) {
+            break;
+        }
+    }
+}
+
+void TimePlot::draw_newest(GFXCanvasBW& canvas, uint16_t color) const {
+    if (m_total == 0) {
+        return;
+    }
+    draw_column(canvas, m_x + m_width - 1, m_low, m_high, color);
+}
+
+void TimePlot::clear() {
+    m_total = 0;
+}
+
+int16_t TimePlot::row(float value) const {
+    if (m_max == m_min) {
+        return m_y + m_height - 1;
+    }
+    const float scaled = (value - m_min) * (m_height - 1) / (m_max - m_min);
+    const float offset = std::max(0.0f, std::min<float>(m_height - 1, scaled));
+    return m_y + m_height - 1 - (int16_t)std::lround(offset);
+}
+
+void TimePlot::draw_column(GFXCanvasBW& canvas, int16_t x, float low, float high, uint16_t color) const {
+    const int16_t top = row(high);
+    canvas.drawFastVLine(x, top, row(low) - top + 1, color);
+}
+
+} // namespace EinkCanvas
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "canvas_bw.h"
+
+namespace EinkCanvas{
+
+/**
+ * @class TimePlot
+ * @brief Time series plot of the last samples, newest sample is in the rightmost column.
+ *
+ * Samples are kept in a ring buffer of fixed capacity. When there are more samples than
+ * columns, each column shows minimum and maximum of several consecutive samples. Column
+ * also reaches the last sample of the previous column, so the plot is continuous.
+ *
+ * Plot is drawn incrementally: appended sample extends the newest column, when it starts
+ * a new column the plot is shifted by one column to the left. Cost of an append does not
+ * depend on the capacity. See EinkDisplay::DisplayHandle::add_sample().
+ */
+class TimePlot {
+public:
+    /**
+     * @brief Construct a new plot.
+     *
+     * @param x X coordinate of the top-left corner of the plot area.
+     * @param y Y coordinate of the top-left corner of the plot area.
+     * @param w Width of the plot area, one column per pixel.
+     * @param h Height of the plot area.
+     * @param min Value shown at the bottom row, smaller values are clamped.
+     * @param max Value shown at the top row, bigger values are clamped.
+     * @param capacity Number of kept samples, defaults to one sample per column. It is rounded
+     *        up to a multiple of the width, so every column shows the same number of samples.
+     */
+    TimePlot(int16_t x, int16_t y, uint16_t w, uint16_t h, float min, float max, uint16_t capacity = 0);
+
+    ~TimePlot();
+
+    TimePlot(const TimePlot&) = delete;
+    TimePlot& operator=(const TimePlot&) = delete;
+
+    /**
+     * @brief Append a sample.
+     *
+     * @param value Value of the sample.
+     * @return true if the sample starts a new column, so the plot has to be shifted.
+     */
+    bool append(float value);
+
+    /**
+     * @brief Draw all columns, plot area has to be cleared first.
+     *
+     * @param canvas Canvas to draw into.
+     * @param color Color of the plot (any non-zero value is treated as "on").
+     */
+    void draw(GFXCanvasBW& canvas, uint16_t color) const;
+
+    /**
+     * @brief Draw the newest column into the rightmost column of the plot area.
+     *
+     * @param canvas Canvas to draw into.
+     * @param color Color of the plot (any non-zero value is treated as "on").
+     */
+    void draw_newest(GFXCanvasBW& canvas, uint16_t color) const;
+
+    /**
+     * @brief Remove all samples.
+     */
+    void clear();
+
+    int16_t x() const {
+        return m_x;
+    }
+
+    int16_t y() const {
+        return m_y;
+    }
+
+    uint16_t width() const {
+        return m_width;
+    }
+
+    uint16_t height() const {
+        return m_height;
+    }
+
+    /**
+     * @brief Get number of kept samples.
+     */
+    uint32_t size() const {
+        return m_total < m_capacity ? m_total : m_capacity;
+    }
+
+private:
+    /**
+     * @brief Get a kept sample.
+     * @param index Index of the sample counted from the first appended sample.
+     */
+    float sample(uint32_t index) const {
+        return m_samples[index % (m_capacity + 1)];
+    }
+
+    /**
+     * @brief Convert value to a row of the plot area.
+     */
+    int16_t row(float value) const;
+
+    /**
+     * @brief Draw a column from the lowest to the highest value.
+     */
+    void draw_column(GFXCanvasBW& canvas, int16_t x, float low, float high, uint16_t color) const;
+
+    int16_t m_x;
+    int16_t m_y;
+    uint16_t m_width;
+    uint16_t m_height;
+    float m_min;
+    float m_max;
+    uint32_t m_capacity;
+    uint16_t m_per_column;
+    float* m_samples;
+    uint32_t m_total = 0;
+
+    // Range of the newest column, including the last sample of the previous one
+    float m_low = 0;
+    float m_high = 0;
+};
+
+} // namespace EinkCanvas
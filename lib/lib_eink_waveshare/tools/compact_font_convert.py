@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""Convert BDF font to compact font of the e-ink library (EinkDisplay::CompactFont).
+
+TrueType fonts are rasterized to BDF first, e.g. by otf2bdf:
+    otf2bdf -p 12 -r 72 NotoSans-Regular.ttf -o noto12.bdf
+
+Usage: compact_font_convert.py font.bdf name [ranges] > name.h
+    ranges  Codepoints to keep, e.g. 0x20-0x7E,0xA0-0x17F,0x20AC. All glyphs by default.
+"""
+
+import sys
+
+
+def parse_ranges(text):
+    codepoints = set()
+    for part in text.split(","):
+        first, _, last = part.partition("-")
+        codepoints.update(range(int(first, 0), int(last or first, 0) + 1))
+    return codepoints
+
+
+def parse_bdf(lines):
+    """Return (y_advance, glyphs), glyph is (codepoint, advance, x_offset, y_offset, width, height, pixels)."""
+    ascent = descent = None
+    line_height = 0
+    glyphs = []
+    glyph = None
+    bitmap = None
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+        key = words[0]
+        if key == "FONTBOUNDINGBOX":
+            line_height = int(words[2])
+        elif key == "FONT_ASCENT":
+            ascent = int(words[1])
+        elif key == "FONT_DESCENT":
+            descent = int(words[1])
+        elif key == "STARTCHAR":
+            glyph = {"advance": 0}
+        elif key == "ENCODING":
+            glyph["codepoint"] = int(words[1])
+        elif key == "DWIDTH":
+            glyph["advance"] = int(words[1])
+        elif key == "BBX":
+            glyph["bbx"] = [int(word) for word in words[1:5]]
+        elif key == "BITMAP":
+            bitmap = []
+        elif key == "ENDCHAR":
+            width, height, x_offset, y_offset = glyph["bbx"]
+            pixels = []
+            for row in bitmap[:height]:
+                value = int(row, 16)
+                bits = len(row) * 4
+                pixels.extend((value >> (bits - 1 - x)) & 1 for x in range(width))
+            if glyph["codepoint"] >= 0:
+                glyphs.append((glyph["codepoint"], glyph["advance"], x_offset,
+                               -(y_offset + height), width, height, pixels))
+            glyph = bitmap = None
+        elif bitmap is not None:
+            bitmap.append(key)
+    if ascent is not None and descent is not None:
+        line_height = ascent + descent
+    return line_height, glyphs
+
+
+def encode(pixels):
+    """Encode pixels by runs 0cnnnnnn of up to 64 pixels and literals 1xxxxxxx of 7 pixels."""
+    out = bytearray()
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while i + run < len(pixels) and pixels[i + run] == pixels[i] and run < 64:
+            run += 1
+        if run > 7 or i + run == len(pixels):
+            out.append((pixels[i] << 6) | (run - 1))
+            i += run
+        else:
+            literal = 0x80
+            for bit, pixel in enumerate(pixels[i:i + 7]):
+                literal |= pixel << (6 - bit)
+            out.append(literal)
+            i += 7
+    return out
+
+
+def convert(name, y_advance, glyphs):
+    glyphs = sorted(glyphs)
+    bitmap = bytearray()
+    glyph_lines = []
+    ranges = []
+    for index, (codepoint, advance, x_offset, y_offset, width, height, pixels) in enumerate(glyphs):
+        if not (0 <= width < 256 and 0 <= height < 256 and -128 <= x_offset < 128 and -128 <= y_offset < 128):
+            raise ValueError(f"glyph U+{codepoint:04X} is too large")
+        glyph_lines.append(f"    {{{len(bitmap)}, {width}, {height}, {advance}, {x_offset}, {y_offset}}}, // U+{codepoint:04X}")
+        bitmap += encode(pixels)
+        if ranges and ranges[-1][0] + ranges[-1][1] == codepoint and ranges[-1][1] < 0xFFFF:
+            ranges[-1][1] += 1
+        else:
+            ranges.append([codepoint, 1, index])
+    if len(bitmap) >= 1 << 24:
+        raise ValueError("bitmap is too large")
+
+    out = [f"// Generated by compact_font_convert.py, {len(glyphs)} glyphs, {len(bitmap)} bytes of bitmap",
+           "#pragma once", "", "#include <compact_font.h>", "",
+           f"const uint8_t {name}Bitmap[] PROGMEM = {{"]
+    for i in range(0, len(bitmap), 16):
+        out.append("    " + " ".join(f"0x{byte:02X}," for byte in bitmap[i:i + 16]))
+    out += ["};", "", f"const EinkDisplay::CompactGlyph {name}Glyphs[] PROGMEM = {{"] + glyph_lines
+    out += ["};", "", f"const EinkDisplay::CompactRange {name}Ranges[] PROGMEM = {{"]
+    out += [f"    {{0x{first:04X}, {count}, {index}}}," for first, count, index in ranges]
+    out += ["};", "",
+            f"const EinkDisplay::CompactFont {name} PROGMEM = {{{name}Bitmap, {name}Glyphs, {name}Ranges, {len(ranges)}, {y_advance}}};",
+            ""]
+    raw = sum((g[4] * g[5] + 7) // 8 + 7 for g in glyphs)
+    compact = len(bitmap) + 8 * len(glyphs) + 8 * len(ranges)
+    print(f"{len(glyphs)} glyphs in {len(ranges)} ranges: {compact} bytes, GFXfont bitmap and glyphs {raw} bytes",
+          file=sys.stderr)
+    return "\n".join(out)
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        print(__doc__, file=sys.stderr)
+        sys.exit(1)
+    with open(sys.argv[1], encoding="latin-1") as file:
+        y_advance, glyphs = parse_bdf(file)
+    if len(sys.argv) == 4:
+        keep = parse_ranges(sys.argv[3])
+        glyphs = [glyph for glyph in glyphs if glyph[0] in keep]
+    print(convert(sys.argv[2], y_advance, glyphs))
+
+
+if __name__ == "__main__":
+    main()
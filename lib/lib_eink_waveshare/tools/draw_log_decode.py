@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""List draw log of the e-ink library written by EinkDisplay::DrawRecorder.
+
+Every call is printed with its time and arguments, followed by summary of calls
+and log bytes per frame. Metrics of rendering are measured by DisplayHandle::replay().
+
+Usage: draw_log_decode.py screen.log
+"""
+
+import sys
+
+CALLS = {
+    1: "clear_frame",
+    2: "display_frame",
+    3: "clear_buffer",
+    4: "draw_pixel",
+    5: "draw_line",
+    6: "draw_rect",
+    7: "fill_rect",
+    8: "draw_circle",
+    9: "fill_circle",
+    10: "scroll_region",
+    11: "print",
+    12: "text",
+    13: "draw_bitmap",
+    14: "rows",
+    15: "set_font",
+    16: "set_rotation",
+    17: "push_viewport",
+    18: "pop_viewport",
+    19: "add_layer",
+    20: "select_layer",
+    21: "set_layer_op",
+    22: "set_layer_visible",
+}
+
+TEXT_CALLS = (11, 12)
+FRAME_CALL = 2
+
+
+def read_varint(data, offset):
+    value = 0
+    shift = 0
+    while True:
+        if offset >= len(data):
+            raise ValueError("draw log is truncated")
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, offset
+
+
+def decode(data):
+    if data[:4] != b"EKDL":
+        raise ValueError("not a draw log")
+    version = int.from_bytes(data[4:6], "little")
+    if version != 1:
+        raise ValueError(f"unsupported draw log version {version}")
+    offset = 6
+    time = 0
+    records = []
+    while offset < len(data):
+        if offset + 2 > len(data):
+            raise ValueError("draw log is truncated")
+        head, count = data[offset], data[offset + 1]
+        start = offset
+        delta, offset = read_varint(data, offset + 2)
+        time += delta
+        args = []
+        for _ in range(count):
+            value, offset = read_varint(data, offset)
+            args.append((value >> 1) ^ -(value & 1))
+        payload = None
+        if head & 0x80:
+            length, offset = read_varint(data, offset)
+            payload = data[offset:offset + length]
+            if len(payload) != length:
+                raise ValueError("draw log is truncated")
+            offset += length
+        records.append((time, head & 0x7F, args, payload, offset - start))
+    return records
+
+
+def describe(call, args, payload):
+    name = CALLS.get(call, f"call_{call}")
+    text = f"{name}({', '.join(str(arg) for arg in args)})"
+    if payload is not None:
+        if call in TEXT_CALLS:
+            text += f" {payload.decode('utf-8', 'replace')!r}"
+        else:
+            text += f" [{len(payload)} bytes]"
+    return text
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+    with open(sys.argv[1], "rb") as file:
+        records = decode(file.read())
+
+    frame = 0
+    calls = 0
+    size = 0
+    for time, call, args, payload, length in records:
+        print(f"{time / 1e6:12.6f}  {describe(call, args, payload)}")
+        calls += 1
+        size += length
+        if call == FRAME_CALL:
+            print(f"--- frame {frame}: {calls} calls, {size} bytes")
+            frame += 1
+            calls = 0
+            size = 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""Send images to the display as delta-compressed frames, see EinkDisplay::FrameReceiver.
+
+Every image is converted to black and white and compared with the previous frame
+tile by tile. Only XOR deltas of changed tiles are sent, run-length encoded. Device
+answers every frame, after NAK the stream starts again by reset and a whole frame.
+
+Usage: frame_stream_send.py [options] PORT IMAGE...
+       frame_stream_send.py [options] --output stream.bin IMAGE...
+
+Binary PBM images of the canvas size are read directly, other formats require Pillow.
+Sending to a port requires pyserial.
+"""
+
+import argparse
+import sys
+import time
+
+SYNC = b"\xA5\x5A"
+TILE, END, RESET = 1, 2, 3
+ACK, NAK = 0x06, 0x15
+REFRESH_MODES = {"auto": 0, "full": 1, "partial": 2, "fast": 3}
+MAX_PAYLOAD = 1024
+
+
+def fletcher16(data, checksum=0):
+    low, high = checksum & 0xFF, checksum >> 8
+    for byte in data:
+        low = (low + byte) % 255
+        high = (high + low) % 255
+    return (high << 8) | low
+
+
+def packet(kind, payload=b""):
+    header = bytes([kind]) + len(payload).to_bytes(2, "little")
+    checksum = fletcher16(payload, fletcher16(header))
+    return SYNC + header + payload + checksum.to_bytes(2, "little")
+
+
+def encode_delta(delta):
+    """Run-length encode XOR delta, zero runs are skipped by the device."""
+    out = bytearray()
+    i = 0
+    literal = bytearray()
+
+    def flush():
+        for start in range(0, len(literal), 128):
+            chunk = literal[start:start + 128]
+            out.append(0x80 | (len(chunk) - 1))
+            out.extend(chunk)
+        literal.clear()
+
+    while i < len(delta):
+        run = 1
+        while i + run < len(delta) and delta[i + run] == delta[i] and run < 64:
+            run += 1
+        if delta[i] == 0 and (run >= 2 or not literal):
+            flush()
+            out.append(run - 1)
+        elif run >= 3:
+            flush()
+            out.extend((0x40 | (run - 1), delta[i]))
+        else:
+            literal.extend(delta[i:i + run])
+        i += run
+    flush()
+    return bytes(out)
+
+
+def load_pbm(data, width, height):
+    """Binary PBM has the same packing as the canvas, but black is 1."""
+    fields = []
+    offset = 0
+    while len(fields) < 3:
+        while data[offset:offset + 1].isspace():
+            offset += 1
+        if data[offset:offset + 1] == b"#":
+            offset = data.index(b"\n", offset)
+            continue
+        end = offset
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[offset:end])
+        offset = end
+    if (int(fields[1]), int(fields[2])) != (width, height):
+        raise ValueError(f"image has to be {width}x{height}")
+    pixels = data[offset + 1:offset + 1 + width // 8 * height]
+    return bytearray(byte ^ 0xFF for byte in pixels)
+
+
+def load_frame(path, width, height):
+    with open(path, "rb") as file:
+        data = file.read()
+    if data.startswith(b"P4"):
+        return load_pbm(data, width, height)
+
+    from PIL import Image
+
+    image = Image.open(path).convert("L")
+    if image.size != (width, height):
+        image = image.resize((width, height))
+    # Mode "1" packs rows MSB first with white as 1, same as the canvas
+    return bytearray(image.convert("1", dither=Image.Dither.FLOYDSTEINBERG).tobytes())
+
+
+def encode_frame(frame, previous, stride, height, tile_width, tile_height, mode):
+    """Return packets of changed tiles and end of the frame."""
+    packets = []
+    for y in range(0, height, tile_height):
+        rows = min(tile_height, height - y)
+        for x in range(0, stride, tile_width):
+            width = min(tile_width, stride - x)
+            delta = bytes(
+                frame[(y + r) * stride + x + c] ^ previous[(y + r) * stride + x + c]
+                for r in range(rows) for c in range(width)
+            )
+            if not any(delta):
+                continue
+            header = bytes([x]) + y.to_bytes(2, "little") + bytes([width]) + rows.to_bytes(2, "little")
+            packets.append(packet(TILE, header + encode_delta(delta)))
+    packets.append(packet(END, bytes([REFRESH_MODES[mode]])))
+    return packets
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port", nargs="?", help="serial port of the device")
+    parser.add_argument("images", nargs="+", help="images sent one after another")
+    parser.add_argument("--output", help="write the stream into a file instead of a port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--width", type=int, default=200, help="width of the canvas, multiple of 8")
+    parser.add_argument("--height", type=int, default=200, help="height of the canvas")
+    parser.add_argument("--tile", type=int, default=32, help="tile size in pixels, multiple of 8")
+    parser.add_argument("--mode", choices=REFRESH_MODES, default="auto", help="requested refresh")
+    parser.add_argument("--interval", type=float, default=0, help="delay between frames in seconds")
+    args = parser.parse_args()
+
+    if args.output is None and args.port is None:
+        parser.error("port or --output is required")
+    if args.output is not None and args.port is not None:
+        args.images.insert(0, args.port)
+    if args.width % 8 or args.tile % 8:
+        parser.error("width and tile size have to be multiples of 8")
+
+    stride = args.width // 8
+    tile_width = args.tile // 8
+    # Tiles are limited by the largest payload the device accepts
+    tile_height = min(args.tile, (MAX_PAYLOAD - 6) * 128 // 129 // tile_width)
+
+    if args.output is not None:
+        link = open(args.output, "wb")
+    else:
+        import serial
+
+        link = serial.Serial(args.port, args.baud, timeout=60)
+
+    previous = bytearray(b"\xFF" * (stride * args.height))
+    reset = True
+    for path in args.images:
+        frame = load_frame(path, args.width, args.height)
+        while True:
+            packets = [packet(RESET, b"\x01")] if reset else []
+            base = bytearray(b"\xFF" * len(frame)) if reset else previous
+            packets += encode_frame(frame, base, stride, args.height, tile_width, tile_height, args.mode)
+            data = b"".join(packets)
+            start = time.monotonic()
+            link.write(data)
+            answer = ACK
+            if args.output is None:
+                link.flush()
+                response = link.read(1)
+                answer = response[0] if response else NAK
+                # Drop anything left from a rejected frame
+                link.reset_input_buffer()
+            elapsed = time.monotonic() - start
+            print(f"{path}: {len(packets) - 1} packets, {len(data)} bytes, {elapsed * 1000:.0f} ms"
+                  + ("" if answer == ACK else ", rejected"))
+            if answer == ACK:
+                break
+            reset = True
+        previous = frame
+        reset = False
+        time.sleep(args.interval)
+    link.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Decode binary trace of the e-ink library written by trace::dump().
+
+Usage: trace_decode.py trace.bin
+"""
+
+import struct
+import sys
+
+EVENTS = {
+    1: "upload_start",
+    2: "upload_end",
+    3: "busy_start",
+    4: "busy_end",
+    5: "refresh",
+    6: "unchanged",
+    7: "clear",
+}
+
+WAVEFORMS = {0: "full", 1: "partial", 2: "fast"}
+
+
+def decode(data):
+    start = data.find(b"EKTR")
+    if start < 0:
+        raise ValueError("trace header not found")
+    version, record_size, count = struct.unpack_from("<HHI", data, start + 4)
+    if version != 1:
+        raise ValueError(f"unsupported trace version {version}")
+    offset = start + 12
+    records = []
+    for i in range(count):
+        time, sequence, event, arg, a, b, c, d = struct.unpack_from("<IHBBHHHH", data, offset + i * record_size)
+        records.append((time, sequence, event, arg, (a, b, c, d)))
+    return records
+
+
+def describe(event, arg, values):
+    name = EVENTS.get(event, f"event_{event}")
+    if event in (1, 5):
+        text = f"{name} ({values[0]}, {values[1]}) - ({values[2]}, {values[3]})"
+        return text + (f" {WAVEFORMS.get(arg, arg)}" if event == 5 else "")
+    if event == 4:
+        return f"{name} {values[0]} ms"
+    if event == 7:
+        return f"{name} {'white' if arg else 'black'}"
+    return name
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+    with open(sys.argv[1], "rb") as file:
+        records = decode(file.read())
+
+    previous_time = None
+    previous_sequence = None
+    for time, sequence, event, arg, values in records:
+        if previous_sequence is not None and (sequence - previous_sequence) & 0xFFFF != 1:
+            print("... events lost ...")
+        delta = 0 if previous_time is None else (time - previous_time) & 0xFFFFFFFF
+        print(f"{time / 1e6:12.6f} +{delta / 1e3:9.3f} ms  {describe(event, arg, values)}")
+        previous_time = time
+        previous_sequence = sequence
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -3,8 +3,6 @@
  * @brief Demo showing capabilities of the display and the library.
  */
 
-#define DEBUG true
-
 #include <Arduino.h>
 
 #include <Fonts/FreeMono9pt7b.h>
@@ -24,6 +22,14 @@ auto handle = EinkDisplay::DisplayHandle<EinkDriver::Eink1in54>(EPD_CS, EPD_DC,
 uint8_t hour = 11;
 uint8_t minute = 35;
 uint8_t second = 20;
+uint8_t clock_layer = 0;
+
+// Clock text and the box around its glyphs in FreeMonoBold12pt7b, 8 characters 14 pixels each
+constexpr int16_t CLOCK_X = 70;
+constexpr int16_t CLOCK_BASELINE = 90;
+constexpr int16_t CLOCK_TOP = CLOCK_BASELINE - 20;
+constexpr int16_t CLOCK_WIDTH = 8 * 14;
+constexpr int16_t CLOCK_HEIGHT = 24;
 
 void setup(){
   Serial.begin(115200);
@@ -46,13 +52,13 @@ void setup(){
   handle.display_frame();
   handle.display_frame();
 
+  // Clock is drawn into its own layer, so the background is never erased or redrawn
+  clock_layer = handle.add_layer(EinkCanvas::BlendOp::AND);
+  handle.select_layer(clock_layer);
   handle.set_font(&FreeMonoBold12pt7b);
-  
 }
 
 void loop(){
-
-  handle.printf(70, 90, EinkColor::WHITE, "%02d:%02d:%02d", hour, minute, second);
   second++;  
   if(second == 60){
     second = 0;
@@ -68,7 +74,10 @@ void loop(){
   if(hour == 24){
     hour = 0;
   }
-  handle.printf(70, 90, EinkColor::BLACK, "%02d:%02d:%02d", hour, minute, second);
+  // Only the old time is erased, white is transparent for AND. Clearing the whole layer would
+  // mark the whole screen dirty and compose and hash all of it every second.
+  handle.fill_rect(CLOCK_X, CLOCK_TOP, CLOCK_WIDTH, CLOCK_HEIGHT, EinkColor::WHITE);
+  handle.print_fields(CLOCK_X, CLOCK_BASELINE, EinkColor::BLACK, EinkFormat::Time<>{hour, minute, second});
   handle.display_frame();
   delay(1000);
 }
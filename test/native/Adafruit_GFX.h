@@ -0,0 +1,201 @@
+#pragma once
+
+// Subset of Adafruit GFX used by the library, for host tests
+
+#include <Arduino.h>
+
+#include "gfxfont.h"
+
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h), _width(w), _height(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+        for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+    }
+
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+        for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+    }
+
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        for (int16_t i = 0; i < h; i++) drawFastHLine(x, y + i, w, color);
+    }
+
+    virtual void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+
+    virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+        const bool steep = abs(y1 - y0) > abs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        const int16_t dx = x1 - x0, dy = abs(y1 - y0), step = y0 < y1 ? 1 : -1;
+        int16_t err = dx / 2;
+        for (; x0 <= x1; x0++) {
+            steep ? drawPixel(y0, x0, color) : drawPixel(x0, y0, color);
+            err -= dy;
+            if (err < 0) {
+                y0 += step;
+                err += dx;
+            }
+        }
+    }
+
+    virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        drawFastHLine(x, y, w, color);
+        drawFastHLine(x, y + h - 1, w, color);
+        drawFastVLine(x, y, h, color);
+        drawFastVLine(x + w - 1, y, h, color);
+    }
+
+    virtual void setRotation(uint8_t r) {
+        rotation = r & 3;
+        _width = (rotation & 1) ? HEIGHT : WIDTH;
+        _height = (rotation & 1) ? WIDTH : HEIGHT;
+    }
+
+    void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+        int16_t f = 1 - r, ddx = 1, ddy = -2 * r, x = 0, y = r;
+        drawPixel(x0, y0 + r, color);
+        drawPixel(x0, y0 - r, color);
+        drawPixel(x0 + r, y0, color);
+        drawPixel(x0 - r, y0, color);
+        while (x < y) {
+            if (f >= 0) {
+                y--;
+                ddy += 2;
+                f += ddy;
+            }
+            x++;
+            ddx += 2;
+            f += ddx;
+            for (int16_t sx : {x, (int16_t)-x}) {
+                for (int16_t sy : {y, (int16_t)-y}) {
+                    drawPixel(x0 + sx, y0 + sy, color);
+                    drawPixel(x0 + sy, y0 + sx, color);
+                }
+            }
+        }
+    }
+
+    void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+        for (int16_t dy = -r; dy <= r; dy++) {
+            const int16_t dx = (int16_t)std::sqrt((float)r * r - (float)dy * dy);
+            drawFastHLine(x0 - dx, y0 + dy, 2 * dx + 1, color);
+        }
+    }
+
+    void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color) {
+        const int16_t stride = (w + 7) / 8;
+        for (int16_t j = 0; j < h; j++)
+            for (int16_t i = 0; i < w; i++)
+                if (bitmap[j * stride + i / 8] & (0x80 >> (i & 7))) drawPixel(x + i, y + j, color);
+    }
+
+    void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+        const int16_t stride = (w + 7) / 8;
+        for (int16_t j = 0; j < h; j++)
+            for (int16_t i = 0; i < w; i++)
+                drawPixel(x + i, y + j, (bitmap[j * stride + i / 8] & (0x80 >> (i & 7))) ? color : bg);
+    }
+
+    /// Glyphs of GFX fonts are drawn, the classic font is drawn as a filled cell
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t, uint8_t) {
+        if (!gfxFont) {
+            fillRect(x, y, 5, 7, color);
+            return;
+        }
+        if (c < gfxFont->first || c > gfxFont->last) return;
+        const GFXglyph& glyph = gfxFont->glyph[c - gfxFont->first];
+        const uint8_t* bitmap = gfxFont->bitmap + glyph.bitmapOffset;
+        uint16_t bit = 0;
+        for (uint8_t j = 0; j < glyph.height; j++)
+            for (uint8_t i = 0; i < glyph.width; i++, bit++)
+                if (bitmap[bit / 8] & (0x80 >> (bit & 7)))
+                    drawPixel(x + glyph.xOffset + i, y + glyph.yOffset + j, color);
+    }
+
+    size_t write(uint8_t c) override {
+        if (c == '\n') {
+            cursor_x = 0;
+            cursor_y += gfxFont ? gfxFont->yAdvance : 8;
+        } else if (c != '\r') {
+            drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, 1);
+            cursor_x += advance(c);
+        }
+        return 1;
+    }
+    using Print::write;
+
+    void getTextBounds(const char* text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+        int16_t min_x = INT16_MAX, min_y = INT16_MAX, max_x = INT16_MIN, max_y = INT16_MIN;
+        for (int16_t cx = x, cy = y; *text; text++) {
+            const unsigned char c = *text;
+            if (c == '\n') {
+                cx = x;
+                cy += gfxFont ? gfxFont->yAdvance : 8;
+                continue;
+            }
+            int16_t gx = cx, gy = cy, gw = 6, gh = 8;
+            if (gfxFont) {
+                if (c < gfxFont->first || c > gfxFont->last) continue;
+                const GFXglyph& glyph = gfxFont->glyph[c - gfxFont->first];
+                gx += glyph.xOffset;
+                gy += glyph.yOffset;
+                gw = glyph.width;
+                gh = glyph.height;
+            }
+            if (gw > 0 && gh > 0) {
+                min_x = std::min(min_x, gx);
+                min_y = std::min(min_y, gy);
+                max_x = std::max<int16_t>(max_x, gx + gw - 1);
+                max_y = std::max<int16_t>(max_y, gy + gh - 1);
+            }
+            cx += advance(c);
+        }
+        *x1 = min_x > max_x ? x : min_x;
+        *y1 = min_y > max_y ? y : min_y;
+        *w = min_x > max_x ? 0 : max_x - min_x + 1;
+        *h = min_y > max_y ? 0 : max_y - min_y + 1;
+    }
+
+    void setCursor(int16_t x, int16_t y) {
+        cursor_x = x;
+        cursor_y = y;
+    }
+    void setTextColor(uint16_t color) { textcolor = textbgcolor = color; }
+    void setTextColor(uint16_t color, uint16_t bg) {
+        textcolor = color;
+        textbgcolor = bg;
+    }
+    void setTextWrap(bool w) { wrap = w; }
+    void setFont(const GFXfont* font) { gfxFont = (GFXfont*)font; }
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+    uint8_t getRotation() const { return rotation; }
+    int16_t getCursorX() const { return cursor_x; }
+    int16_t getCursorY() const { return cursor_y; }
+
+protected:
+    const int16_t WIDTH, HEIGHT;
+    int16_t _width, _height;
+    int16_t cursor_x = 0, cursor_y = 0;
+    uint16_t textcolor = 0xFFFF, textbgcolor = 0xFFFF;
+    uint8_t rotation = 0;
+    bool wrap = true;
+    GFXfont* gfxFont = nullptr;
+
+private:
+    int16_t advance(unsigned char c) const {
+        if (!gfxFont) return 6;
+        return c < gfxFont->first || c > gfxFont->last ? 0 : gfxFont->glyph[c - gfxFont->first].xAdvance;
+    }
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+// Minimal Arduino core for host tests, see [env:native] in platformio.ini
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <string>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define MSBFIRST 1
+#define SPI_MODE0 0
+#define PROGMEM
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define pgm_read_byte(a) (*(const uint8_t*)(a))
+#define pgm_read_word(a) (*(const uint16_t*)(a))
+#define pgm_read_dword(a) (*(const uint32_t*)(a))
+#define pgm_read_ptr(a) (*(void* const*)(a))
+
+namespace ArduinoStub {
+
+/// Levels of output pins, read back by digitalRead() unless read_pin is set
+inline uint8_t pins[64];
+
+/// Optional override of digitalRead(), e.g. to simulate the busy pin
+inline std::function<int(uint8_t)> read_pin;
+
+/// Optional observer of digitalWrite(), called before the level is stored
+inline std::function<void(uint8_t, uint8_t)> write_pin;
+
+/// Time added by delay(), so tests do not sleep
+inline uint64_t delayed_us = 0;
+
+inline uint64_t now_us() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() + delayed_us;
+}
+
+} // namespace ArduinoStub
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    if (ArduinoStub::write_pin) ArduinoStub::write_pin(pin, value);
+    ArduinoStub::pins[pin & 63] = value;
+}
+inline int digitalRead(uint8_t pin) {
+    return ArduinoStub::read_pin ? ArduinoStub::read_pin(pin) : ArduinoStub::pins[pin & 63];
+}
+inline void delay(uint32_t ms) { ArduinoStub::delayed_us += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(uint32_t us) { ArduinoStub::delayed_us += us; }
+inline unsigned long millis() { return ArduinoStub::now_us() / 1000; }
+inline unsigned long micros() { return ArduinoStub::now_us(); }
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return printf("%d", value); }
+    size_t println(const char* text) { return print(text) + print("\n"); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        const int n = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return n > 0 ? write((const uint8_t*)buffer, std::min<size_t>(n, sizeof(buffer) - 1)) : 0;
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    virtual void flush() {}
+    size_t readBytes(uint8_t* buffer, size_t size) {
+        size_t i = 0;
+        for (; i < size; i++) {
+            const int c = read();
+            if (c < 0) break;
+            buffer[i] = c;
+        }
+        return i;
+    }
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    using Print::write;
+};
+
+inline HardwareSerial Serial;
@@ -0,0 +1,51 @@
+#pragma once
+
+// File system over stdio for host tests
+
+#include <Arduino.h>
+
+namespace fs {
+
+class File : public Stream {
+public:
+    File(FILE* file = nullptr) : m_file(file) {}
+    explicit operator bool() const { return m_file != nullptr; }
+    size_t read(uint8_t* buffer, size_t size) { return m_file ? fread(buffer, 1, size, m_file) : 0; }
+    int read() override { return m_file ? fgetc(m_file) : -1; }
+    int available() override { return m_file ? size() - position() : 0; }
+    size_t write(uint8_t c) override { return m_file ? fwrite(&c, 1, 1, m_file) : 0; }
+    size_t write(const uint8_t* buffer, size_t size) override { return m_file ? fwrite(buffer, 1, size, m_file) : 0; }
+    using Print::write;
+    bool seek(uint32_t position) { return m_file && fseek(m_file, position, SEEK_SET) == 0; }
+    size_t position() const { return m_file ? ftell(m_file) : 0; }
+    size_t size() const {
+        if (!m_file) return 0;
+        const long position = ftell(m_file);
+        fseek(m_file, 0, SEEK_END);
+        const long size = ftell(m_file);
+        fseek(m_file, position, SEEK_SET);
+        return size;
+    }
+    void close() {
+        if (m_file) fclose(m_file);
+        m_file = nullptr;
+    }
+
+private:
+    FILE* m_file;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode) {
+        return File(fopen(path, mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb"));
+    }
+    bool exists(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if (file) fclose(file);
+        return file != nullptr;
+    }
+};
+
+} // namespace fs
+
@@ -0,0 +1,31 @@
+#pragma once
+
+// SPI bus for host tests, written bytes are handed to ArduinoStub::spi_write
+
+#include <Arduino.h>
+
+#define VSPI 3
+#define SCK 18
+#define MISO 19
+#define MOSI 23
+
+namespace ArduinoStub {
+
+/// Receives every byte written to the bus, the level of the D/C pin tells command from data
+inline std::function<void(const uint8_t*, size_t)> spi_write;
+
+} // namespace ArduinoStub
+
+class SPIClass {
+public:
+    SPIClass(uint8_t) {}
+    void begin(int8_t, int8_t, int8_t, int8_t) {}
+    void setBitOrder(uint8_t) {}
+    void setDataMode(uint8_t) {}
+    void setFrequency(uint32_t) {}
+    void setHwCs(bool) {}
+    void write(uint8_t data) { writeBytes(&data, 1); }
+    void writeBytes(const uint8_t* data, uint32_t size) {
+        if (ArduinoStub::spi_write) ArduinoStub::spi_write(data, size);
+    }
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+// Records commands sent to the display controller for host tests
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Records every command with its data, the transaction it was sent in and
+ * the time waited by delay() before it.
+ *
+ * Command bytes are told from data bytes by the level of the D/C pin, a transaction is
+ * a period of low chip select.
+ */
+class CommandRecorder {
+public:
+    struct Entry {
+        uint8_t command;
+        std::vector<uint8_t> data;
+        uint32_t transaction;  ///< Number of the transaction, first is 1
+        uint32_t delay_ms;     ///< Time waited by delay() since the previous byte
+    };
+
+    CommandRecorder(uint8_t cs, uint8_t dc) : m_cs(cs), m_dc(dc) {
+        ArduinoStub::write_pin = [this](uint8_t pin, uint8_t value) {
+            if (pin == m_cs && value == LOW && ArduinoStub::pins[pin] == HIGH) m_transaction++;
+        };
+        ArduinoStub::spi_write = [this](const uint8_t* data, size_t size) {
+            if (ArduinoStub::pins[m_dc] == LOW) {
+                for (size_t i = 0; i < size; i++) {
+                    entries.push_back({data[i], {}, m_transaction, (uint32_t)((ArduinoStub::delayed_us - m_last_us) / 1000)});
+                    m_last_us = ArduinoStub::delayed_us;
+                }
+                return;
+            }
+            if (!entries.empty()) {
+                entries.back().data.insert(entries.back().data.end(), data, data + size);
+            }
+            m_last_us = ArduinoStub::delayed_us;
+        };
+        clear();
+    }
+
+    ~CommandRecorder() {
+        ArduinoStub::write_pin = nullptr;
+        ArduinoStub::spi_write = nullptr;
+    }
+
+    CommandRecorder(const CommandRecorder&) = delete;
+    CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+    void clear() {
+        entries.clear();
+        m_transaction = 0;
+        m_last_us = ArduinoStub::delayed_us;
+    }
+
+    /**
+     * @brief Find the last entry of a command.
+     * @return The entry or nullptr if the command was not sent.
+     */
+    const Entry* find(uint8_t command) const {
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            if (it->command == command) return &*it;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Text form of the entries, one line per command, e.g. "1 +10ms 22: C4".
+     * Data longer than 8 bytes are shortened to their size.
+     */
+    std::string format() const {
+        std::string text;
+        char line[64];
+        for (const Entry& entry : entries) {
+            int n = snprintf(line, sizeof(line), "%lu", (unsigned long)entry.transaction);
+            if (entry.delay_ms > 0) {
+                n += snprintf(line + n, sizeof(line) - n, " +%lums", (unsigned long)entry.delay_ms);
+            }
+            n += snprintf(line + n, sizeof(line) - n, " %02X:", entry.command);
+            if (entry.data.size() > 8) {
+                n += snprintf(line + n, sizeof(line) - n, " %u bytes", (unsigned)entry.data.size());
+            } else {
+                for (uint8_t byte : entry.data) {
+                    n += snprintf(line + n, sizeof(line) - n, " %02X", byte);
+                }
+            }
+            text += line;
+            text += '\n';
+        }
+        return text;
+    }
+
+    std::vector<Entry> entries;
+
+private:
+    uint8_t m_cs;
+    uint8_t m_dc;
+    uint32_t m_transaction = 0;
+    uint64_t m_last_us = 0;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+// Model of the RAM of the IL3829 controller for host tests
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include <vector>
+
+/**
+ * @brief Writes bytes sent by command 0x24 into a model of the controller RAM.
+ *
+ * Window (0x44, 0x45), address counters (0x4E, 0x4F) and data entry mode (0x11) are
+ * followed the same way as by the controller: after every byte X counter moves in the
+ * direction of the entry mode, when it passes the window it starts again and Y counter moves.
+ * Bits of a byte are always MSB left, whatever the direction of X counter is.
+ */
+class PanelModel {
+public:
+    static constexpr uint16_t WIDTH = 200;
+    static constexpr uint16_t HEIGHT = 200;
+    static constexpr uint16_t STRIDE = WIDTH / 8;
+
+    explicit PanelModel(uint8_t dc) : ram(STRIDE * HEIGHT, 0x55), m_dc(dc) {
+        ArduinoStub::spi_write = [this](const uint8_t* data, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                if (ArduinoStub::pins[m_dc] == LOW) {
+                    m_command = data[i];
+                    m_args.clear();
+                } else if (m_command == 0x24) {
+                    write(data[i]);
+                } else {
+                    m_args.push_back(data[i]);
+                    apply();
+                }
+            }
+        };
+    }
+
+    ~PanelModel() {
+        ArduinoStub::spi_write = nullptr;
+    }
+
+    PanelModel(const PanelModel&) = delete;
+    PanelModel& operator=(const PanelModel&) = delete;
+
+    /**
+     * @brief Get pixel of the panel, true is white.
+     */
+    bool pixel(uint16_t x, uint16_t y) const {
+        return ram[y * STRIDE + x / 8] & (0x80 >> (x % 8));
+    }
+
+    std::vector<uint8_t> ram;
+    uint32_t outside = 0;   ///< Bytes written with the counters outside of the RAM
+    uint32_t written = 0;   ///< Bytes written into RAM
+
+private:
+    void apply() {
+        switch (m_command) {
+        case 0x11: m_entry = m_args[0]; break;
+        case 0x44:
+            if (m_args.size() == 2) {
+                m_x_start = m_args[0];
+                m_x_end = m_args[1];
+            }
+            break;
+        case 0x45:
+            if (m_args.size() == 4) {
+                m_y_start = m_args[0] | m_args[1] << 8;
+                m_y_end = m_args[2] | m_args[3] << 8;
+            }
+            break;
+        case 0x4E: m_x = m_args[0]; break;
+        case 0x4F:
+            if (m_args.size() == 2) {
+                m_y = m_args[0] | m_args[1] << 8;
+            }
+            break;
+        default: break;
+        }
+    }
+
+    void write(uint8_t byte) {
+        written++;
+        if (m_x < STRIDE && m_y < HEIGHT) {
+            ram[m_y * STRIDE + m_x] = byte;
+        } else {
+            outside++;
+        }
+        if (m_x != m_x_end) {
+            m_x += m_entry & 0x01 ? 1 : -1;
+            return;
+        }
+        m_x = m_x_start;
+        if (m_y != m_y_end) {
+            m_y += m_entry & 0x02 ? 1 : -1;
+        } else {
+            m_y = m_y_start;
+        }
+    }
+
+    uint8_t m_dc;
+    uint8_t m_command = 0;
+    std::vector<uint8_t> m_args;
+    uint8_t m_entry = 0x03;
+    uint8_t m_x_start = 0, m_x_end = STRIDE - 1, m_x = 0;
+    uint16_t m_y_start = 0, m_y_end = HEIGHT - 1, m_y = 0;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+// Decodes traffic of the display controller for host tests
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include <vector>
+
+/**
+ * @brief Counts transactions, commands and RAM data sent over the stub SPI bus.
+ *
+ * Command bytes are told from data bytes by the level of the D/C pin, a transaction is
+ * a period of low chip select.
+ */
+class SpiMonitor {
+public:
+    SpiMonitor(uint8_t cs, uint8_t dc) : m_cs(cs), m_dc(dc) {
+        ArduinoStub::write_pin = [this](uint8_t pin, uint8_t value) {
+            if (pin == m_cs && value == LOW && ArduinoStub::pins[pin] == HIGH) transactions++;
+        };
+        ArduinoStub::spi_write = [this](const uint8_t* data, size_t size) {
+            if (ArduinoStub::pins[m_dc] == LOW) {
+                for (size_t i = 0; i < size; i++) {
+                    command = data[i];
+                    commands[command]++;
+                }
+                return;
+            }
+            bytes += size;
+            if (command == 0x24) {
+                ram_bytes += size;
+                ram.insert(ram.end(), data, data + size);
+            }
+        };
+    }
+
+    ~SpiMonitor() {
+        ArduinoStub::write_pin = nullptr;
+        ArduinoStub::spi_write = nullptr;
+    }
+
+    SpiMonitor(const SpiMonitor&) = delete;
+    SpiMonitor& operator=(const SpiMonitor&) = delete;
+
+    void reset() {
+        transactions = bytes = ram_bytes = 0;
+        ram.clear();
+        memset(commands, 0, sizeof(commands));
+    }
+
+    uint32_t transactions = 0;  ///< Periods of low chip select
+    uint32_t bytes = 0;         ///< Data bytes, commands excluded
+    uint32_t ram_bytes = 0;     ///< Data bytes written into RAM by command 0x24
+    std::vector<uint8_t> ram;   ///< The bytes written into RAM, in order of writing
+    uint32_t commands[256] = {};
+    uint8_t command = 0;        ///< The last command
+
+private:
+    uint8_t m_cs;
+    uint8_t m_dc;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+// Reads back the trace ring buffer for host tests
+
+#include <Arduino.h>
+#include <my_utils.h>
+
+#include <vector>
+
+/**
+ * @brief Output for trace::dump() which keeps the bytes and decodes them into records.
+ */
+class TraceCapture : public Print {
+public:
+    size_t write(uint8_t byte) override {
+        bytes.push_back(byte);
+        return 1;
+    }
+    using Print::write;
+
+    /**
+     * @brief Dump the ring buffer again and decode it.
+     * @return Records, oldest first, empty if the dump is malformed.
+     */
+    std::vector<trace::Record> read() {
+        bytes.clear();
+        trace::dump(*this);
+        std::vector<trace::Record> records;
+        uint16_t record_size;
+        uint32_t count;
+        if (bytes.size() < HEADER_SIZE || memcmp(bytes.data(), "EKTR", 4) != 0) {
+            return records;
+        }
+        memcpy(&record_size, &bytes[6], sizeof(record_size));
+        memcpy(&count, &bytes[8], sizeof(count));
+        if (record_size != sizeof(trace::Record) || bytes.size() != HEADER_SIZE + count * record_size) {
+            return records;
+        }
+        records.resize(count);
+        if (count > 0) memcpy(records.data(), &bytes[HEADER_SIZE], count * record_size);
+        return records;
+    }
+
+    /**
+     * @brief Count events of a type in the ring buffer.
+     */
+    uint32_t count(trace::Event event) {
+        uint32_t n = 0;
+        for (const trace::Record& record : read()) {
+            n += record.event == (uint8_t)event;
+        }
+        return n;
+    }
+
+    static constexpr size_t HEADER_SIZE = 12;
+    std::vector<uint8_t> bytes;  ///< Output of the last dump
+};
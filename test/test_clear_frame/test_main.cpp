@@ -0,0 +1,39 @@
+// Clearing the display refreshes once and fills both memory areas of the controller.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <spi_monitor.h>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr uint32_t FRAME_BYTES = 200 * 200 / 8;
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_single_refresh() {
+    SpiMonitor monitor(CS, DC);
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    for (EinkColor color : {EinkColor::WHITE, EinkColor::BLACK}) {
+        monitor.reset();
+        display.clear_frame(color);
+        TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+        TEST_ASSERT_EQUAL_UINT32(2, monitor.commands[0x24]);
+        TEST_ASSERT_EQUAL_UINT32(2 * FRAME_BYTES, monitor.ram_bytes);
+        for (uint8_t byte : monitor.ram) {
+            TEST_ASSERT_EQUAL_HEX8(color == EinkColor::WHITE ? 0xFF : 0x00, byte);
+        }
+    }
+    TEST_ASSERT_EQUAL(2, display.get_profiler().samples(EinkDriver::Waveform::FULL, 7));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_refresh);
+    return UNITY_END();
+}
@@ -0,0 +1,206 @@
+// UTF-8 decoding stops at the end of text which is not terminated, sequences cut by it
+// become U+FFFD, and compressed glyphs decode to the pixels tools/compact_font_convert.py encodes.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+const char* const TOOL_DIR = "lib/lib_eink_waveshare/tools";
+
+// 'A' 3x4, 'é' 3x5 by literals only, U+FFFD 4x4 box by runs of both colors
+const uint8_t TEST_BITMAP[] = {
+    0xAB, 0xF4,
+    0x95, 0xF1, 0xC0,
+    0x44, 0x01, 0x41, 0x01, 0x44};
+const EinkDisplay::CompactGlyph TEST_GLYPHS[] = {
+    {0, 3, 4, 4, 0, -4},  // U+0041
+    {2, 3, 5, 4, 0, -5},  // U+00E9
+    {5, 4, 4, 5, 0, -4}}; // U+FFFD
+const EinkDisplay::CompactRange TEST_RANGES[] = {{0x41, 1, 0}, {0xE9, 1, 1}, {0xFFFD, 1, 2}};
+const EinkDisplay::CompactFont TEST_FONT = {TEST_BITMAP, TEST_GLYPHS, TEST_RANGES, 3, 8};
+
+/// Decode all characters between text and end, the text is copied so reads past it are caught
+std::vector<uint32_t> decode(const std::string& bytes) {
+    std::vector<char> copy(bytes.begin(), bytes.end());
+    std::vector<uint32_t> codepoints;
+    const char* text = copy.data();
+    const char* end = text + copy.size();
+    while (text < end) {
+        codepoints.push_back(EinkDisplay::utf8_next(text, end));
+    }
+    TEST_ASSERT_TRUE(text == end);
+    return codepoints;
+}
+
+void assert_decoded(const std::vector<uint32_t>& expected, const std::string& bytes) {
+    const std::vector<uint32_t> codepoints = decode(bytes);
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), codepoints.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL_HEX32(expected[i], codepoints[i]);
+    }
+}
+
+/// Pixels of a glyph as rows of '#' and '.', runs are checked to stay inside of their row
+std::string render(const EinkDisplay::CompactFont& font, const EinkDisplay::CompactGlyph& glyph) {
+    std::string pixels(glyph.width * glyph.height, '.');
+    EinkDisplay::for_each_run(font, glyph, [&](uint8_t row, uint8_t column, uint8_t length) {
+        TEST_ASSERT_TRUE(length > 0);
+        TEST_ASSERT_TRUE(row < glyph.height);
+        TEST_ASSERT_TRUE(column + length <= glyph.width);
+        for (uint8_t i = 0; i < length; i++) {
+            char& pixel = pixels[row * glyph.width + column + i];
+            TEST_ASSERT_EQUAL_INT('.', pixel);
+            pixel = '#';
+        }
+    });
+    return pixels;
+}
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_utf8_sequences() {
+    assert_decoded({'a', 0xE9, 0x20AC, 0x1F600}, "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+    // Stray continuation, invalid lead, overlong and out of range sequences skip a single byte
+    assert_decoded({0xFFFD, 'b'}, "\x80" "b");
+    assert_decoded({0xFFFD, 'c'}, "\xFF" "c");
+    assert_decoded({0xFFFD, 0xFFFD}, "\xC0\xAF");
+    assert_decoded({0xFFFD, 0xFFFD, 0xFFFD, 0xFFFD}, "\xF4\x90\x80\x80");
+    assert_decoded({0xFFFD, 'd'}, "\xE2" "d");
+}
+
+void test_utf8_cut_by_end() {
+    // Sequences missing their last bytes at the end of the text
+    assert_decoded({'a', 0xFFFD}, "a\xC3");
+    assert_decoded({0xFFFD, 0xFFFD}, "\xE2\x82");
+    assert_decoded({0xFFFD, 0xFFFD, 0xFFFD}, "\xF0\x9F\x98");
+
+    // Bytes after the end complete the sequence, yet they are not read
+    const char text[] = "a\xC3\xA9";
+    const char* next = text;
+    TEST_ASSERT_EQUAL_HEX32('a', EinkDisplay::utf8_next(next, text + 2));
+    TEST_ASSERT_EQUAL_HEX32(0xFFFD, EinkDisplay::utf8_next(next, text + 2));
+    TEST_ASSERT_TRUE(next == text + 2);
+
+    // Terminated text stops at the zero
+    next = "\xE2\x82";
+    TEST_ASSERT_EQUAL_HEX32(0xFFFD, EinkDisplay::utf8_next(next));
+    TEST_ASSERT_EQUAL_HEX32(0xFFFD, EinkDisplay::utf8_next(next));
+    TEST_ASSERT_EQUAL_HEX32(0, EinkDisplay::utf8_next(next));
+}
+
+void test_glyph_runs() {
+    TEST_ASSERT_EQUAL_STRING(".#."
+                             "#.#"
+                             "###"
+                             "#.#", render(TEST_FONT, TEST_GLYPHS[0]).c_str());
+    TEST_ASSERT_EQUAL_STRING("..#"
+                             ".#."
+                             "###"
+                             "#.."
+                             ".##", render(TEST_FONT, TEST_GLYPHS[1]).c_str());
+    TEST_ASSERT_EQUAL_STRING("####"
+                             "#..#"
+                             "#..#"
+                             "####", render(TEST_FONT, TEST_GLYPHS[2]).c_str());
+
+    // Run longer than the rest of the glyph is cut at its last pixel
+    const uint8_t bitmap[] = {0x01, 0x7F};
+    const EinkDisplay::CompactGlyph glyph = {0, 5, 3, 5, 0, -3};
+    const EinkDisplay::CompactFont font = {bitmap, &glyph, TEST_RANGES, 1, 4};
+    TEST_ASSERT_EQUAL_STRING("..###"
+                             "#####"
+                             "#####", render(font, glyph).c_str());
+
+    TEST_ASSERT_TRUE(EinkDisplay::find_glyph(TEST_FONT, 0xE9) == &TEST_GLYPHS[1]);
+    TEST_ASSERT_TRUE(EinkDisplay::find_glyph(TEST_FONT, 0x42) == nullptr);
+    TEST_ASSERT_TRUE(EinkDisplay::find_glyph(TEST_FONT, 0x10FFFF) == nullptr);
+}
+
+void test_converter_encoding_decodes() {
+    if (system("python3 --version >/dev/null 2>&1") != 0) {
+        TEST_IGNORE_MESSAGE("python3 is required");
+    }
+    // Patterns of the converter: long runs, runs at the end, short runs between literals
+    const std::vector<std::string> patterns = {
+        std::string(150, '#'),
+        std::string(10, '.') + "#.##.#" + std::string(70, '#') + "..",
+        "#.#.#.#.#.#.#.#.#.#.#.#.#.#.",
+        "......##",
+        "#",
+        std::string(64, '.') + std::string(65, '#') + ".#"};
+    std::string command = std::string("python3 -c \"import sys; sys.path.insert(0, '") + TOOL_DIR +
+        "'); import compact_font_convert as c\n"
+        "for p in sys.argv[1:]: print(c.encode([x == '#' for x in p]).hex())\"";
+    for (const std::string& pattern : patterns) {
+        command += " '" + pattern + "'";
+    }
+    FILE* pipe = popen(command.c_str(), "r");
+    std::vector<std::string> lines;
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        lines.emplace_back(buffer, strcspn(buffer, "\n"));
+    }
+    TEST_ASSERT_EQUAL_INT(0, pclose(pipe));
+    TEST_ASSERT_EQUAL_UINT32(patterns.size(), lines.size());
+
+    for (size_t i = 0; i < patterns.size(); i++) {
+        std::vector<uint8_t> bitmap;
+        for (size_t j = 0; j + 1 < lines[i].size(); j += 2) {
+            bitmap.push_back(strtoul(lines[i].substr(j, 2).c_str(), nullptr, 16));
+        }
+        // Pattern as a single row, and wrapped into rows of 7 pixels if it fits
+        const EinkDisplay::CompactGlyph row = {0, (uint8_t)patterns[i].size(), 1, 0, 0, 0};
+        const EinkDisplay::CompactFont font = {bitmap.data(), &row, TEST_RANGES, 1, 1};
+        TEST_ASSERT_EQUAL_STRING(patterns[i].c_str(), render(font, row).c_str());
+        if (patterns[i].size() % 7 == 0) {
+            const EinkDisplay::CompactGlyph rows = {0, 7, (uint8_t)(patterns[i].size() / 7), 0, 0, 0};
+            TEST_ASSERT_EQUAL_STRING(patterns[i].c_str(), render(font, rows).c_str());
+        }
+    }
+}
+
+void test_cut_text_drawn_as_replacement() {
+    // Queued text is cut inside of the last sequence, it ends with the replacement glyph
+    std::string text(EinkDisplay::DrawCommand::M_TEXT_SIZE - 1, 'A');
+    EinkDisplay::DrawQueue queue(4);
+    TEST_ASSERT_TRUE(queue.push_text(2, 20, EinkColor::BLACK, (text + "\xC3\xA9").c_str()));
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.set_font(TEST_FONT);
+    TEST_ASSERT_EQUAL_UINT16(1, display.drain(queue));
+
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> expected(CS, DC, RST, BUSY);
+    expected.set_font(TEST_FONT);
+    expected.print(2, 20, EinkColor::BLACK, (text + "\xEF\xBF\xBD").c_str());
+    TEST_ASSERT_EQUAL_UINT16(text.size() * 4 + 5, expected.get_text_width((text + "\xEF\xBF\xBD").c_str()));
+
+    EinkCanvas::SurfaceArena arena(2 * 200 * 200 / 8);
+    EinkCanvas::Surface frame = arena.allocate(200, 200);
+    EinkCanvas::Surface reference = arena.allocate(200, 200);
+    display.capture(frame, 0, 0);
+    expected.capture(reference, 0, 0);
+    TEST_ASSERT_EQUAL_MEMORY(reference.bits, frame.bits, 200 * 200 / 8);
+    // Glyph was drawn, the box is black at its top left corner
+    TEST_ASSERT_EQUAL(0, frame.bits[16 * 25 + (2 + text.size() * 4) / 8] & (0x80 >> ((2 + text.size() * 4) % 8)));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_utf8_sequences);
+    RUN_TEST(test_utf8_cut_by_end);
+    RUN_TEST(test_glyph_runs);
+    RUN_TEST(test_converter_encoding_decodes);
+    RUN_TEST(test_cut_text_drawn_as_replacement);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// Update deadline follows the first pending change, later changes only move it earlier, and
+// flush_due() refreshes once the deadline passed, with millis() driven by delay() of the stub.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <spi_monitor.h>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+// Real time passing while the test runs, virtual delays are much longer
+constexpr uint32_t SLACK_MS = 200;
+
+void assert_remaining(uint32_t expected, uint32_t remaining) {
+    TEST_ASSERT_TRUE_MESSAGE(remaining <= expected && remaining + SLACK_MS >= expected, "Time to deadline");
+}
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_nothing_pending() {
+    SpiMonitor monitor(CS, DC);
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, display.get_time_to_deadline());
+    TEST_ASSERT_FALSE(display.flush_due());
+    TEST_ASSERT_EQUAL_UINT32(0, monitor.commands[0x20]);
+
+    // Without delay the change is due at once
+    display.fill_rect(0, 0, 10, 10, EinkColor::BLACK);
+    TEST_ASSERT_EQUAL_UINT32(0, display.get_time_to_deadline());
+    TEST_ASSERT_TRUE(display.flush_due());
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, display.get_time_to_deadline());
+    TEST_ASSERT_FALSE(display.flush_due());
+}
+
+void test_first_change_sets_deadline() {
+    SpiMonitor monitor(CS, DC);
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.set_update_delay(5000);
+    display.fill_rect(0, 0, 10, 10, EinkColor::BLACK);
+    assert_remaining(5000, display.get_time_to_deadline());
+
+    // Later changes with the same delay do not postpone the update
+    delay(2000);
+    display.fill_rect(20, 0, 10, 10, EinkColor::BLACK);
+    assert_remaining(3000, display.get_time_to_deadline());
+    delay(2000);
+    display.draw_line(0, 50, 100, 50, EinkColor::BLACK);
+    assert_remaining(1000, display.get_time_to_deadline());
+    TEST_ASSERT_FALSE(display.flush_due());
+    TEST_ASSERT_EQUAL_UINT32(0, monitor.commands[0x20]);
+
+    // All pending changes are shown by one refresh after the deadline
+    delay(1000);
+    TEST_ASSERT_EQUAL_UINT32(0, display.get_time_to_deadline());
+    TEST_ASSERT_TRUE(display.flush_due());
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, display.get_time_to_deadline());
+
+    // Next change starts a new deadline
+    delay(10000);
+    display.fill_rect(0, 100, 10, 10, EinkColor::BLACK);
+    assert_remaining(5000, display.get_time_to_deadline());
+}
+
+void test_urgent_change_moves_deadline_earlier() {
+    SpiMonitor monitor(CS, DC);
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.set_update_delay(60000);
+    display.fill_rect(0, 0, 10, 10, EinkColor::BLACK);
+    assert_remaining(60000, display.get_time_to_deadline());
+
+    display.set_update_delay(1000);
+    display.fill_rect(20, 0, 10, 10, EinkColor::BLACK);
+    assert_remaining(1000, display.get_time_to_deadline());
+
+    // Longer delay again does not postpone the urgent change
+    display.set_update_delay(60000);
+    display.fill_rect(40, 0, 10, 10, EinkColor::BLACK);
+    assert_remaining(1000, display.get_time_to_deadline());
+
+    delay(1000);
+    TEST_ASSERT_TRUE(display.flush_due());
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+}
+
+void test_refresh_clears_deadline() {
+    SpiMonitor monitor(CS, DC);
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.set_update_delay(5000);
+    display.fill_rect(0, 0, 10, 10, EinkColor::BLACK);
+
+    // Refresh before the deadline shows the change, nothing is left pending
+    display.display_frame();
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, display.get_time_to_deadline());
+    delay(5000);
+    TEST_ASSERT_FALSE(display.flush_due());
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+
+    // Change drawn back is found unchanged, the bounding box and the deadline are reset
+    display.fill_rect(50, 50, 10, 10, EinkColor::BLACK);
+    display.fill_rect(50, 50, 10, 10, EinkColor::WHITE);
+    assert_remaining(5000, display.get_time_to_deadline());
+    display.display_frame();
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, display.get_time_to_deadline());
+
+    // Clearing refreshes the whole display by itself
+    display.fill_rect(0, 0, 10, 10, EinkColor::WHITE);
+    display.clear_frame();
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, display.get_time_to_deadline());
+    delay(5000);
+    TEST_ASSERT_FALSE(display.flush_due());
+}
+
+void test_deadline_across_millis_wraparound() {
+    SpiMonitor monitor(CS, DC);
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    // 32-bit millisecond counter overflows 2 seconds from now
+    const uint32_t now = millis();
+    delay(UINT32_MAX - now - 2000);
+    display.set_update_delay(5000);
+    display.fill_rect(0, 0, 10, 10, EinkColor::BLACK);
+    assert_remaining(5000, display.get_time_to_deadline());
+
+    delay(4000);
+    assert_remaining(1000, display.get_time_to_deadline());
+    TEST_ASSERT_FALSE(display.flush_due());
+    delay(1000);
+    TEST_ASSERT_TRUE(display.flush_due());
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_pending);
+    RUN_TEST(test_first_change_sets_deadline);
+    RUN_TEST(test_urgent_change_moves_deadline_earlier);
+    RUN_TEST(test_refresh_clears_deadline);
+    RUN_TEST(test_deadline_across_millis_wraparound);
+    return UNITY_END();
+}
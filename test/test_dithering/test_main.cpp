@@ -0,0 +1,128 @@
+// Throughput of the dithering kernels and tone preserved by them.
+
+#include <unity.h>
+
+#include <chrono>
+
+#include <eink_waveshare.h>
+
+using EinkCanvas::DitherMethod;
+using EinkCanvas::Ditherer;
+
+namespace {
+
+const DitherMethod METHODS[] = {DitherMethod::THRESHOLD, DitherMethod::ORDERED, DitherMethod::FLOYD_STEINBERG, DitherMethod::ATKINSON};
+const char* const NAMES[] = {"threshold", "ordered", "floyd-steinberg", "atkinson"};
+
+uint32_t white_pixels(const uint8_t* bits, uint16_t bytes) {
+    uint32_t count = 0;
+    for (uint16_t i = 0; i < bytes; i++) {
+        count += __builtin_popcount(bits[i]);
+    }
+    return count;
+}
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_flat_gray_keeps_tone() {
+    // Pixels of 200x200 image of one gray level, white ones are counted. Atkinson is left out,
+    // it drops a quarter of the error and flattens dark and light grays on purpose.
+    uint8_t bits[25];
+    for (uint8_t m = 1; m < 3; m++) {
+        for (uint16_t gray : {32, 64, 128, 192, 224}) {
+            Ditherer ditherer(METHODS[m], 200);
+            uint32_t white = 0;
+            for (uint16_t row = 0; row < 200; row++) {
+                memset(ditherer.row(), gray, 200);
+                ditherer.dither_row(bits);
+                white += white_pixels(bits, sizeof(bits));
+            }
+            const int32_t expected = 200 * 200 * gray / 255;
+            TEST_ASSERT_LESS_THAN(200 * 200 / 16, abs((int32_t)white - expected));
+        }
+    }
+}
+
+void test_restart_matches_new_ditherer() {
+    // Reused ditherer keeps no errors of the previous image, whatever its method and width was
+    Ditherer reused(200);
+    uint8_t bits[25], expected[25];
+    for (uint16_t width : {200, 37, 128, 1, 200}) {
+        for (uint8_t m = 0; m < 4; m++) {
+            Ditherer fresh(METHODS[m], width);
+            TEST_ASSERT_TRUE(reused.start(METHODS[m], width));
+            for (uint16_t row = 0; row < 20; row++) {
+                for (uint16_t x = 0; x < width; x++) {
+                    fresh.row()[x] = reused.row()[x] = x * 3 + row * 7;
+                }
+                fresh.dither_row(expected);
+                memcpy(bits, reused.dither_row(), (width + 7) / 8);
+                TEST_ASSERT_EQUAL_MEMORY(expected, bits, (width + 7) / 8);
+            }
+        }
+    }
+    TEST_ASSERT_FALSE(reused.start(DitherMethod::ATKINSON, 201));
+}
+
+void test_throughput() {
+    char message[120];
+    uint8_t bits[25];
+    for (uint8_t m = 0; m < 4; m++) {
+        Ditherer ditherer(METHODS[m], 200);
+        const uint32_t rows = 20000;
+        volatile uint8_t sink = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t row = 0; row < rows; row++) {
+            uint8_t* gray = ditherer.row();
+            for (uint16_t x = 0; x < 200; x++) {
+                gray[x] = x + row;
+            }
+            ditherer.dither_row(bits);
+            sink = sink + bits[row % sizeof(bits)];
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        snprintf(message, sizeof(message), "%-16s %7.1f Mpx/s, %6.1f us per 200x200 frame",
+                 NAMES[m], rows * 200 / seconds / 1e6, seconds / rows * 200 * 1e6);
+        TEST_MESSAGE(message);
+    }
+}
+
+void test_draw_grayscale() {
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(5, 17, 16, 4);
+    EinkCanvas::SurfaceArena arena(200 * 200 / 8);
+    EinkCanvas::Surface frame = arena.allocate(200, 200);
+    const uint8_t* buffer = frame.bits;
+    char message[120];
+    for (uint8_t m = 0; m < 4; m++) {
+        const uint32_t frames = 50;
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t f = 0; f < frames; f++) {
+            display.draw_grayscale(0, 0, 200, 200, METHODS[m], [](uint16_t row, uint8_t* gray) {
+                for (uint16_t x = 0; x < 200; x++) gray[x] = row < 100 ? 0 : 255;
+            });
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        display.capture(frame, 0, 0);
+        TEST_ASSERT_EQUAL_HEX8(0x00, buffer[0]);
+        TEST_ASSERT_EQUAL_HEX8(0xFF, buffer[200 * 200 / 8 - 1]);
+        snprintf(message, sizeof(message), "draw_grayscale %-16s %6.1f us per frame", NAMES[m], seconds / frames * 1e6);
+        TEST_MESSAGE(message);
+    }
+    // Rows wider than the display are refused, canvas is left unchanged
+    display.draw_grayscale(0, 0, 201, 1, DitherMethod::THRESHOLD, [](uint16_t, uint8_t* gray) { memset(gray, 255, 201); });
+    display.capture(frame, 0, 0);
+    TEST_ASSERT_EQUAL_HEX8(0x00, buffer[0]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_flat_gray_keeps_tone);
+    RUN_TEST(test_restart_matches_new_ditherer);
+    RUN_TEST(test_throughput);
+    RUN_TEST(test_draw_grayscale);
+    return UNITY_END();
+}
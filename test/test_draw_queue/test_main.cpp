@@ -0,0 +1,134 @@
+// Draw queue under real threads: many producers against one consumer lose, duplicate
+// or reorder no command, and a benchmark of pushes under contention.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Result {
+    uint32_t received = 0;
+    uint32_t errors = 0;          ///< Commands lost, out of order, repeated or damaged
+    uint32_t failed_pushes = 0;
+    double nanoseconds_per_command = 0;
+};
+
+/// Producer and its number of the command packed into arguments, the text repeats them
+EinkDisplay::DrawCommand make_command(uint8_t producer, uint32_t number) {
+    EinkDisplay::DrawCommand command = {};
+    command.call = EinkDisplay::DrawCall::TEXT;
+    command.args[0] = producer;
+    command.args[1] = (int16_t)(number >> 16);
+    command.args[2] = (int16_t)(number & 0xFFFF);
+    command.length = snprintf(command.text, sizeof(command.text), "%u:%lu", producer, (unsigned long)number);
+    return command;
+}
+
+/**
+ * @brief Run producers pushing until each of them queued all its commands, the calling
+ * thread pops them and checks that commands of every producer come in order, once.
+ */
+Result run(uint8_t producers, uint32_t commands, uint16_t capacity) {
+    EinkDisplay::DrawQueue queue(capacity);
+    std::atomic<bool> start{false}, stop{false};
+    std::atomic<uint8_t> finished{0};
+    std::vector<std::thread> threads;
+    for (uint8_t p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, &start, &stop, &finished, p, commands] {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (uint32_t i = 0; i < commands; i++) {
+                const EinkDisplay::DrawCommand command = make_command(p, i);
+                while (!queue.push(command)) {
+                    if (stop.load(std::memory_order_relaxed)) return;
+                    std::this_thread::sleep_for(std::chrono::microseconds(1));
+                }
+            }
+            finished.fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    Result result;
+    std::vector<uint32_t> expected(producers, 0);
+    EinkDisplay::DrawCommand command;
+    char text[EinkDisplay::DrawCommand::M_TEXT_SIZE];
+    const uint32_t total = (uint32_t)producers * commands;
+    const auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    while (result.received < total) {
+        if (!queue.pop(command)) {
+            // Everything pushed by finished producers is visible, the rest was lost
+            if (finished.load(std::memory_order_acquire) == producers && !queue.pop(command)) {
+                result.errors += total - result.received;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(1));
+            continue;
+        }
+        result.received++;
+        // Failed assertion would leave the producers running, errors are checked after join
+        const uint8_t p = command.args[0];
+        const uint32_t number = (uint32_t)(uint16_t)command.args[1] << 16 | (uint16_t)command.args[2];
+        if (p >= producers || number != expected[p]) {
+            result.errors++;
+            continue;
+        }
+        const uint8_t length = snprintf(text, sizeof(text), "%u:%lu", p, (unsigned long)number);
+        if (length != command.length || memcmp(text, command.text, length) != 0) {
+            result.errors++;
+        }
+        expected[p]++;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    // Nothing left over, so nothing was pushed twice
+    result.errors += queue.pop(command);
+    result.failed_pushes = queue.get_dropped();
+    result.nanoseconds_per_command = std::chrono::duration<double, std::nano>(end - begin).count() / total;
+    return result;
+}
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_no_loss_duplication_or_reordering() {
+    // Small queue keeps it full most of the time, so producers race for every slot
+    for (uint8_t producers : {1, 2, 4, 8}) {
+        const Result result = run(producers, 20000, 8);
+        TEST_ASSERT_EQUAL_UINT32(0, result.errors);
+    }
+}
+
+void test_contention_benchmark() {
+    char message[120];
+    for (uint16_t capacity : {16, 256}) {
+        for (uint8_t producers : {1, 2, 4, 8}) {
+            const uint32_t commands = 100000 / producers;
+            const Result result = run(producers, commands, capacity);
+            TEST_ASSERT_EQUAL_UINT32(0, result.errors);
+            snprintf(message, sizeof(message), "capacity %3u, %u producers: %6.1f ns per command, %5.1f %% pushes found the queue full",
+                     capacity, producers, result.nanoseconds_per_command,
+                     100.0 * result.failed_pushes / (result.failed_pushes + result.received));
+            TEST_MESSAGE(message);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_loss_duplication_or_reordering);
+    RUN_TEST(test_contention_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,146 @@
+// Displayed frame survives "deep sleep" in the stores, damaged frames are refused and
+// after restore only real differences are uploaded.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <spi_monitor.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr size_t FRAME_SIZE = 200 * 200 / 8;
+const char* const PATH = "/tmp/eink_frame_store.bin";
+
+std::vector<uint8_t> make_frame(uint8_t seed) {
+    std::vector<uint8_t> frame(FRAME_SIZE);
+    for (size_t i = 0; i < frame.size(); i++) {
+        frame[i] = (i * 31 + seed) ^ (i >> 5);
+    }
+    return frame;
+}
+
+void draw_screen(EinkDisplay::DisplayHandle<EinkDriver::Eink1in54>& display) {
+    display.clear_buffer();
+    display.fill_rect(10, 10, 80, 30, EinkColor::BLACK);
+    display.draw_circle(120, 120, 40, EinkColor::BLACK);
+    display.print(20, 60, EinkColor::BLACK, "12:34");
+}
+
+} // namespace
+
+void setUp() {
+    remove(PATH);
+}
+
+void tearDown() {
+    remove(PATH);
+}
+
+void test_rtc_store_round_trip() {
+    EinkDisplay::RtcFrameStore store;
+    const std::vector<uint8_t> frame = make_frame(1);
+    store.save(frame.data(), frame.size(), 7);
+
+    std::vector<uint8_t> loaded(FRAME_SIZE);
+    uint8_t refresh_number = 0;
+    TEST_ASSERT_TRUE(store.load(loaded.data(), loaded.size(), refresh_number));
+    TEST_ASSERT_EQUAL_MEMORY(frame.data(), loaded.data(), FRAME_SIZE);
+    TEST_ASSERT_EQUAL_UINT8(7, refresh_number);
+
+    // Frame of another size is not used
+    TEST_ASSERT_FALSE(store.load(loaded.data(), FRAME_SIZE / 2, refresh_number));
+}
+
+void test_file_store_round_trip() {
+    fs::FS fs;
+    EinkDisplay::FileFrameStore store(fs, PATH);
+    std::vector<uint8_t> loaded(FRAME_SIZE);
+    uint8_t refresh_number = 0;
+    TEST_ASSERT_FALSE(store.load(loaded.data(), loaded.size(), refresh_number));
+
+    const std::vector<uint8_t> frame = make_frame(2);
+    store.save(frame.data(), frame.size(), 3);
+    TEST_ASSERT_TRUE(store.load(loaded.data(), loaded.size(), refresh_number));
+    TEST_ASSERT_EQUAL_MEMORY(frame.data(), loaded.data(), FRAME_SIZE);
+    TEST_ASSERT_EQUAL_UINT8(3, refresh_number);
+}
+
+void test_damaged_file_is_refused() {
+    fs::FS fs;
+    EinkDisplay::FileFrameStore store(fs, PATH);
+    const std::vector<uint8_t> frame = make_frame(3);
+    store.save(frame.data(), frame.size(), 0);
+
+    // One bit of the frame flipped
+    FILE* file = fopen(PATH, "r+b");
+    fseek(file, -100, SEEK_END);
+    const int byte = fgetc(file);
+    fseek(file, -100, SEEK_END);
+    fputc(byte ^ 0x04, file);
+    fclose(file);
+
+    std::vector<uint8_t> loaded(FRAME_SIZE);
+    uint8_t refresh_number;
+    TEST_ASSERT_FALSE(store.load(loaded.data(), loaded.size(), refresh_number));
+
+    // Truncated file
+    store.save(frame.data(), frame.size(), 0);
+    truncate(PATH, 1000);
+    TEST_ASSERT_FALSE(store.load(loaded.data(), loaded.size(), refresh_number));
+}
+
+void test_wake_uploads_only_differences() {
+    SpiMonitor monitor(CS, DC);
+    fs::FS fs;
+    EinkDisplay::FileFrameStore store(fs, PATH);
+    {
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+        display.set_frame_store(&store);
+        display.clear_frame();
+        draw_screen(display);
+        display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    }
+
+    // Woken up, the same screen is drawn again from scratch
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.set_frame_store(&store);
+    TEST_ASSERT_TRUE(display.restore_frame());
+    draw_screen(display);
+    monitor.reset();
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    TEST_ASSERT_EQUAL_UINT32(0, monitor.ram_bytes);
+    TEST_ASSERT_EQUAL_UINT32(0, monitor.commands[0x20]);
+
+    // A small change is uploaded by itself
+    display.fill_rect(100, 180, 8, 8, EinkColor::BLACK);
+    monitor.reset();
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, monitor.ram_bytes);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(FRAME_SIZE / 10, monitor.ram_bytes);
+}
+
+void test_wake_without_frame() {
+    fs::FS fs;
+    EinkDisplay::FileFrameStore store(fs, PATH);
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    TEST_ASSERT_FALSE(display.restore_frame());
+    display.set_frame_store(&store);
+    TEST_ASSERT_FALSE(display.restore_frame());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rtc_store_round_trip);
+    RUN_TEST(test_file_store_round_trip);
+    RUN_TEST(test_damaged_file_is_refused);
+    RUN_TEST(test_wake_uploads_only_differences);
+    RUN_TEST(test_wake_without_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,240 @@
+// Frames sent by tools/frame_stream_send.py through a pseudo terminal end up in the frame
+// buffer exactly, a corrupted packet is answered by NAK and the host resynchronizes.
+//
+// The tool runs from the project directory and needs pyserial, the test is ignored without it.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr uint16_t SIZE = 200;
+constexpr uint16_t FRAME_SIZE = SIZE / 8 * SIZE;
+const char* const TOOL = "lib/lib_eink_waveshare/tools/frame_stream_send.py";
+
+/// Master side of the pseudo terminal, one byte can be damaged on its way to the receiver
+class PtyStream : public Stream {
+public:
+    explicit PtyStream(int fd) : m_fd(fd) {}
+
+    int available() override {
+        int count = 0;
+        return ioctl(m_fd, FIONREAD, &count) == 0 ? count : 0;
+    }
+
+    int read() override {
+        uint8_t byte;
+        if (::read(m_fd, &byte, 1) != 1) {
+            return -1;
+        }
+        if (position++ == corrupt_at) {
+            byte ^= 0x10;
+        }
+        return byte;
+    }
+
+    size_t write(uint8_t c) override {
+        return ::write(m_fd, &c, 1) == 1 ? 1 : 0;
+    }
+    using Print::write;
+
+    uint32_t position = 0;
+    uint32_t corrupt_at = UINT32_MAX;  ///< Index of the damaged byte in the stream
+
+private:
+    int m_fd;
+};
+
+struct FrameResult {
+    uint32_t bytes;       ///< Bytes received for the frame, including resent ones
+    uint32_t apply_time;  ///< Host time spent by receive_frames() for the frame, microseconds, delays of the driver excluded
+};
+
+/// Frame of the canvas, white is 1. Frames differ by a moving block over a common pattern.
+std::vector<uint8_t> make_frame(uint8_t index) {
+    std::vector<uint8_t> frame(FRAME_SIZE, 0xFF);
+    for (uint16_t y = 20; y < 60; y++) {
+        for (uint16_t x = 3; x < 22; x++) {
+            frame[y * SIZE / 8 + x] = (y / 4 + x) % 2 ? 0x0F : 0xF0;
+        }
+    }
+    for (uint16_t y = 100 + index * 20; y < 116 + index * 20; y++) {
+        for (uint16_t x = 5 + index * 4; x < 9 + index * 4; x++) {
+            frame[y * SIZE / 8 + x] = 0x00;
+        }
+    }
+    return frame;
+}
+
+/// Binary PBM read by the tool without Pillow, black is 1
+std::string write_pbm(const std::string& directory, uint8_t index, const std::vector<uint8_t>& frame) {
+    const std::string path = directory + "/frame" + std::to_string(index) + ".pbm";
+    FILE* file = fopen(path.c_str(), "wb");
+    TEST_ASSERT_TRUE_MESSAGE(file != nullptr, "Cannot write the frame");
+    fprintf(file, "P4\n%u %u\n", SIZE, SIZE);
+    for (uint8_t byte : frame) {
+        fputc(byte ^ 0xFF, file);
+    }
+    fclose(file);
+    return path;
+}
+
+bool tool_available() {
+    return access(TOOL, R_OK) == 0 && system("python3 -c 'import serial' 2>/dev/null") == 0;
+}
+
+/**
+ * @brief Stream the frames by the tool and check the buffer after every refresh.
+ * @return Figures of every shown frame.
+ */
+std::vector<FrameResult> stream_frames(const std::vector<std::vector<uint8_t>>& frames, uint32_t corrupt_at,
+                                       uint32_t& errors) {
+    char directory[] = "/tmp/frame_stream_XXXXXX";
+    TEST_ASSERT_TRUE(mkdtemp(directory) != nullptr);
+    std::vector<std::string> paths;
+    for (uint8_t i = 0; i < frames.size(); i++) {
+        paths.push_back(write_pbm(directory, i, frames[i]));
+    }
+
+    int master, slave;
+    char name[64];
+    TEST_ASSERT_EQUAL(0, openpty(&master, &slave, name, nullptr, nullptr));
+    termios mode;
+    tcgetattr(slave, &mode);
+    cfmakeraw(&mode);
+    tcsetattr(slave, TCSANOW, &mode);
+
+    const pid_t child = fork();
+    if (child == 0) {
+        close(master);
+        // Figures are reported by the test
+        const int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        std::vector<const char*> args = {"python3", TOOL, "--mode", "full", name};
+        for (const std::string& path : paths) {
+            args.push_back(path.c_str());
+        }
+        args.push_back(nullptr);
+        execvp("python3", (char* const*)args.data());
+        _exit(127);
+    }
+
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    EinkCanvas::SurfaceArena arena(FRAME_SIZE);
+    EinkCanvas::Surface shown = arena.allocate(SIZE, SIZE);
+    PtyStream stream(master);
+    stream.corrupt_at = corrupt_at;
+    EinkDisplay::FrameReceiver receiver(stream);
+
+    std::vector<FrameResult> results;
+    FrameResult current = {};
+    uint32_t bytes = 0;
+    int status = -1;
+    bool mismatch = false;
+    // Stub delay() only moves micros(), host time is measured
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    for (;;) {
+        const bool exited = waitpid(child, &status, WNOHANG) == child;
+        // Bytes written before the tool exited are still read
+        const auto start = std::chrono::steady_clock::now();
+        const bool updated = display.receive_frames(receiver);
+        current.apply_time += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        if (updated) {
+            display.capture(shown, 0, 0);
+            mismatch |= results.size() >= frames.size() ||
+                        memcmp(shown.bits, frames[results.size()].data(), FRAME_SIZE) != 0;
+            current.bytes = receiver.get_bytes_received() - bytes;
+            bytes = receiver.get_bytes_received();
+            results.push_back(current);
+            current = {};
+        }
+        if (exited && stream.available() == 0) {
+            break;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            kill(child, SIGKILL);
+            waitpid(child, &status, 0);
+            break;
+        }
+        usleep(100);
+    }
+    close(slave);
+    close(master);
+    for (const std::string& path : paths) {
+        remove(path.c_str());
+    }
+    rmdir(directory);
+
+    TEST_ASSERT_TRUE_MESSAGE(WIFEXITED(status) && WEXITSTATUS(status) == 0, "The tool failed");
+    TEST_ASSERT_FALSE_MESSAGE(mismatch, "Shown frame differs from the sent one");
+    TEST_ASSERT_EQUAL(frames.size(), results.size());
+    errors = receiver.get_errors();
+    return results;
+}
+
+} // namespace
+
+void setUp() {
+    if (!tool_available()) {
+        TEST_IGNORE_MESSAGE("python3 with pyserial is required");
+    }
+}
+
+void tearDown() {}
+
+void test_frames_arrive_exactly() {
+    const std::vector<std::vector<uint8_t>> frames = {make_frame(0), make_frame(1), make_frame(2), make_frame(2)};
+    uint32_t errors;
+    const std::vector<FrameResult> results = stream_frames(frames, UINT32_MAX, errors);
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+
+    // Unchanged frame is only its end
+    TEST_ASSERT_EQUAL_UINT32(8, results[3].bytes);
+
+    char message[120];
+    for (uint8_t i = 0; i < results.size(); i++) {
+        snprintf(message, sizeof(message), "frame %u: %5lu bytes, applied in %lu us", i,
+                 (unsigned long)results[i].bytes, (unsigned long)results[i].apply_time);
+        TEST_MESSAGE(message);
+    }
+}
+
+void test_corrupted_packet_is_sent_again() {
+    const std::vector<std::vector<uint8_t>> frames = {make_frame(0), make_frame(1)};
+    uint32_t errors;
+    // Reset packet is 8 bytes, the damaged byte is in payload of the first tile
+    const std::vector<FrameResult> results = stream_frames(frames, 20, errors);
+    TEST_ASSERT_EQUAL_UINT32(1, errors);
+
+    // Rejected frame is not shown, the whole frame is sent again after reset
+    const uint32_t whole = stream_frames({frames[0]}, UINT32_MAX, errors)[0].bytes;
+    TEST_ASSERT_EQUAL_UINT32(2 * whole, results[0].bytes);
+
+    char message[120];
+    snprintf(message, sizeof(message), "corrupted frame: %lu bytes with resync, %lu bytes without",
+             (unsigned long)results[0].bytes, (unsigned long)whole);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frames_arrive_exactly);
+    RUN_TEST(test_corrupted_packet_is_sent_again);
+    return UNITY_END();
+}
@@ -0,0 +1,292 @@
+// Images encoded by the test decode back to the same pixels, in PBM and in both row orders
+// and palettes of BMP, and damaged files are refused or stop without reading past their end.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+const char* const PATH = "/tmp/eink_image.bin";
+
+/// Image as white flags, row by row
+struct Image {
+    uint16_t width;
+    uint16_t height;
+    std::vector<bool> white;
+
+    bool pixel(uint16_t x, uint16_t y) const {
+        return white[y * width + x];
+    }
+};
+
+Image make_image(uint16_t width, uint16_t height) {
+    Image image = {width, height, std::vector<bool>(width * height)};
+    for (uint16_t y = 0; y < height; y++) {
+        for (uint16_t x = 0; x < width; x++) {
+            // Asymmetric, mirrored or shifted rows show
+            image.white[y * width + x] = (x * 5 + y * 3 + x * y / 7) % 7 < 3;
+        }
+    }
+    return image;
+}
+
+void put_le16(std::string& data, uint16_t value) {
+    data += (char)(value & 0xFF);
+    data += (char)(value >> 8);
+}
+
+void put_le32(std::string& data, uint32_t value) {
+    put_le16(data, value & 0xFFFF);
+    put_le16(data, value >> 16);
+}
+
+/// Packed row, bit set where black is true
+std::string pack_row(const Image& image, uint16_t y, bool set_black) {
+    std::string row((image.width + 7) / 8, '\0');
+    for (uint16_t x = 0; x < image.width; x++) {
+        if (image.pixel(x, y) != set_black) {
+            row[x / 8] |= 0x80 >> (x % 8);
+        }
+    }
+    return row;
+}
+
+std::string encode_pbm(const Image& image) {
+    std::string data = "P4\n# test image\n" + std::to_string(image.width) + " " + std::to_string(image.height) + "\n";
+    for (uint16_t y = 0; y < image.height; y++) {
+        data += pack_row(image, y, true);
+    }
+    return data;
+}
+
+/**
+ * @brief Encode 1-bit BMP.
+ * @param black_first Palette entry 0 is black, otherwise white.
+ */
+std::string encode_bmp(const Image& image, bool top_down, bool black_first) {
+    const uint32_t row_size = ((image.width + 7) / 8 + 3) & ~3u;
+    const uint32_t data_offset = 14 + 40 + 8;
+    std::string data = "BM";
+    put_le32(data, data_offset + row_size * image.height);
+    put_le32(data, 0);
+    put_le32(data, data_offset);
+    put_le32(data, 40);
+    put_le32(data, image.width);
+    put_le32(data, top_down ? -(int32_t)image.height : image.height);
+    put_le16(data, 1);
+    put_le16(data, 1);
+    put_le32(data, 0);
+    put_le32(data, row_size * image.height);
+    put_le32(data, 2835);
+    put_le32(data, 2835);
+    put_le32(data, 2);
+    put_le32(data, 0);
+    const std::string black("\x00\x00\x00\x00", 4), white("\xFF\xFF\xFF\x00", 4);
+    data += black_first ? black + white : white + black;
+    for (uint16_t i = 0; i < image.height; i++) {
+        const uint16_t y = top_down ? i : image.height - 1 - i;
+        std::string row = pack_row(image, y, !black_first);
+        row.resize(row_size, '\0');
+        data += row;
+    }
+    return data;
+}
+
+void write_file(const std::string& data) {
+    FILE* file = fopen(PATH, "wb");
+    fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+}
+
+/**
+ * @brief Decode the file by ImageDecoder into an image, chunks are checked on the way.
+ * @return true if the header was read and the whole image decoded.
+ */
+bool decode(Image& image) {
+    fs::FS fs;
+    fs::File file = fs.open(PATH, "r");
+    EinkDisplay::ImageDecoder decoder(file);
+    if (!decoder.read_header()) {
+        file.close();
+        return false;
+    }
+    image = {decoder.width(), decoder.height(), std::vector<bool>(decoder.width() * decoder.height(), true)};
+    EinkDisplay::ImageChunk chunk;
+    while (decoder.next_chunk(chunk)) {
+        TEST_ASSERT_EQUAL_UINT16(0, chunk.x % 8);
+        TEST_ASSERT_TRUE(chunk.row < image.height);
+        TEST_ASSERT_TRUE(chunk.width > 0 && chunk.x + chunk.width <= image.width);
+        TEST_ASSERT_TRUE(chunk.width <= EinkDisplay::ImageDecoder::M_CHUNK_SIZE * 8);
+        for (uint16_t i = 0; i < chunk.width; i++) {
+            image.white[chunk.row * image.width + chunk.x + i] = chunk.bits[i / 8] & (0x80 >> (i % 8));
+        }
+    }
+    file.close();
+    return decoder.is_complete();
+}
+
+void assert_same(const Image& expected, const Image& image) {
+    TEST_ASSERT_EQUAL_UINT16(expected.width, image.width);
+    TEST_ASSERT_EQUAL_UINT16(expected.height, image.height);
+    TEST_ASSERT_TRUE_MESSAGE(expected.white == image.white, "Decoded pixels differ");
+}
+
+/// Files which have to be refused by read_header()
+void assert_refused(const std::string& data, const char* message) {
+    write_file(data);
+    fs::FS fs;
+    fs::File file = fs.open(PATH, "r");
+    EinkDisplay::ImageDecoder decoder(file);
+    TEST_ASSERT_FALSE_MESSAGE(decoder.read_header(), message);
+    file.close();
+}
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {
+    remove(PATH);
+}
+
+void test_pbm_round_trip() {
+    // Narrow, byte aligned and rows longer than one chunk
+    for (uint16_t width : {1, 13, 64, 600}) {
+        const Image expected = make_image(width, 9);
+        write_file(encode_pbm(expected));
+        Image image;
+        TEST_ASSERT_TRUE(decode(image));
+        assert_same(expected, image);
+    }
+}
+
+void test_bmp_round_trip() {
+    for (uint16_t width : {1, 13, 40, 600}) {
+        for (bool top_down : {false, true}) {
+            for (bool black_first : {false, true}) {
+                const Image expected = make_image(width, 7);
+                write_file(encode_bmp(expected, top_down, black_first));
+                Image image;
+                TEST_ASSERT_TRUE(decode(image));
+                assert_same(expected, image);
+            }
+        }
+    }
+}
+
+void test_bmp_single_color_palette() {
+    Image expected = make_image(20, 5);
+    std::string data = encode_bmp(expected, false, true);
+    // Both entries black
+    data.replace(14 + 40 + 4, 4, std::string("\x00\x00\x00\x00", 4));
+    write_file(data);
+    Image image;
+    TEST_ASSERT_TRUE(decode(image));
+    expected.white.assign(expected.white.size(), false);
+    assert_same(expected, image);
+}
+
+void test_draw_image_into_canvas() {
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    const Image expected = make_image(37, 11);
+    write_file(encode_pbm(expected));
+    fs::FS fs;
+    TEST_ASSERT_TRUE(display.draw_image(fs, PATH, 5, 3));
+    EinkCanvas::SurfaceArena arena(200 * 200 / 8);
+    EinkCanvas::Surface frame = arena.allocate(200, 200);
+    display.capture(frame, 0, 0);
+    for (uint16_t y = 0; y < 20; y++) {
+        for (uint16_t x = 0; x < 50; x++) {
+            const bool inside = x >= 5 && x < 5 + expected.width && y >= 3 && y < 3 + expected.height;
+            const bool white = frame.bits[y * 25 + x / 8] & (0x80 >> (x % 8));
+            TEST_ASSERT_EQUAL(inside ? expected.pixel(x - 5, y - 3) : true, white);
+        }
+    }
+    TEST_ASSERT_FALSE(display.draw_image(fs, "/tmp/eink_missing_image.pbm", 0, 0));
+}
+
+void test_truncated_data() {
+    // Rows before the end of the file are decoded, the rest is left
+    const Image expected = make_image(100, 10);
+    const std::string pbm = encode_pbm(expected);
+    const size_t header = pbm.size() - 13 * 10;
+    write_file(pbm.substr(0, header + 13 * 4 + 5));
+    Image image;
+    TEST_ASSERT_FALSE(decode(image));
+    TEST_ASSERT_EQUAL_UINT16(10, image.height);
+    for (uint16_t y = 0; y < 4; y++) {
+        for (uint16_t x = 0; x < expected.width; x++) {
+            TEST_ASSERT_EQUAL(expected.pixel(x, y), image.pixel(x, y));
+        }
+    }
+
+    // Last pixels of the BMP are missing, not only padding of the row
+    const std::string bmp = encode_bmp(expected, true, true);
+    write_file(bmp.substr(0, bmp.size() - 5));
+    TEST_ASSERT_FALSE(decode(image));
+
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    fs::FS fs;
+    write_file(pbm.substr(0, header + 13 * 4));
+    TEST_ASSERT_FALSE(display.draw_image(fs, PATH, 0, 0));
+}
+
+void test_corrupt_headers() {
+    const Image image = make_image(20, 4);
+    const std::string bmp = encode_bmp(image, false, true);
+    assert_refused("", "empty file");
+    assert_refused("P", "magic only partly");
+    assert_refused("P1\n20 4\n", "ASCII PBM");
+    assert_refused("GIF89a", "other format");
+    assert_refused("P4\n20\n", "height missing");
+    assert_refused("P4\n20 x\n", "height not a number");
+    assert_refused("P4\n0 4\n", "zero width");
+    assert_refused("P4\n70000 4\n", "width over 16 bits");
+    assert_refused("P4\n20 4", "no whitespace before pixels");
+    assert_refused(bmp.substr(0, 30), "BMP header truncated");
+    assert_refused(bmp.substr(0, 14 + 40 + 4), "BMP palette truncated");
+
+    auto patched = [&](size_t offset, uint32_t value, uint8_t size) {
+        std::string data = bmp;
+        for (uint8_t i = 0; i < size; i++) {
+            data[offset + i] = (char)(value >> (8 * i));
+        }
+        return data;
+    };
+    assert_refused(patched(14 + 14, 24, 2), "24 bits per pixel");
+    assert_refused(patched(14 + 16, 1, 4), "RLE compression");
+    assert_refused(patched(14, 12, 4), "old info header");
+    assert_refused(patched(14 + 4, 0, 4), "zero width");
+    assert_refused(patched(14 + 4, (uint32_t)-20, 4), "negative width");
+    assert_refused(patched(14 + 8, 0, 4), "zero height");
+    assert_refused(patched(14 + 8, 0x80000000u, 4), "most negative height");
+    assert_refused(patched(14 + 4, 0x10000, 4), "width over 16 bits");
+}
+
+void test_pixel_data_offset_past_end() {
+    const Image expected = make_image(20, 4);
+    std::string bmp = encode_bmp(expected, false, true);
+    bmp[10] = (char)0xF0;
+    bmp[11] = (char)0xFF;
+    write_file(bmp);
+    Image image;
+    TEST_ASSERT_FALSE(decode(image));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pbm_round_trip);
+    RUN_TEST(test_bmp_round_trip);
+    RUN_TEST(test_bmp_single_color_palette);
+    RUN_TEST(test_draw_image_into_canvas);
+    RUN_TEST(test_truncated_data);
+    RUN_TEST(test_corrupt_headers);
+    RUN_TEST(test_pixel_data_offset_past_end);
+    return UNITY_END();
+}
@@ -0,0 +1,166 @@
+// Command scripts send exactly the commands, data, delays and transactions of the panel
+// initialization and refresh, and malformed scripts stop with chip select released.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <command_recorder.h>
+#include <init_script.h>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {
+    ArduinoStub::read_pin = nullptr;
+}
+
+void test_init_stream() {
+    CommandRecorder recorder(CS, DC);
+    EinkSPI::SPIController spi(CS, DC);
+    EinkDriver::Eink1in54 driver(RST, BUSY, spi);
+
+    // Reset pulse of 300 ms, then the whole script in one transaction
+    recorder.clear();
+    driver.init(EinkDriver::Waveform::FULL);
+    TEST_ASSERT_EQUAL_STRING(
+        "1 +300ms 01: C7 00 00\n"
+        "1 0C: D7 D6 9D\n"
+        "1 2C: A8\n"
+        "1 3A: 1A\n"
+        "1 3B: 08\n"
+        "1 11: 03\n"
+        "1 32: 30 bytes\n", recorder.format().c_str());
+    TEST_ASSERT_EQUAL_UINT32(4 + 4 + 2 + 2 + 2 + 2 + 31, spi.getBytesSent());
+
+    // Cold panel rotated by 180 degrees
+    recorder.clear();
+    driver.set_temperature(-10);
+    driver.set_rotation(2);
+    driver.init(EinkDriver::Waveform::PARTIAL);
+    TEST_ASSERT_EQUAL_STRING(
+        "1 +300ms 01: C7 00 00\n"
+        "1 0C: D7 D6 9D\n"
+        "1 2C: A8\n"
+        "1 3A: 30\n"
+        "1 3B: 08\n"
+        "1 11: 00\n"
+        "1 32: 30 bytes\n", recorder.format().c_str());
+    TEST_ASSERT_EQUAL(HIGH, ArduinoStub::pins[CS]);
+}
+
+void test_refresh_stream() {
+    CommandRecorder recorder(CS, DC);
+    EinkSPI::SPIController spi(CS, DC);
+    EinkDriver::Eink1in54 driver(RST, BUSY, spi);
+
+    // Chip select is released for the delay before the activation
+    recorder.clear();
+    driver.display_frame();
+    TEST_ASSERT_EQUAL_STRING(
+        "1 22: C4\n"
+        "2 +10ms 20:\n"
+        "2 FF:\n", recorder.format().c_str());
+    TEST_ASSERT_EQUAL(HIGH, ArduinoStub::pins[CS]);
+}
+
+void test_script_waits_for_busy() {
+    CommandRecorder recorder(CS, DC);
+    EinkSPI::SPIController spi(CS, DC);
+    uint32_t busy_reads = 5;
+    ArduinoStub::read_pin = [&](uint8_t pin) {
+        if (pin != BUSY) return (int)ArduinoStub::pins[pin];
+        return busy_reads > 0 && busy_reads-- > 0 ? HIGH : LOW;
+    };
+    const uint8_t script[] = {
+        0x12, 0 | EinkDriver::Script::WAIT,
+        0x01, 2, 0xAA, 0xBB,
+        0x03, 1 | EinkDriver::Script::DELAY | EinkDriver::Script::WAIT, 0x15, 7,
+        0x04, 0};
+    recorder.clear();
+    TEST_ASSERT_TRUE(EinkDriver::Script::run(spi, BUSY, script));
+    TEST_ASSERT_EQUAL_STRING(
+        "1 12:\n"
+        "2 +5ms 01: AA BB\n"
+        "2 03: 15\n"
+        "3 +7ms 04:\n", recorder.format().c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, busy_reads);
+
+    // Script ending with a delay does not start another transaction
+    const uint8_t last_delay[] = {0x05, 0 | EinkDriver::Script::DELAY, 3};
+    recorder.clear();
+    const uint64_t start_us = ArduinoStub::delayed_us;
+    TEST_ASSERT_TRUE(EinkDriver::Script::run(spi, BUSY, last_delay));
+    TEST_ASSERT_EQUAL_STRING("1 05:\n", recorder.format().c_str());
+    TEST_ASSERT_EQUAL(HIGH, ArduinoStub::pins[CS]);
+    TEST_ASSERT_TRUE(ArduinoStub::delayed_us - start_us == 3000);
+}
+
+void test_malformed_scripts() {
+    CommandRecorder recorder(CS, DC);
+    EinkSPI::SPIController spi(CS, DC);
+
+    // Entries before the malformed one are sent
+    const uint8_t no_length[] = {0x01, 1, 0xAA, 0x02};
+    recorder.clear();
+    TEST_ASSERT_FALSE(EinkDriver::Script::run(spi, BUSY, no_length));
+    TEST_ASSERT_EQUAL_STRING("1 01: AA\n", recorder.format().c_str());
+    TEST_ASSERT_EQUAL(HIGH, ArduinoStub::pins[CS]);
+
+    const uint8_t short_data[] = {0x01, 3, 0xAA, 0xBB};
+    recorder.clear();
+    TEST_ASSERT_FALSE(EinkDriver::Script::run(spi, BUSY, short_data));
+    TEST_ASSERT_TRUE(recorder.entries.empty());
+    TEST_ASSERT_EQUAL(HIGH, ArduinoStub::pins[CS]);
+
+    const uint8_t no_delay[] = {0x01, 1 | EinkDriver::Script::DELAY, 0xAA};
+    recorder.clear();
+    TEST_ASSERT_FALSE(EinkDriver::Script::run(spi, BUSY, no_delay));
+    TEST_ASSERT_TRUE(recorder.entries.empty());
+    TEST_ASSERT_EQUAL(HIGH, ArduinoStub::pins[CS]);
+
+    recorder.clear();
+    TEST_ASSERT_TRUE(EinkDriver::Script::run(spi, BUSY, no_length, 0));
+    TEST_ASSERT_TRUE(recorder.entries.empty());
+}
+
+void test_transfer_of_several_commands() {
+    CommandRecorder recorder(CS, DC);
+    EinkSPI::SPIController spi(CS, DC);
+    recorder.clear();
+    spi.resetBytesSent();
+
+    const uint8_t data[] = {0x01, 0x02, 0x03};
+    spi.beginTransfer();
+    spi.writeCommand(0x44);
+    spi.writeData(data, 2);
+    spi.writeData(data + 2, 1);
+    spi.writeCommand(0x45);
+    spi.writeData(data, 0);
+    spi.writeCommand(0x46);
+    spi.writeData(data, 3);
+    spi.endTransfer();
+    TEST_ASSERT_EQUAL(HIGH, ArduinoStub::pins[CS]);
+    spi.sendCommandWithData(0x4E, {0x07});
+
+    TEST_ASSERT_EQUAL_STRING(
+        "1 44: 01 02 03\n"
+        "1 45:\n"
+        "1 46: 01 02 03\n"
+        "2 4E: 07\n", recorder.format().c_str());
+    TEST_ASSERT_EQUAL_UINT32(4 + 1 + 4 + 2, spi.getBytesSent());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_stream);
+    RUN_TEST(test_refresh_stream);
+    RUN_TEST(test_script_waits_for_busy);
+    RUN_TEST(test_malformed_scripts);
+    RUN_TEST(test_transfer_of_several_commands);
+    return UNITY_END();
+}
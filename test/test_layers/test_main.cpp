@@ -0,0 +1,66 @@
+// Drawing into layers is not lost by their composition.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <spi_monitor.h>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+
+EinkDisplay::DisplayHandle<EinkDriver::Eink1in54>* display;
+SpiMonitor* monitor;
+
+/// Composed frame is uploaded whole by full refresh
+uint8_t shown_byte(int16_t x, int16_t y) {
+    monitor->reset();
+    display->display_frame(EinkDisplay::RefreshMode::FULL);
+    TEST_ASSERT_EQUAL_UINT32(200 * 200 / 8, monitor->ram.size());
+    return monitor->ram[y * 25 + x / 8];
+}
+
+} // namespace
+
+void setUp() {
+    monitor = new SpiMonitor(CS, DC);
+    display = new EinkDisplay::DisplayHandle<EinkDriver::Eink1in54>(CS, DC, RST, BUSY);
+    display->clear_frame();
+}
+
+void tearDown() {
+    delete display;
+    delete monitor;
+}
+
+void test_drawing_after_first_layer_goes_to_background() {
+    display->add_layer(EinkCanvas::BlendOp::AND);
+    display->fill_rect(16, 10, 16, 16, EinkColor::BLACK);
+    TEST_ASSERT_EQUAL_HEX8(0x00, shown_byte(16, 10));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, shown_byte(40, 10));
+}
+
+void test_layers_are_composed() {
+    display->fill_rect(0, 0, 8, 8, EinkColor::BLACK);
+    const uint8_t hands = display->add_layer(EinkCanvas::BlendOp::AND);
+    display->fill_rect(8, 0, 8, 8, EinkColor::BLACK);
+    display->select_layer(hands);
+    display->clear_buffer();
+    display->fill_rect(16, 0, 8, 8, EinkColor::BLACK);
+    TEST_ASSERT_EQUAL_HEX8(0x00, shown_byte(0, 0));
+    TEST_ASSERT_EQUAL_HEX8(0x00, shown_byte(8, 0));
+    TEST_ASSERT_EQUAL_HEX8(0x00, shown_byte(16, 0));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, shown_byte(24, 0));
+
+    // Hands move, background stays
+    display->clear_buffer();
+    TEST_ASSERT_EQUAL_HEX8(0x00, shown_byte(8, 0));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, shown_byte(16, 0));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_drawing_after_first_layer_goes_to_background);
+    RUN_TEST(test_layers_are_composed);
+    return UNITY_END();
+}
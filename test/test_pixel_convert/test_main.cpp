@@ -0,0 +1,158 @@
+// Gray and RGB565 pixels are packed by threshold with the documented luma weights, and
+// push_pixels() writes rows wider than its row buffer at the right place of the canvas.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+
+uint32_t seed = 1;
+
+uint8_t random_byte() {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+bool bit(const uint8_t* bits, uint16_t i) {
+    return bits[i / 8] & (0x80 >> (i % 8));
+}
+
+/// Luma of one RGB565 pixel found by packing it with every threshold
+uint16_t luma(uint16_t pixel, bool swapped) {
+    const uint8_t bytes[2] = {(uint8_t)(swapped ? pixel >> 8 : pixel), (uint8_t)(swapped ? pixel : pixel >> 8)};
+    uint16_t value = 0;
+    for (uint16_t threshold = 1; threshold < 256; threshold++) {
+        uint8_t bits = 0;
+        EinkCanvas::pack_rgb565(bytes, 1, threshold, swapped, &bits);
+        value += (bits & 0x80) != 0;
+    }
+    return value;
+}
+
+uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return (r << 11) | (g << 5) | b;
+}
+
+} // namespace
+
+void setUp() {
+    seed = 1;
+}
+
+void tearDown() {}
+
+void test_gray8_threshold() {
+    // Values equal to the threshold are white, below it black
+    const uint8_t gray[11] = {0, 127, 128, 129, 255, 128, 127, 0, 255, 128, 127};
+    uint8_t bits[3] = {0xAA, 0xAA, 0xAA};
+    EinkCanvas::pack_gray8(gray, 11, 128, bits);
+    TEST_ASSERT_EQUAL_HEX8(0x3C, bits[0]);
+    // Bits after the last pixel are black, next byte is not touched
+    TEST_ASSERT_EQUAL_HEX8(0xC0, bits[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xAA, bits[2]);
+
+    // Extreme thresholds: 0 makes everything white, 255 only white
+    EinkCanvas::pack_gray8(gray, 8, 0, bits);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, bits[0]);
+    EinkCanvas::pack_gray8(gray, 8, 255, bits);
+    TEST_ASSERT_EQUAL_HEX8(0x08, bits[0]);
+
+    for (uint16_t n = 0; n < 200; n++) {
+        uint8_t values[37];
+        for (uint8_t& value : values) {
+            value = random_byte();
+        }
+        const uint8_t threshold = random_byte();
+        uint8_t packed[5];
+        EinkCanvas::pack_gray8(values, sizeof(values), threshold, packed);
+        for (uint16_t i = 0; i < sizeof(values); i++) {
+            TEST_ASSERT_EQUAL(values[i] >= threshold, bit(packed, i));
+        }
+    }
+}
+
+void test_rgb565_luma() {
+    // White and black reach both ends of the range in both byte orders
+    for (bool swapped : {false, true}) {
+        TEST_ASSERT_EQUAL_UINT16(255, luma(0xFFFF, swapped));
+        TEST_ASSERT_EQUAL_UINT16(0, luma(0x0000, swapped));
+        // Weights 77, 150 and 29 of 256 are 0.299, 0.587 and 0.114 of the range
+        TEST_ASSERT_EQUAL_UINT16(76, luma(rgb565(31, 0, 0), swapped));
+        TEST_ASSERT_EQUAL_UINT16(149, luma(rgb565(0, 63, 0), swapped));
+        TEST_ASSERT_EQUAL_UINT16(29, luma(rgb565(0, 0, 31), swapped));
+    }
+
+    // Every pixel is within one level of exact luma of its channels scaled to 8 bits
+    for (uint32_t pixel = 0; pixel < 0x10000; pixel += 7) {
+        const double r = ((pixel >> 11) & 0x1F) * 255.0 / 31;
+        const double g = ((pixel >> 5) & 0x3F) * 255.0 / 63;
+        const double b = (pixel & 0x1F) * 255.0 / 31;
+        const double exact = 0.299 * r + 0.587 * g + 0.114 * b;
+        TEST_ASSERT_TRUE(std::fabs(luma(pixel, false) - exact) <= 1.0);
+    }
+}
+
+void test_rgb565_byte_order() {
+    std::vector<uint8_t> little, big;
+    for (uint16_t i = 0; i < 21; i++) {
+        const uint16_t pixel = random_byte() << 8 | random_byte();
+        little.push_back(pixel & 0xFF);
+        little.push_back(pixel >> 8);
+        big.push_back(pixel >> 8);
+        big.push_back(pixel & 0xFF);
+    }
+    // Pixels do not have to be aligned
+    little.insert(little.begin(), 0);
+    uint8_t a[3], b[3];
+    EinkCanvas::pack_rgb565(little.data() + 1, 21, 100, false, a);
+    EinkCanvas::pack_rgb565(big.data(), 21, 100, true, b);
+    TEST_ASSERT_EQUAL_MEMORY(a, b, sizeof(a));
+    TEST_ASSERT_EQUAL_HEX8(0, a[2] & 0x07);
+}
+
+void test_push_wide_rows() {
+    // Rows wider than the canvas reach past both edges, with padding between rows
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    const uint16_t w = 250, h = 6, stride = w * 2 + 6;
+    const int16_t x = -30, y = 97;
+    std::vector<uint8_t> gray(stride * h), rgb(stride * h);
+    for (uint16_t row = 0; row < h; row++) {
+        for (uint16_t i = 0; i < w; i++) {
+            const bool white = (i * 7 + row * 3) % 5 < 2;
+            gray[row * stride + i] = white ? 200 : 50;
+            const uint16_t pixel = white ? 0xFFFF : rgb565(10, 20, 10);
+            rgb[row * stride + i * 2] = pixel & 0xFF;
+            rgb[row * stride + i * 2 + 1] = pixel >> 8;
+        }
+    }
+
+    EinkCanvas::SurfaceArena arena(200 * 200 / 8);
+    EinkCanvas::Surface frame = arena.allocate(200, 200);
+    for (EinkCanvas::PixelFormat format : {EinkCanvas::PixelFormat::GRAY8, EinkCanvas::PixelFormat::RGB565}) {
+        display.clear_buffer(EinkColor::BLACK);
+        display.push_pixels(x, y, w, h, format, format == EinkCanvas::PixelFormat::GRAY8 ? gray.data() : rgb.data(), stride);
+        display.capture(frame, 0, 0);
+        for (int16_t cy = 0; cy < 200; cy++) {
+            for (int16_t cx = 0; cx < 200; cx++) {
+                const int16_t i = cx - x, row = cy - y;
+                const bool expected = row >= 0 && row < h && (i * 7 + row * 3) % 5 < 2;
+                TEST_ASSERT_EQUAL(expected, bit(frame.bits, cy * 200 + cx));
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gray8_threshold);
+    RUN_TEST(test_rgb565_luma);
+    RUN_TEST(test_rgb565_byte_order);
+    RUN_TEST(test_push_wide_rows);
+    return UNITY_END();
+}
@@ -0,0 +1,315 @@
+// Polygons fill the pixels whose centers have nonzero winding, for concave, self-intersecting
+// and clipped shapes, thick polylines cover their segments, and the refresh box is exact.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <trace_capture.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+
+// Concave arrow, pentagram wound twice in its center, and a bow tie crossing itself
+const EinkCanvas::Point ARROW[] = {{100, 20}, {130, 60}, {110, 60}, {110, 100}, {90, 100}, {90, 60}, {70, 60}};
+const EinkCanvas::Point STAR[] = {{60, 5}, {95, 110}, {5, 45}, {115, 45}, {25, 110}};
+const EinkCanvas::Point BOW_TIE[] = {{10, 10}, {70, 53}, {70, 10}, {10, 53}};
+
+uint32_t seed = 1;
+
+int16_t random_between(int16_t low, int16_t high) {
+    seed = seed * 1103515245 + 12345;
+    return low + (int16_t)((seed >> 16) % (high - low + 1));
+}
+
+bool pixel(const uint8_t* bits, uint16_t width, int16_t x, int16_t y) {
+    const uint32_t i = (uint32_t)y * width + x;
+    return bits[i / 8] & (0x80 >> (i % 8));
+}
+
+/**
+ * @brief Winding number of contours around the center of a pixel, brute force over all edges.
+ *
+ * Centers are at whole coordinates, edges include their top end and the pixels right of them.
+ */
+int16_t winding(const std::vector<std::vector<EinkCanvas::Point>>& contours, int16_t x, int16_t y) {
+    int16_t sum = 0;
+    for (const std::vector<EinkCanvas::Point>& contour : contours) {
+        for (size_t i = 0; i < contour.size(); i++) {
+            EinkCanvas::Point a = contour[i], b = contour[(i + 1) % contour.size()];
+            int16_t direction = 1;
+            if (a.y > b.y) {
+                std::swap(a, b);
+                direction = -1;
+            }
+            // Center is right of the edge when x >= a.x + (y - a.y) * dx / dy
+            if (y >= a.y && y < b.y &&
+                (int64_t)(x - a.x) * (b.y - a.y) >= (int64_t)(y - a.y) * (b.x - a.x)) {
+                sum += direction;
+            }
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Check spans of every row of the rasterizer against the winding of pixel centers.
+ */
+void assert_spans(const std::vector<std::vector<EinkCanvas::Point>>& contours, int16_t left, int16_t right) {
+    uint16_t edges = 0;
+    for (const std::vector<EinkCanvas::Point>& contour : contours) {
+        edges += contour.size();
+    }
+    EinkCanvas::ScanlineRasterizer rasterizer(edges);
+    for (const std::vector<EinkCanvas::Point>& contour : contours) {
+        TEST_ASSERT_TRUE(rasterizer.add_polygon(contour.data(), contour.size()));
+    }
+    int16_t top = INT16_MAX, bottom = INT16_MIN;
+    for (const std::vector<EinkCanvas::Point>& contour : contours) {
+        for (const EinkCanvas::Point& point : contour) {
+            top = std::min(top, point.y);
+            bottom = std::max(bottom, point.y);
+        }
+    }
+    rasterizer.start(top - 1);
+    for (int16_t y = top - 1; y <= bottom; y++) {
+        uint16_t count;
+        const EinkCanvas::Span* spans = rasterizer.next_row(count);
+        std::vector<bool> filled(right - left + 1, false);
+        for (uint16_t i = 0; i < count; i++) {
+            // Spans are sorted, separated and inside of the row
+            TEST_ASSERT_TRUE(spans[i].x0 <= spans[i].x1);
+            TEST_ASSERT_TRUE(i == 0 || spans[i - 1].x1 + 1 < spans[i].x0);
+            TEST_ASSERT_TRUE(spans[i].x0 >= left && spans[i].x1 <= right);
+            std::fill(filled.begin() + spans[i].x0 - left, filled.begin() + spans[i].x1 - left + 1, true);
+        }
+        for (int16_t x = left; x <= right; x++) {
+            if (filled[x - left] != (winding(contours, x, y) != 0)) {
+                char message[64];
+                snprintf(message, sizeof(message), "Pixel %d,%d", x, y);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+        TEST_ASSERT_TRUE(count == 0 || (y >= rasterizer.top() && y <= rasterizer.bottom()));
+    }
+}
+
+/**
+ * @brief Distance of a point from a segment.
+ */
+float segment_distance(float x, float y, EinkCanvas::Point a, EinkCanvas::Point b) {
+    const float dx = b.x - a.x, dy = b.y - a.y;
+    const float t = std::max(0.0f, std::min(1.0f, ((x - a.x) * dx + (y - a.y) * dy) / (dx * dx + dy * dy)));
+    return std::hypot(x - a.x - t * dx, y - a.y - t * dy);
+}
+
+/**
+ * @brief Distance of a point from the segment measured across it, infinite near and beyond its ends.
+ */
+float across_distance(float x, float y, EinkCanvas::Point a, EinkCanvas::Point b) {
+    const float dx = b.x - a.x, dy = b.y - a.y, length = std::hypot(dx, dy);
+    const float along = ((x - a.x) * dx + (y - a.y) * dy) / length;
+    if (along < 0.5f || along > length - 0.5f) return INFINITY;
+    return std::fabs((x - a.x) * dy - (y - a.y) * dx) / length;
+}
+
+} // namespace
+
+void setUp() {
+    seed = 1;
+    trace::clear();
+}
+
+void tearDown() {}
+
+void test_shapes_by_winding() {
+    assert_spans({{std::begin(ARROW), std::end(ARROW)}}, 60, 140);
+    assert_spans({{std::begin(STAR), std::end(STAR)}}, 0, 120);
+    assert_spans({{std::begin(BOW_TIE), std::end(BOW_TIE)}}, 0, 80);
+
+    // Center of the pentagram is wound twice, filled by nonzero unlike by even-odd
+    const std::vector<std::vector<EinkCanvas::Point>> star = {{std::begin(STAR), std::end(STAR)}};
+    TEST_ASSERT_EQUAL_INT16(2, std::abs(winding(star, 60, 60)));
+    EinkCanvas::GFXCanvasBW canvas(128, 128);
+    canvas.fillScreen(0);
+    EinkCanvas::ScanlineRasterizer rasterizer(5);
+    rasterizer.add_polygon(STAR, 5);
+    int16_t x0, y0, x1, y1;
+    TEST_ASSERT_TRUE(canvas.fillPolygon(rasterizer, 1, x0, y0, x1, y1));
+    TEST_ASSERT_TRUE(pixel(canvas.getBuffer(), 128, 60, 60));
+
+    // Contours wound the other way cut a hole, wound the same way they add up
+    const std::vector<EinkCanvas::Point> outer = {{0, 0}, {40, 0}, {40, 40}, {0, 40}};
+    const std::vector<EinkCanvas::Point> hole = {{10, 10}, {10, 30}, {30, 30}, {30, 10}};
+    const std::vector<EinkCanvas::Point> inner = {{10, 10}, {30, 10}, {30, 30}, {10, 30}};
+    assert_spans({outer, hole}, -5, 45);
+    assert_spans({outer, inner}, -5, 45);
+    TEST_ASSERT_EQUAL_INT16(0, winding({outer, hole}, 20, 20));
+
+    // Shared edge of neighbouring triangles belongs to one of them
+    const std::vector<EinkCanvas::Point> left = {{0, 0}, {17, 5}, {3, 29}};
+    const std::vector<EinkCanvas::Point> right = {{17, 5}, {30, 31}, {3, 29}};
+    for (int16_t y = -1; y < 33; y++) {
+        for (int16_t x = -1; x < 33; x++) {
+            TEST_ASSERT_TRUE(winding({left}, x, y) == 0 || winding({right}, x, y) == 0);
+        }
+    }
+    assert_spans({left, right}, -5, 35);
+}
+
+void test_random_polygons() {
+    for (uint16_t n = 0; n < 300; n++) {
+        // Random vertices make concave and self-intersecting polygons reaching out of the canvas
+        std::vector<EinkCanvas::Point> points(random_between(3, 12));
+        for (EinkCanvas::Point& point : points) {
+            point = {random_between(-20, 80), random_between(-20, 80)};
+        }
+        assert_spans({points}, -20, 80);
+    }
+}
+
+void test_canvas_fill_clipped() {
+    EinkCanvas::GFXCanvasBW canvas(61, 47);
+    for (uint16_t n = 0; n < 200; n++) {
+        std::vector<uint8_t> before(61 * 47 / 8 + 1);
+        for (uint8_t& byte : before) {
+            byte = random_between(0, 255);
+        }
+        std::copy(before.begin(), before.end(), canvas.getBuffer());
+        std::vector<EinkCanvas::Point> points(random_between(3, 9));
+        for (EinkCanvas::Point& point : points) {
+            point = {random_between(-30, 60), random_between(-30, 50)};
+        }
+        const int16_t vx = random_between(0, 30), vy = random_between(0, 20);
+        const int16_t vw = random_between(1, 40), vh = random_between(1, 40);
+        const uint16_t color = n % 2;
+        EinkCanvas::ScanlineRasterizer rasterizer(points.size());
+        rasterizer.add_polygon(points.data(), points.size());
+        canvas.pushViewport(vx, vy, vw, vh);
+        int16_t x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+        const bool filled = canvas.fillPolygon(rasterizer, color, x0, y0, x1, y1);
+        canvas.popViewport();
+
+        // Box of filled pixels, in canvas coordinates
+        int16_t box_x0 = INT16_MAX, box_y0 = INT16_MAX, box_x1 = INT16_MIN, box_y1 = INT16_MIN;
+        for (int16_t y = 0; y < 47; y++) {
+            for (int16_t x = 0; x < 61; x++) {
+                const bool inside = x >= vx && x < vx + vw && y >= vy && y < vy + vh &&
+                    winding({points}, x - vx, y - vy) != 0;
+                const bool expected = inside ? color != 0 : pixel(before.data(), 61, x, y);
+                TEST_ASSERT_EQUAL(expected, pixel(canvas.getBuffer(), 61, x, y));
+                if (inside) {
+                    box_x0 = std::min(box_x0, x), box_y0 = std::min(box_y0, y);
+                    box_x1 = std::max(box_x1, x), box_y1 = std::max(box_y1, y);
+                }
+            }
+        }
+        TEST_ASSERT_EQUAL(box_x0 <= box_x1, filled);
+        if (filled) {
+            TEST_ASSERT_EQUAL_INT16(box_x0, x0);
+            TEST_ASSERT_EQUAL_INT16(box_y0, y0);
+            TEST_ASSERT_EQUAL_INT16(box_x1, x1);
+            TEST_ASSERT_EQUAL_INT16(box_y1, y1);
+        }
+    }
+}
+
+void test_display_refresh_box() {
+    TraceCapture trace;
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.clear_frame();
+    display.display_frame(EinkDisplay::RefreshMode::FULL);
+    EinkCanvas::SurfaceArena arena(200 * 200 / 8);
+    EinkCanvas::Surface frame = arena.allocate(200, 200);
+
+    // Pentagram in a viewport, its right side is clipped
+    display.push_viewport(40, 30, 100, 150);
+    display.fill_polygon(STAR, 5, EinkColor::BLACK);
+    display.pop_viewport();
+    display.capture(frame, 0, 0);
+    const std::vector<std::vector<EinkCanvas::Point>> star = {{std::begin(STAR), std::end(STAR)}};
+    int16_t x0 = INT16_MAX, y0 = INT16_MAX, x1 = INT16_MIN, y1 = INT16_MIN;
+    for (int16_t y = 0; y < 200; y++) {
+        for (int16_t x = 0; x < 200; x++) {
+            const bool inside = x >= 40 && x < 140 && winding(star, x - 40, y - 30) != 0;
+            TEST_ASSERT_EQUAL(!inside, pixel(frame.bits, 200, x, y));
+            if (inside) {
+                x0 = std::min(x0, x), y0 = std::min(y0, y);
+                x1 = std::max(x1, x), y1 = std::max(y1, y);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_INT16(139, x1);
+
+    trace::clear();
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    std::vector<trace::Record> records = trace.read();
+    TEST_ASSERT_FALSE(records.empty());
+    TEST_ASSERT_EQUAL_UINT8(trace::Event::REFRESH, records[0].event);
+    const uint16_t box[] = {(uint16_t)x0, (uint16_t)y0, (uint16_t)x1, (uint16_t)y1};
+    TEST_ASSERT_EQUAL_MEMORY(box, records[0].data, sizeof(box));
+
+    // Polygon entirely out of the viewport changes nothing
+    const EinkCanvas::Point outside[] = {{-50, -50}, {-10, -40}, {-30, -5}};
+    trace::clear();
+    display.fill_polygon(outside, 3, EinkColor::WHITE);
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.count(trace::Event::REFRESH));
+}
+
+void test_polyline_covers_segments() {
+    // Sharp turns, a segment going back over the previous one, and a repeated point
+    const EinkCanvas::Point points[] = {{20, 30}, {170, 40}, {30, 90}, {160, 170}, {160, 170}, {60, 120}, {100, 190}};
+    for (uint16_t thickness : {1, 4, 9}) {
+        TraceCapture trace;
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+        display.clear_frame();
+        display.display_frame(EinkDisplay::RefreshMode::FULL);
+        display.draw_polyline(points, 7, thickness, EinkColor::BLACK);
+        EinkCanvas::SurfaceArena arena(200 * 200 / 8);
+        EinkCanvas::Surface frame = arena.allocate(200, 200);
+        display.capture(frame, 0, 0);
+
+        // Centers well inside of a segment are filled, centers away from all segments are not
+        const float half = thickness / 2.0f;
+        int16_t x0 = INT16_MAX, y0 = INT16_MAX, x1 = INT16_MIN, y1 = INT16_MIN;
+        for (int16_t y = 0; y < 200; y++) {
+            for (int16_t x = 0; x < 200; x++) {
+                float across = INFINITY, nearest = INFINITY;
+                for (uint8_t i = 0; i + 1 < 7; i++) {
+                    if (points[i].x == points[i + 1].x && points[i].y == points[i + 1].y) continue;
+                    across = std::min(across, across_distance(x, y, points[i], points[i + 1]));
+                    nearest = std::min(nearest, segment_distance(x, y, points[i], points[i + 1]));
+                }
+                const bool set = !pixel(frame.bits, 200, x, y);
+                if (across < half - 0.5f) TEST_ASSERT_TRUE(set);
+                if (nearest > half + 0.5f) TEST_ASSERT_FALSE(set);
+                if (set) {
+                    x0 = std::min(x0, x), y0 = std::min(y0, y);
+                    x1 = std::max(x1, x), y1 = std::max(y1, y);
+                }
+            }
+        }
+
+        trace::clear();
+        display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+        std::vector<trace::Record> records = trace.read();
+        TEST_ASSERT_FALSE(records.empty());
+        TEST_ASSERT_EQUAL_UINT8(trace::Event::REFRESH, records[0].event);
+        const uint16_t box[] = {(uint16_t)x0, (uint16_t)y0, (uint16_t)x1, (uint16_t)y1};
+        TEST_ASSERT_EQUAL_MEMORY(box, records[0].data, sizeof(box));
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_shapes_by_winding);
+    RUN_TEST(test_random_polygons);
+    RUN_TEST(test_canvas_fill_clipped);
+    RUN_TEST(test_display_refresh_box);
+    RUN_TEST(test_polyline_covers_segments);
+    return UNITY_END();
+}
@@ -0,0 +1,101 @@
+// Calibration of the full refresh threshold from measured refreshes.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <spi_monitor.h>
+
+using EinkDisplay::RefreshProfiler;
+using EinkDriver::Waveform;
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr uint32_t AREA = 200 * 200;
+
+void record(RefreshProfiler& profiler, Waveform waveform, uint8_t bucket, uint32_t busy_ms) {
+    const uint32_t area = waveform == Waveform::FULL ? AREA : AREA * (2 * bucket + 1) / 16;
+    for (uint8_t i = 0; i < RefreshProfiler::M_MIN_SAMPLES; i++) {
+        profiler.record(waveform, area, AREA, 0, busy_ms);
+    }
+}
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {
+    ArduinoStub::read_pin = nullptr;
+}
+
+void test_no_crossover_keeps_area() {
+    RefreshProfiler profiler;
+    record(profiler, Waveform::FULL, 7, 2000);
+    record(profiler, Waveform::PARTIAL, 0, 300);
+    record(profiler, Waveform::PARTIAL, 1, 350);
+    uint32_t area = 12345;
+    TEST_ASSERT_FALSE(profiler.crossover_area(AREA, 10, area));
+    TEST_ASSERT_EQUAL_UINT32(12345, area);
+}
+
+void test_measured_crossover() {
+    RefreshProfiler profiler;
+    record(profiler, Waveform::FULL, 7, 2000);
+    for (uint8_t bucket = 0; bucket < 8; bucket++) {
+        record(profiler, Waveform::PARTIAL, bucket, 300 + 260 * bucket);
+    }
+    // Bucket 6 costs 1860 ms plus ghosting of 13/16 of 200 ms
+    uint32_t area = 0;
+    TEST_ASSERT_TRUE(profiler.crossover_area(AREA, 10, area));
+    TEST_ASSERT_EQUAL_UINT32(AREA * 6 / 8, area);
+}
+
+void test_ghosting_grows_with_area() {
+    RefreshProfiler profiler;
+    record(profiler, Waveform::FULL, 7, 1000);
+    // Small refreshes leave little ghosting even with short period
+    record(profiler, Waveform::PARTIAL, 0, 600);
+    uint32_t area = 0;
+    TEST_ASSERT_FALSE(profiler.crossover_area(AREA, 2, area));
+    // Large ones are charged almost half of the full refresh
+    record(profiler, Waveform::PARTIAL, 7, 600);
+    TEST_ASSERT_TRUE(profiler.crossover_area(AREA, 2, area));
+    TEST_ASSERT_EQUAL_UINT32(AREA * 7 / 8, area);
+}
+
+void test_configured_threshold_is_kept() {
+    // Busy pin stays high for a while after every MASTER_ACTIVATION
+    uint32_t busy_ms = 0, busy_reads = 0;
+    SpiMonitor monitor(CS, DC);
+    ArduinoStub::read_pin = [&](uint8_t pin) {
+        if (pin != BUSY) return (int)ArduinoStub::pins[pin];
+        if (monitor.commands[0x20] > 0) {
+            monitor.commands[0x20] = 0;
+            busy_reads = busy_ms;
+        }
+        return busy_reads > 0 && busy_reads-- > 0 ? HIGH : LOW;
+    };
+
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY, 0.5);
+    const uint32_t configured = display.get_full_refresh_area();
+    for (uint8_t i = 0; i < 40; i++) {
+        if (i % 10 == 0) {
+            busy_ms = 2000;
+            display.clear_frame();
+        }
+        busy_ms = 300;
+        display.fill_rect(i * 4, 20, 8, 8, i & 1 ? EinkColor::WHITE : EinkColor::BLACK);
+        display.display_frame();
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(RefreshProfiler::M_MIN_SAMPLES, display.get_profiler().samples(Waveform::PARTIAL, 0));
+    TEST_ASSERT_EQUAL_UINT32(configured, display.get_full_refresh_area());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_crossover_keeps_area);
+    RUN_TEST(test_measured_crossover);
+    RUN_TEST(test_ghosting_grows_with_area);
+    RUN_TEST(test_configured_threshold_is_kept);
+    return UNITY_END();
+}
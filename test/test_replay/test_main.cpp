@@ -0,0 +1,209 @@
+// Replay of draw logs with the SPI stub in place of the display: recorded screens are
+// reproduced, corrupted logs are rejected.
+//
+// Any log captured on the device is replayed by
+// `EINK_DRAW_LOG=screen.log pio test -e native -f test_replay -v`, it reports every frame.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <spi_monitor.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+
+/// Log kept in memory, written by the recorder and read by the replay
+class MemoryLog : public Stream {
+public:
+    size_t write(uint8_t c) override {
+        bytes.push_back(c);
+        return 1;
+    }
+    using Print::write;
+
+    int available() override { return bytes.size() - position; }
+    int read() override { return position < bytes.size() ? bytes[position++] : -1; }
+
+    std::vector<uint8_t> bytes;
+    size_t position = 0;
+};
+
+/// Length of the log header, the first record follows it
+constexpr size_t HEADER = 6;
+
+SpiMonitor* monitor;
+
+/// Screen with every kind of data carrying call
+void draw_screen(EinkDisplay::DisplayHandle<EinkDriver::Eink1in54>& display) {
+    static const uint8_t arrow[] = {0x18, 0x3C, 0x7E, 0xFF, 0x18, 0x18, 0x18, 0x18};
+    display.clear_frame();
+    display.fill_rect(10, 10, 60, 20, EinkColor::BLACK);
+    display.draw_circle(100, 100, 30, EinkColor::BLACK);
+    display.print(20, 50, EinkColor::BLACK, "Replay");
+    display.print_fields(20, 70, EinkColor::BLACK, EinkFormat::Fixed<1>{125}, 'k', 'm');
+    display.draw_bitmap(150, 20, arrow, 8, 8, EinkColor::BLACK, EinkColor::WHITE);
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    display.scroll_region(0, 0, 200, 100, 0, -8, EinkColor::WHITE);
+    display.display_frame(EinkDisplay::RefreshMode::FULL);
+}
+
+std::vector<EinkDisplay::FrameReport> replay(MemoryLog& log, bool& success) {
+    std::vector<EinkDisplay::FrameReport> reports;
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    log.position = 0;
+    success = display.replay(log, nullptr, 0, [&](const EinkDisplay::FrameReport& report) {
+        reports.push_back(report);
+    });
+    return reports;
+}
+
+} // namespace
+
+void setUp() {
+    monitor = new SpiMonitor(CS, DC);
+}
+
+void tearDown() {
+    delete monitor;
+}
+
+void test_replay_reproduces_screen() {
+    MemoryLog log;
+    std::vector<uint8_t> recorded;
+    {
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+        EinkDisplay::DrawRecorder recorder(log);
+        display.set_recorder(&recorder);
+        draw_screen(display);
+        recorded = monitor->ram;
+    }
+    monitor->reset();
+    bool success;
+    const std::vector<EinkDisplay::FrameReport> reports = replay(log, success);
+    TEST_ASSERT_TRUE(success);
+    TEST_ASSERT_EQUAL(2, reports.size());
+    TEST_ASSERT_EQUAL(recorded.size(), monitor->ram.size());
+    TEST_ASSERT_EQUAL_MEMORY(recorded.data(), monitor->ram.data(), recorded.size());
+
+    // The same log gives the same figures every time
+    const std::vector<EinkDisplay::FrameReport> again = replay(log, success);
+    TEST_ASSERT_EQUAL(reports.size(), again.size());
+    for (size_t i = 0; i < reports.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(reports[i].dirty_area, again[i].dirty_area);
+        TEST_ASSERT_EQUAL_UINT32(reports[i].spi_bytes, again[i].spi_bytes);
+    }
+}
+
+void test_too_long_data_is_rejected() {
+    MemoryLog log;
+    log.bytes = {'E', 'K', 'D', 'L', 1, 0};
+    // PRINT with data, claiming 2^28 bytes of text
+    log.bytes.insert(log.bytes.end(), {(uint8_t)EinkDisplay::DrawCall::PRINT | 0x80, 3, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0x7F});
+    bool success;
+    replay(log, success);
+    TEST_ASSERT_FALSE(success);
+}
+
+void test_wrong_argument_count_is_rejected() {
+    MemoryLog log;
+    {
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+        EinkDisplay::DrawRecorder recorder(log);
+        display.set_recorder(&recorder);
+        display.fill_rect(10, 10, 60, 20, EinkColor::BLACK);
+    }
+    // FILL_RECT read with only two arguments would read the rest from uninitialized record
+    log.bytes[HEADER + 1] = 2;
+    bool success;
+    replay(log, success);
+    TEST_ASSERT_FALSE(success);
+}
+
+void test_short_bitmap_is_rejected() {
+    static const uint8_t bits[8] = {};
+    MemoryLog log;
+    {
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+        EinkDisplay::DrawRecorder recorder(log);
+        display.set_recorder(&recorder);
+        display.draw_bitmap(0, 0, bits, 8, 8, EinkColor::BLACK, EinkColor::WHITE);
+    }
+    // Height 8 → 100 (zigzag 200), the data covers only 8 rows
+    const size_t height = HEADER + 2 + 1 + 3;
+    TEST_ASSERT_EQUAL_HEX8(16, log.bytes[height]);
+    log.bytes[height] = (200 & 0x7F) | 0x80;
+    log.bytes.insert(log.bytes.begin() + height + 1, 200 >> 7);
+    bool success;
+    replay(log, success);
+    TEST_ASSERT_FALSE(success);
+}
+
+void test_corrupted_logs_are_replayed_safely() {
+    MemoryLog recorded;
+    {
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+        EinkDisplay::DrawRecorder recorder(recorded);
+        display.set_recorder(&recorder);
+        draw_screen(display);
+    }
+    // Any damage has to end with a result, memory errors are caught by sanitizers
+    uint32_t seed = 1;
+    uint16_t rejected = 0;
+    const uint16_t runs = 300;
+    for (uint16_t i = 0; i < runs; i++) {
+        MemoryLog log;
+        log.bytes = recorded.bytes;
+        for (uint8_t flips = 0; flips < 3; flips++) {
+            seed = seed * 1103515245 + 12345;
+            const size_t position = HEADER + (seed >> 8) % (log.bytes.size() - HEADER);
+            log.bytes[position] ^= 1 << (seed >> 4 & 7);
+        }
+        bool success;
+        replay(log, success);
+        rejected += !success;
+    }
+    char message[80];
+    snprintf(message, sizeof(message), "%u of %u damaged logs rejected", rejected, runs);
+    TEST_MESSAGE(message);
+}
+
+void test_replay_log_file() {
+    const char* path = getenv("EINK_DRAW_LOG");
+    if (path == nullptr) {
+        TEST_IGNORE_MESSAGE("Set EINK_DRAW_LOG to replay a captured log");
+    }
+    FILE* file = fopen(path, "rb");
+    TEST_ASSERT_TRUE_MESSAGE(file != nullptr, "Cannot open the log");
+    MemoryLog log;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        log.bytes.push_back(c);
+    }
+    fclose(file);
+
+    bool success;
+    char message[160];
+    for (const EinkDisplay::FrameReport& report : replay(log, success)) {
+        snprintf(message, sizeof(message), "frame %u at %lu us: raster %lu us, %lu px, %lu SPI bytes",
+                 report.frame, (unsigned long)report.recorded_time, (unsigned long)report.raster_time,
+                 (unsigned long)report.dirty_area, (unsigned long)report.spi_bytes);
+        TEST_MESSAGE(message);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(success, "The log is corrupted");
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_reproduces_screen);
+    RUN_TEST(test_too_long_data_is_rejected);
+    RUN_TEST(test_wrong_argument_count_is_rejected);
+    RUN_TEST(test_short_bitmap_is_rejected);
+    RUN_TEST(test_corrupted_logs_are_replayed_safely);
+    RUN_TEST(test_replay_log_file);
+    return UNITY_END();
+}
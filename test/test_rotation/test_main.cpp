@@ -0,0 +1,132 @@
+// Pixels of the rotated canvas land on the panel where Adafruit GFX rotation puts them,
+// for whole frames, partial windows and filled windows.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <panel_model.h>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr uint16_t SIZE = 200;
+
+uint32_t seed = 1;
+
+uint16_t random_below(uint16_t limit) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) % limit;
+}
+
+/// Position of a pixel of the rotated screen on the panel
+void panel_position(uint8_t rotation, uint16_t x, uint16_t y, uint16_t& panel_x, uint16_t& panel_y) {
+    switch (rotation) {
+    case 1: panel_x = SIZE - 1 - y; panel_y = x; break;
+    case 2: panel_x = SIZE - 1 - x; panel_y = SIZE - 1 - y; break;
+    case 3: panel_x = y; panel_y = SIZE - 1 - x; break;
+    default: panel_x = x; panel_y = y; break;
+    }
+}
+
+/// Number of pixels of the expected screen which differ on the panel
+uint32_t mismatches(const PanelModel& panel, uint8_t rotation, const std::vector<bool>& expected) {
+    uint32_t count = 0;
+    for (uint16_t y = 0; y < SIZE; y++) {
+        for (uint16_t x = 0; x < SIZE; x++) {
+            uint16_t panel_x, panel_y;
+            panel_position(rotation, x, y, panel_x, panel_y);
+            count += panel.pixel(panel_x, panel_y) != expected[y * SIZE + x];
+        }
+    }
+    return count;
+}
+
+void draw_rect(EinkDisplay::DisplayHandle<EinkDriver::Eink1in54>& display, std::vector<bool>& expected,
+               int16_t x, int16_t y, int16_t w, int16_t h, bool white) {
+    display.fill_rect(x, y, w, h, white ? EinkColor::WHITE : EinkColor::BLACK);
+    for (int16_t j = y; j < y + h; j++) {
+        for (int16_t i = x; i < x + w; i++) {
+            expected[j * SIZE + i] = white;
+        }
+    }
+}
+
+} // namespace
+
+void setUp() {
+    seed = 1;
+}
+
+void tearDown() {}
+
+void test_whole_frame() {
+    for (uint8_t rotation = 0; rotation < 4; rotation++) {
+        PanelModel panel(DC);
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+        display.set_rotation(rotation);
+        std::vector<bool> expected(SIZE * SIZE);
+        for (uint16_t y = 0; y < SIZE; y++) {
+            for (uint16_t x = 0; x < SIZE; x++) {
+                // Asymmetric pattern, any mirroring or transposition shows
+                const bool white = (x * 7 + y * 3 + x * y) % 5 < 2;
+                display.draw_pixel(x, y, white ? EinkColor::WHITE : EinkColor::BLACK);
+                expected[y * SIZE + x] = white;
+            }
+        }
+        display.display_frame(EinkDisplay::RefreshMode::FULL);
+        TEST_ASSERT_EQUAL_UINT32(0, panel.outside);
+        TEST_ASSERT_EQUAL_UINT32(0, mismatches(panel, rotation, expected));
+    }
+}
+
+void test_partial_windows() {
+    for (uint8_t rotation = 0; rotation < 4; rotation++) {
+        PanelModel panel(DC);
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+        display.set_rotation(rotation);
+        std::vector<bool> expected(SIZE * SIZE, true);
+        display.display_frame(EinkDisplay::RefreshMode::FULL);
+        for (uint8_t frame = 0; frame < 20; frame++) {
+            // Unaligned rectangles, some touching edges of the screen
+            for (uint8_t i = 0; i < 3; i++) {
+                const int16_t w = 1 + random_below(40), h = 1 + random_below(40);
+                const int16_t x = random_below(SIZE - w + 1), y = random_below(SIZE - h + 1);
+                draw_rect(display, expected, x, y, w, h, frame & 1);
+            }
+            panel.written = 0;
+            display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+            TEST_ASSERT_LESS_THAN_UINT32(SIZE * SIZE / 8, panel.written);
+            TEST_ASSERT_EQUAL_UINT32(0, panel.outside);
+            TEST_ASSERT_EQUAL_UINT32(0, mismatches(panel, rotation, expected));
+        }
+    }
+}
+
+void test_filled_windows() {
+    for (uint8_t rotation = 0; rotation < 4; rotation++) {
+        PanelModel panel(DC);
+        EinkSPI::SPIController spi(CS, DC);
+        EinkDriver::Eink1in54 driver(RST, BUSY, spi);
+        driver.set_rotation(rotation);
+        driver.init();
+        driver.clear_frame(EinkColor::WHITE);
+        std::vector<bool> expected(SIZE * SIZE, true);
+        // Aligned to bytes in every rotation, panel would widen it otherwise
+        driver.fill_window({16, 40, 47, 63}, EinkColor::BLACK);
+        for (uint16_t y = 40; y <= 63; y++) {
+            for (uint16_t x = 16; x <= 47; x++) {
+                expected[y * SIZE + x] = false;
+            }
+        }
+        TEST_ASSERT_EQUAL_UINT32(0, panel.outside);
+        TEST_ASSERT_EQUAL_UINT32(0, mismatches(panel, rotation, expected));
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_whole_frame);
+    RUN_TEST(test_partial_windows);
+    RUN_TEST(test_filled_windows);
+    return UNITY_END();
+}
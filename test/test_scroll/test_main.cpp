@@ -0,0 +1,132 @@
+// Scrolled rectangles match scrolling pixel by pixel, for aligned and unaligned rows shifted
+// both ways, rows wider than the scroll buffer, and rectangles reaching out of the canvas.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+
+#include <vector>
+
+namespace {
+
+uint32_t seed = 1;
+
+int16_t random_between(int16_t low, int16_t high) {
+    seed = seed * 1103515245 + 12345;
+    return low + (int16_t)((seed >> 16) % (high - low + 1));
+}
+
+bool pixel(const uint8_t* bits, uint16_t width, int16_t x, int16_t y) {
+    const uint32_t i = (uint32_t)y * width + x;
+    return bits[i / 8] & (0x80 >> (i % 8));
+}
+
+void fill_random(EinkCanvas::GFXCanvasBW& canvas) {
+    uint8_t* buffer = canvas.getBuffer();
+    for (uint32_t i = 0; i < ((uint32_t)canvas.width() * canvas.height() + 7) / 8; i++) {
+        buffer[i] = random_between(0, 255);
+    }
+}
+
+/**
+ * @brief Scroll the canvas and compare it with the content before, shifted pixel by pixel.
+ */
+void check_scroll(EinkCanvas::GFXCanvasBW& canvas, int16_t x, int16_t y, int16_t w, int16_t h,
+                  int16_t dx, int16_t dy, uint16_t color) {
+    const int16_t width = canvas.width(), height = canvas.height();
+    const std::vector<uint8_t> before(canvas.getBuffer(), canvas.getBuffer() + ((uint32_t)width * height + 7) / 8);
+    canvas.scrollRect(x, y, w, h, dx, dy, color);
+
+    // Rectangle clipped by the canvas
+    const int16_t x0 = std::max<int16_t>(x, 0), y0 = std::max<int16_t>(y, 0);
+    const int16_t x1 = std::min<int16_t>(x + w - 1, width - 1), y1 = std::min<int16_t>(y + h - 1, height - 1);
+    for (int16_t py = 0; py < height; py++) {
+        for (int16_t px = 0; px < width; px++) {
+            bool expected = pixel(before.data(), width, px, py);
+            if (px >= x0 && px <= x1 && py >= y0 && py <= y1) {
+                const int16_t sx = px - dx, sy = py - dy;
+                const bool inside = sx >= x0 && sx <= x1 && sy >= y0 && sy <= y1;
+                expected = inside ? pixel(before.data(), width, sx, sy) : color != 0;
+            }
+            if (expected != pixel(canvas.getBuffer(), width, px, py)) {
+                char message[96];
+                snprintf(message, sizeof(message), "Pixel %d,%d of rect %d,%d %dx%d by %d,%d",
+                         px, py, x, y, w, h, dx, dy);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void setUp() {
+    seed = 1;
+}
+
+void tearDown() {}
+
+void test_aligned_rows() {
+    // Shifts by whole bytes of a canvas with rows at byte boundaries, the whole width too
+    EinkCanvas::GFXCanvasBW canvas(64, 40);
+    for (int16_t dy : {-7, -1, 0, 1, 5}) {
+        for (int16_t dx : {-16, -8, 0, 8, 24}) {
+            if (dx == 0 && dy == 0) continue;
+            fill_random(canvas);
+            check_scroll(canvas, 0, 0, 64, 40, dx, dy, 1);
+            fill_random(canvas);
+            check_scroll(canvas, 8, 3, 40, 30, dx, dy, 0);
+            fill_random(canvas);
+            check_scroll(canvas, 3, 2, 45, 21, dx, dy, 1);
+        }
+    }
+}
+
+void test_unaligned_rows() {
+    // Odd width, source and destination rows start at different bits
+    EinkCanvas::GFXCanvasBW canvas(61, 47);
+    for (int16_t dy : {-9, -1, 0, 1, 3}) {
+        for (int16_t dx : {-13, -3, -1, 0, 1, 7, 20}) {
+            if (dx == 0 && dy == 0) continue;
+            fill_random(canvas);
+            check_scroll(canvas, 0, 0, 61, 47, dx, dy, 0);
+            fill_random(canvas);
+            check_scroll(canvas, 5, 4, 33, 17, dx, dy, 1);
+        }
+    }
+}
+
+void test_rows_wider_than_buffer() {
+    // Rows longer than the scroll buffer are shifted in pieces, in the same row too
+    const int16_t width = EinkCanvas::GFXCanvasBW::M_SCROLL_PIECE_SIZE * 8 * 2 + 37;
+    EinkCanvas::GFXCanvasBW canvas(width, 9);
+    for (int16_t dx : {-300, -9, -1, 1, 3, 255, 300}) {
+        for (int16_t dy : {-1, 0, 2}) {
+            fill_random(canvas);
+            check_scroll(canvas, 0, 0, width, 9, dx, dy, 1);
+            fill_random(canvas);
+            check_scroll(canvas, 11, 1, width - 20, 7, dx, dy, 0);
+        }
+    }
+}
+
+void test_random_rects() {
+    EinkCanvas::GFXCanvasBW canvas(61, 47);
+    for (uint16_t i = 0; i < 2000; i++) {
+        fill_random(canvas);
+        // Rectangles reach out of the canvas, shifts reach out of the rectangles
+        const int16_t x = random_between(-20, 60), y = random_between(-20, 46);
+        const int16_t w = random_between(1, 80), h = random_between(1, 60);
+        const int16_t dx = random_between(-70, 70), dy = random_between(-50, 50);
+        check_scroll(canvas, x, y, w, h, dx, dy, random_between(0, 1));
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_aligned_rows);
+    RUN_TEST(test_unaligned_rows);
+    RUN_TEST(test_rows_wider_than_buffer);
+    RUN_TEST(test_random_rects);
+    return UNITY_END();
+}
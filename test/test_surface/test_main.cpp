@@ -0,0 +1,258 @@
+// Blits match blending pixel by pixel for every operation at any bit offset, the arena
+// carves surfaces until it is full, and the display blits and captures through its viewport.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <trace_capture.h>
+
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr EinkCanvas::BlendOp OPS[] = {EinkCanvas::BlendOp::COPY, EinkCanvas::BlendOp::AND, EinkCanvas::BlendOp::OR,
+                                       EinkCanvas::BlendOp::XOR, EinkCanvas::BlendOp::INVERT};
+// Bytes after buffers, they are never written
+constexpr size_t GUARD = 8;
+
+struct Position {
+    int16_t x, y;
+};
+// Blits inside of the viewport at 43,30 100x50, both reach out of it
+constexpr Position BLITS[] = {{-5, 41}, {37, 3}};
+
+uint32_t seed = 1;
+
+int16_t random_between(int16_t low, int16_t high) {
+    seed = seed * 1103515245 + 12345;
+    return low + (int16_t)((seed >> 16) % (high - low + 1));
+}
+
+bool get_bit(const uint8_t* bits, uint32_t i) {
+    return bits[i / 8] & (0x80 >> (i % 8));
+}
+
+void set_bit(uint8_t* bits, uint32_t i, bool white) {
+    if (white) bits[i / 8] |= 0x80 >> (i % 8);
+    else bits[i / 8] &= ~(0x80 >> (i % 8));
+}
+
+bool blend(EinkCanvas::BlendOp op, bool below, bool layer) {
+    switch (op) {
+    case EinkCanvas::BlendOp::COPY: return layer;
+    case EinkCanvas::BlendOp::AND: return below && layer;
+    case EinkCanvas::BlendOp::OR: return below || layer;
+    case EinkCanvas::BlendOp::XOR: return below != layer;
+    default: return below == layer;
+    }
+}
+
+std::vector<uint8_t> random_bytes(size_t size) {
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& byte : bytes) {
+        byte = random_between(0, 255);
+    }
+    return bytes;
+}
+
+void fill_random(EinkCanvas::Surface& surface) {
+    for (uint32_t i = 0; i < (uint32_t)surface.stride * surface.height; i++) {
+        surface.bits[i] = random_between(0, 255);
+    }
+}
+
+} // namespace
+
+void setUp() {
+    seed = 1;
+    trace::clear();
+}
+
+void tearDown() {}
+
+void test_blit_bits_matches_pixels() {
+    for (uint16_t n = 0; n < 3000; n++) {
+        // Pitches are not whole bytes, so every row starts at another bit
+        const uint32_t src_pitch = random_between(1, 90), dst_pitch = random_between(1, 90);
+        const uint16_t w = random_between(1, std::min<uint32_t>(src_pitch, dst_pitch));
+        const uint16_t h = random_between(1, 6);
+        const uint16_t src_x = random_between(0, src_pitch - w), dst_x = random_between(0, dst_pitch - w);
+        const uint16_t src_y = random_between(0, 3), dst_y = random_between(0, 3);
+        const size_t src_size = (src_pitch * (src_y + h) + 7) / 8, dst_size = (dst_pitch * (dst_y + h) + 7) / 8;
+        const std::vector<uint8_t> src = random_bytes(src_size);
+        const std::vector<uint8_t> before = random_bytes(dst_size + GUARD);
+        const EinkCanvas::BlendOp op = OPS[n % 5];
+
+        std::vector<uint8_t> dst = before;
+        EinkCanvas::blit_bits(dst.data(), dst_pitch, dst_x, dst_y, src.data(), src_pitch, src_x, src_y, w, h, op);
+        std::vector<uint8_t> expected = before;
+        for (uint16_t row = 0; row < h; row++) {
+            for (uint16_t i = 0; i < w; i++) {
+                const uint32_t d = (dst_y + row) * dst_pitch + dst_x + i;
+                const bool layer = get_bit(src.data(), (src_y + row) * src_pitch + src_x + i);
+                set_bit(expected.data(), d, blend(op, get_bit(before.data(), d), layer));
+            }
+        }
+        if (dst != expected) {
+            char message[128];
+            snprintf(message, sizeof(message), "op %u, %ux%u from %u,%u pitch %u to %u,%u pitch %u",
+                     (unsigned)op, w, h, src_x, src_y, (unsigned)src_pitch, dst_x, dst_y, (unsigned)dst_pitch);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+}
+
+void test_arena_until_full() {
+    EinkCanvas::SurfaceArena arena(100);
+    TEST_ASSERT_EQUAL_UINT32(100, arena.get_size());
+
+    // 10 pixels wide rows take 2 bytes, surfaces start at word boundaries
+    EinkCanvas::Surface a = arena.allocate(10, 3, 0);
+    TEST_ASSERT_TRUE(a.valid());
+    TEST_ASSERT_EQUAL_UINT16(2, a.stride);
+    TEST_ASSERT_EQUAL_UINT32(6, arena.get_used());
+    for (uint8_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0x00, a.bits[i]);
+    }
+    const uint32_t mark = arena.get_used();
+    EinkCanvas::Surface b = arena.allocate(17, 4);
+    TEST_ASSERT_TRUE(b.bits == a.bits + 8);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, b.bits[11]);
+    TEST_ASSERT_EQUAL_UINT32(20, arena.get_used());
+
+    // Request not fitting is refused and takes nothing
+    TEST_ASSERT_FALSE(arena.allocate(8, 81).valid());
+    TEST_ASSERT_EQUAL_UINT32(20, arena.get_used());
+    TEST_ASSERT_FALSE(arena.allocate(0, 5).valid());
+    TEST_ASSERT_FALSE(arena.allocate(5, 0).valid());
+    // Exactly the rest fits
+    EinkCanvas::Surface rest = arena.allocate(8, 80);
+    TEST_ASSERT_TRUE(rest.valid());
+    TEST_ASSERT_EQUAL_UINT32(100, arena.get_used());
+    TEST_ASSERT_FALSE(arena.allocate(1, 1).valid());
+
+    // Release frees everything after the mark, the space is carved again
+    arena.release(mark);
+    TEST_ASSERT_EQUAL_UINT32(mark, arena.get_used());
+    EinkCanvas::Surface again = arena.allocate(17, 4);
+    TEST_ASSERT_TRUE(again.bits == b.bits);
+    arena.release(99);
+    TEST_ASSERT_EQUAL_UINT32(20, arena.get_used());
+
+    arena.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, arena.get_used());
+    TEST_ASSERT_TRUE(arena.allocate(8, 100).bits == a.bits);
+
+    // Arena smaller than the alignment padding
+    EinkCanvas::SurfaceArena tiny(4);
+    TEST_ASSERT_TRUE(tiny.allocate(8, 1).valid());
+    TEST_ASSERT_FALSE(tiny.allocate(8, 1).valid());
+    TEST_ASSERT_EQUAL_UINT32(1, tiny.get_used());
+}
+
+void test_surface_blit_is_clipped() {
+    EinkCanvas::SurfaceArena arena(1024);
+    EinkCanvas::Surface dst = arena.allocate(37, 21);
+    EinkCanvas::Surface src = arena.allocate(19, 11);
+    std::vector<uint8_t> before(dst.stride * dst.height);
+    for (uint16_t n = 0; n < 500; n++) {
+        fill_random(dst);
+        fill_random(src);
+        std::copy(dst.bits, dst.bits + before.size(), before.begin());
+        const int16_t x = random_between(-25, 45), y = random_between(-15, 25);
+        const EinkCanvas::BlendOp op = OPS[n % 5];
+        EinkCanvas::blit(dst, x, y, src, op);
+        for (int16_t py = 0; py < dst.height; py++) {
+            for (int16_t px = 0; px < dst.width; px++) {
+                const uint32_t d = py * dst.stride * 8 + px;
+                const int16_t sx = px - x, sy = py - y;
+                bool expected = get_bit(before.data(), d);
+                if (sx >= 0 && sx < src.width && sy >= 0 && sy < src.height) {
+                    expected = blend(op, expected, get_bit(src.bits, sy * src.stride * 8 + sx));
+                }
+                TEST_ASSERT_EQUAL(expected, get_bit(dst.bits, d));
+            }
+        }
+    }
+}
+
+void test_display_blit_and_capture() {
+    TraceCapture trace;
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.clear_frame();
+    EinkCanvas::SurfaceArena arena(2 * 200 * 200 / 8 + 256);
+    EinkCanvas::Surface frame = arena.allocate(200, 200);
+    EinkCanvas::Surface before = arena.allocate(200, 200);
+    EinkCanvas::Surface icon = arena.allocate(21, 13);
+
+    // Viewport at column 43, blits at odd columns reach out of it
+    for (EinkCanvas::BlendOp op : OPS) {
+        display.fill_rect(0, 0, 200, 200, EinkColor::WHITE);
+        for (int16_t i = 0; i < 200; i += 3) {
+            display.draw_line(i, 0, 200 - i, 199, EinkColor::BLACK);
+        }
+        display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+        display.capture(before, 0, 0);
+        fill_random(icon);
+        TEST_ASSERT_TRUE(display.push_viewport(43, 30, 100, 50));
+        for (const Position& at : BLITS) {
+            display.blit(icon, at.x, at.y, op);
+        }
+        display.pop_viewport();
+
+        display.capture(frame, 0, 0);
+        int16_t x0 = INT16_MAX, y0 = INT16_MAX, x1 = INT16_MIN, y1 = INT16_MIN;
+        for (int16_t y = 0; y < 200; y++) {
+            for (int16_t x = 0; x < 200; x++) {
+                const uint32_t i = y * 200 + x;
+                bool expected = get_bit(before.bits, i);
+                const bool in_viewport = x >= 43 && x < 143 && y >= 30 && y < 80;
+                for (const Position& at : BLITS) {
+                    const int16_t sx = x - 43 - at.x, sy = y - 30 - at.y;
+                    if (in_viewport && sx >= 0 && sx < icon.width && sy >= 0 && sy < icon.height) {
+                        expected = blend(op, expected, get_bit(icon.bits, sy * icon.stride * 8 + sx));
+                    }
+                }
+                TEST_ASSERT_EQUAL(expected, get_bit(frame.bits, i));
+                if (expected != get_bit(before.bits, i)) {
+                    x0 = std::min(x0, x), y0 = std::min(y0, y);
+                    x1 = std::max(x1, x), y1 = std::max(y1, y);
+                }
+            }
+        }
+
+        // Refreshed box covers the changed pixels, inside of the blits clipped by the viewport
+        trace::clear();
+        display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+        const std::vector<trace::Record> records = trace.read();
+        TEST_ASSERT_FALSE(records.empty());
+        TEST_ASSERT_EQUAL_UINT8(trace::Event::REFRESH, records[0].event);
+        const uint16_t* box = records[0].data;
+        TEST_ASSERT_TRUE(box[0] >= 43 && box[1] >= 33 && box[2] <= 100 && box[3] <= 79);
+        TEST_ASSERT_TRUE(box[0] <= x0 && box[1] <= y0 && box[2] >= x1 && box[3] >= y1);
+    }
+
+    // Capture through a viewport leaves the part of the surface outside of it
+    EinkCanvas::Surface part = arena.allocate(30, 20, 0);
+    TEST_ASSERT_TRUE(part.valid());
+    display.push_viewport(43, 30, 100, 50);
+    display.capture(part, 90, 35);
+    display.pop_viewport();
+    for (int16_t y = 0; y < part.height; y++) {
+        for (int16_t x = 0; x < part.width; x++) {
+            const bool inside = 90 + x < 100 && 35 + y < 50;
+            const bool expected = inside && get_bit(frame.bits, (30 + 35 + y) * 200 + 43 + 90 + x);
+            TEST_ASSERT_EQUAL(expected, get_bit(part.bits, y * part.stride * 8 + x));
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_blit_bits_matches_pixels);
+    RUN_TEST(test_arena_until_full);
+    RUN_TEST(test_surface_blit_is_clipped);
+    RUN_TEST(test_display_blit_and_capture);
+    return UNITY_END();
+}
@@ -0,0 +1,50 @@
+// Formatting of fields stays within their compile time maximal length.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+
+using namespace EinkFormat;
+
+void setUp() {}
+
+void tearDown() {}
+
+template <typename Field>
+void check(const Field& field, const char* expected) {
+    char text[FieldLength<Field>::value + 1];
+    const uint8_t length = format(text, field);
+    text[length] = '\0';
+    TEST_ASSERT_LESS_OR_EQUAL(FieldLength<Field>::value, length);
+    TEST_ASSERT_EQUAL_STRING(expected, text);
+}
+
+void test_time_parts_out_of_range() {
+    check(Time<>{12, 5, 9}, "12:05:09");
+    check(Time<>{200, 200, 200}, "00:00:00");
+    check(Time<>{255, 99, 100}, "55:99:00");
+    check(Time<false>{123, 45, 0}, "23:45");
+}
+
+void test_numbers_at_limits() {
+    check(Int<>{INT32_MIN}, "-2147483648");
+    check(Int<3, '0'>{7}, "007");
+    check(Fixed<1>{INT32_MIN}, "-214748364.8");
+    check(Fixed<9>{INT32_MAX}, "2.147483647");
+    check(Fixed<1, 6, '0'>{-215}, "-021.5");
+}
+
+void test_print_fields_longer_than_255() {
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(5, 17, 16, 4);
+    TEST_ASSERT_EQUAL(308, (max_length<Int<150>, Int<150>, Time<>>()));
+    display.print_fields(0, 20, EinkColor::BLACK, Int<150>{1}, Int<150>{2}, Time<>{200, 200, 200});
+    display.print_fields(0, 40, EinkColor::BLACK, Time<>{255, 255, 255}, ' ', Time<false>{255, 255, 0});
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_time_parts_out_of_range);
+    RUN_TEST(test_numbers_at_limits);
+    RUN_TEST(test_print_fields_longer_than_255);
+    return UNITY_END();
+}
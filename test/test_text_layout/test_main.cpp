@@ -0,0 +1,115 @@
+// Benchmark of text measurement and layout of multi-line status pages.
+
+#include <unity.h>
+
+#include <chrono>
+
+#include <eink_waveshare.h>
+
+namespace {
+
+// Proportional font with 12 px high glyphs, advances vary from 4 to 9 px
+uint8_t bitmap[95 * 12];
+GFXglyph glyphs[95];
+const GFXfont font = {bitmap, glyphs, 0x20, 0x7E, 16};
+
+const char* const PAGES[] = {
+    "Next stop: Main Square\nArrival 12:45, 3 min\nPlatform 2\nLine 4 towards Central Station via Old Town and University Campus",
+    "Battery 87 %  Signal good\nTemperature 21.5 C, humidity 40 %\nLast update 10:02:17\nWind 3 m/s from north west, gusts up to 9 m/s",
+    "Route recalculated because of a closed road. Continue straight for 400 m, then turn left onto Long Street and keep right at the fork.",
+};
+
+template <typename Function>
+double nanoseconds_per_call(uint32_t calls, Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++) {
+        function();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+} // namespace
+
+void setUp() {
+    for (uint8_t i = 0; i < 95; i++) {
+        glyphs[i] = {(uint16_t)(i * 12), 6, 12, (uint8_t)(4 + i % 6), 0, -10};
+        memset(bitmap + i * 12, 0x5A, 9);
+    }
+    glyphs[0].width = glyphs[0].height = 0; // Space
+}
+
+void tearDown() {}
+
+void test_text_width_matches_glyphs() {
+    EinkDisplay::FontMetrics metrics;
+    metrics.set_font(&font);
+    for (const char* page : PAGES) {
+        uint16_t expected = 0;
+        for (const char* c = page; *c; c++) {
+            if (*c >= 0x20 && *c <= 0x7E) expected += glyphs[*c - 0x20].xAdvance;
+        }
+        TEST_ASSERT_EQUAL_UINT16(expected, metrics.text_width(page, strlen(page)));
+    }
+}
+
+void test_status_pages() {
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(5, 17, 16, 4);
+    EinkCanvas::GFXCanvasBW canvas(200, 200);
+    canvas.setFont(&font);
+    display.set_font(&font);
+    EinkDisplay::FontMetrics metrics;
+    metrics.set_font(&font);
+
+    volatile uint32_t sink = 0;
+    const double metrics_ns = nanoseconds_per_call(2000, [&] {
+        for (const char* page : PAGES) sink = sink + metrics.text_width(page, strlen(page));
+    });
+    const double bounds_ns = nanoseconds_per_call(2000, [&] {
+        for (const char* page : PAGES) {
+            int16_t x, y;
+            uint16_t w, h;
+            canvas.getTextBounds(page, 0, 20, &x, &y, &w, &h);
+            sink = sink + w;
+        }
+    });
+    const double box_ns = nanoseconds_per_call(500, [&] {
+        for (const char* page : PAGES) {
+            const char* rest = display.print_box(0, 0, 200, 200, EinkColor::BLACK, page, EinkDisplay::TextAlign::CENTER);
+            TEST_ASSERT_EQUAL(0, *rest);
+        }
+    });
+
+    char message[120];
+    snprintf(message, sizeof(message), "text_width %.0f ns, getTextBounds %.0f ns per %u pages",
+             metrics_ns, bounds_ns, (unsigned)(sizeof(PAGES) / sizeof(*PAGES)));
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message), "print_box %.0f ns per %u pages, glyphs drawn included",
+             box_ns, (unsigned)(sizeof(PAGES) / sizeof(*PAGES)));
+    TEST_MESSAGE(message);
+}
+
+void test_pagination() {
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(5, 17, 16, 4);
+    display.set_font(&font);
+    // Boxes of two lines, every box continues where the previous one stopped
+    for (const char* page : PAGES) {
+        const char* rest = page;
+        uint8_t boxes = 0;
+        while (*rest != 0) {
+            const char* next = display.print_box(0, 0, 120, 32, EinkColor::BLACK, rest);
+            TEST_ASSERT_TRUE(next > rest);
+            rest = next;
+            boxes++;
+        }
+        TEST_ASSERT_GREATER_THAN(1, boxes);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_text_width_matches_glyphs);
+    RUN_TEST(test_status_pages);
+    RUN_TEST(test_pagination);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+// Tiles of a redrawn but identical frame are not refreshed at all, otherwise only the
+// tiles whose content changed are uploaded, however large the dirty area is.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <spi_monitor.h>
+#include <trace_capture.h>
+
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr uint16_t SIZE = 200;
+constexpr uint16_t STRIDE = SIZE / 8;
+constexpr uint16_t TILE_WIDTH = EinkDisplay::TileHashes::M_TILE_BYTES * 8;
+constexpr uint16_t TILE_ROWS = EinkDisplay::TileHashes::M_TILE_ROWS;
+constexpr uint16_t TILE_SIZE = EinkDisplay::TileHashes::M_TILE_BYTES * TILE_ROWS;
+
+void draw_screen(EinkDisplay::DisplayHandle<EinkDriver::Eink1in54>& display) {
+    display.clear_buffer();
+    display.fill_rect(10, 10, 80, 30, EinkColor::BLACK);
+    display.draw_circle(120, 120, 40, EinkColor::BLACK);
+    display.print(20, 60, EinkColor::BLACK, "12:34");
+}
+
+uint32_t changed_tiles(const EinkDisplay::TileHashes& tiles) {
+    uint32_t count = 0;
+    for (uint16_t ty = 0; ty < tiles.tiles_y(); ty++) {
+        for (uint16_t tx = 0; tx < tiles.tiles_x(); tx++) {
+            count += tiles.is_changed(tx, ty);
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+void setUp() {
+    trace::clear();
+}
+
+void tearDown() {}
+
+void test_update_shrinks_to_changed_tiles() {
+    EinkDisplay::TileHashes tiles(SIZE, SIZE);
+    TEST_ASSERT_FALSE(tiles.is_valid());
+    TEST_ASSERT_EQUAL_UINT16(4, tiles.tiles_x());
+    TEST_ASSERT_EQUAL_UINT16(25, tiles.tiles_y());
+
+    std::vector<uint8_t> frame(STRIDE * SIZE, 0xFF);
+    tiles.rehash(frame.data());
+    TEST_ASSERT_TRUE(tiles.is_valid());
+
+    // Whole frame dirty, nothing changed
+    uint16_t x_start = 0, y_start = 0, x_end = SIZE - 1, y_end = SIZE - 1;
+    TEST_ASSERT_FALSE(tiles.update(frame.data(), x_start, y_start, x_end, y_end));
+    TEST_ASSERT_EQUAL_UINT32(0, changed_tiles(tiles));
+
+    // One pixel in tile (1, 2), area is shrunk to the tile
+    frame[20 * STRIDE + 9] ^= 0x10;
+    x_start = 0, y_start = 0, x_end = SIZE - 1, y_end = SIZE - 1;
+    TEST_ASSERT_TRUE(tiles.update(frame.data(), x_start, y_start, x_end, y_end));
+    TEST_ASSERT_EQUAL_UINT32(1, changed_tiles(tiles));
+    TEST_ASSERT_TRUE(tiles.is_changed(1, 2));
+    TEST_ASSERT_EQUAL_UINT16(TILE_WIDTH, x_start);
+    TEST_ASSERT_EQUAL_UINT16(2 * TILE_ROWS, y_start);
+    TEST_ASSERT_EQUAL_UINT16(2 * TILE_WIDTH - 1, x_end);
+    TEST_ASSERT_EQUAL_UINT16(3 * TILE_ROWS - 1, y_end);
+
+    // Same frame again, the hash was updated
+    x_start = 0, y_start = 0, x_end = SIZE - 1, y_end = SIZE - 1;
+    TEST_ASSERT_FALSE(tiles.update(frame.data(), x_start, y_start, x_end, y_end));
+
+    // Narrow last column and last row, area beyond the frame is clamped
+    frame[(SIZE - 1) * STRIDE + STRIDE - 1] = 0x00;
+    x_start = 150, y_start = 150, x_end = 1000, y_end = 1000;
+    TEST_ASSERT_TRUE(tiles.update(frame.data(), x_start, y_start, x_end, y_end));
+    TEST_ASSERT_TRUE(tiles.is_changed(3, 24));
+    TEST_ASSERT_EQUAL_UINT32(1, changed_tiles(tiles));
+    TEST_ASSERT_EQUAL_UINT16(3 * TILE_WIDTH, x_start);
+    TEST_ASSERT_EQUAL_UINT16(24 * TILE_ROWS, y_start);
+    TEST_ASSERT_EQUAL_UINT16(SIZE - 1, x_end);
+    TEST_ASSERT_EQUAL_UINT16(SIZE - 1, y_end);
+
+    // Change outside of the dirty area is not looked at
+    frame[0] = 0x00;
+    x_start = 100, y_start = 100, x_end = 120, y_end = 120;
+    TEST_ASSERT_FALSE(tiles.update(frame.data(), x_start, y_start, x_end, y_end));
+}
+
+void test_unchanged_frame_is_skipped() {
+    SpiMonitor monitor(CS, DC);
+    TraceCapture trace;
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.clear_frame();
+    draw_screen(display);
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    TEST_ASSERT_EQUAL_UINT32(1, trace.count(trace::Event::REFRESH));
+
+    // Whole screen redrawn the same
+    draw_screen(display);
+    trace::clear();
+    monitor.reset();
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    TEST_ASSERT_EQUAL_UINT32(0, monitor.transactions);
+    TEST_ASSERT_EQUAL_UINT32(1, trace.count(trace::Event::UNCHANGED));
+    TEST_ASSERT_EQUAL_UINT32(0, trace.count(trace::Event::REFRESH));
+
+    // Pixel drawn and erased again
+    display.draw_pixel(70, 70, EinkColor::BLACK);
+    display.draw_pixel(70, 70, EinkColor::WHITE);
+    display.display_frame(EinkDisplay::RefreshMode::AUTO);
+    TEST_ASSERT_EQUAL_UINT32(0, monitor.transactions);
+    TEST_ASSERT_EQUAL_UINT32(2, trace.count(trace::Event::UNCHANGED));
+
+    // Full refresh is done when asked for
+    display.display_frame(EinkDisplay::RefreshMode::FULL);
+    TEST_ASSERT_EQUAL_UINT32(1, trace.count(trace::Event::REFRESH));
+}
+
+void test_only_changed_tiles_are_uploaded() {
+    SpiMonitor monitor(CS, DC);
+    TraceCapture trace;
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.clear_frame();
+
+    // Whole screen is dirty, two pixels in distant tiles really change
+    display.fill_rect(0, 0, SIZE, SIZE, EinkColor::BLACK);
+    display.fill_rect(0, 0, SIZE, SIZE, EinkColor::WHITE);
+    display.draw_pixel(5, 5, EinkColor::BLACK);
+    display.draw_pixel(150, 190, EinkColor::BLACK);
+    trace::clear();
+    monitor.reset();
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.commands[0x20]);
+    TEST_ASSERT_EQUAL_UINT32(2 * TILE_SIZE, monitor.ram_bytes);
+
+    // Windows are the two tiles
+    std::vector<trace::Record> uploads;
+    for (const trace::Record& record : trace.read()) {
+        if (record.event == (uint8_t)trace::Event::UPLOAD_START) {
+            uploads.push_back(record);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, uploads.size());
+    const uint16_t expected[2][4] = {{0, 0, TILE_WIDTH - 1, TILE_ROWS - 1},
+                                     {2 * TILE_WIDTH, 23 * TILE_ROWS, 3 * TILE_WIDTH - 1, 24 * TILE_ROWS - 1}};
+    for (uint8_t i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL_MEMORY(expected[i], uploads[i].data, sizeof(expected[i]));
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_update_shrinks_to_changed_tiles);
+    RUN_TEST(test_unchanged_frame_is_skipped);
+    RUN_TEST(test_only_changed_tiles_are_uploaded);
+    return UNITY_END();
+}
@@ -0,0 +1,153 @@
+// Time plot keeps the newest samples in its ring, each column spans its samples and the last
+// sample before them, and plots drawn sample by sample match plots drawn whole.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr int16_t PLOT_X = 13, PLOT_Y = 20;
+// Values map to rows one to one, value 0 is the bottom row
+constexpr uint16_t PLOT_HEIGHT = 30;
+
+uint32_t seed = 1;
+
+int16_t random_between(int16_t low, int16_t high) {
+    seed = seed * 1103515245 + 12345;
+    return low + (int16_t)((seed >> 16) % (high - low + 1));
+}
+
+bool pixel(const uint8_t* bits, uint16_t width, int16_t x, int16_t y) {
+    const uint32_t i = (uint32_t)y * width + x;
+    return bits[i / 8] & (0x80 >> (i % 8));
+}
+
+/**
+ * @brief Check every column of the plot area against samples of the plot, newest at the right.
+ * @param values All samples appended to the plot.
+ * @param kept Number of samples the plot keeps.
+ */
+void assert_columns(EinkCanvas::GFXCanvasBW& canvas, uint16_t width, uint16_t per_column,
+                    const std::vector<float>& values, uint32_t kept) {
+    const uint32_t total = values.size();
+    const uint32_t oldest = total - std::min<uint32_t>(total, kept);
+    int32_t column = (total - 1) / per_column;
+    for (int16_t x = PLOT_X + width - 1; x >= PLOT_X; x--, column--) {
+        int16_t low = PLOT_HEIGHT, high = -1;
+        if (total > 0 && column >= 0 && (uint32_t)(column + 1) * per_column > oldest) {
+            const uint32_t start = std::max<uint32_t>(column * per_column, oldest);
+            const uint32_t end = std::min<uint32_t>((column + 1) * per_column, total);
+            // Column reaches the last sample of the previous one
+            for (uint32_t i = start > 0 ? start - 1 : 0; i < end; i++) {
+                const int16_t value = std::max<int16_t>(0, std::min<int16_t>(PLOT_HEIGHT - 1, values[i]));
+                low = std::min(low, value);
+                high = std::max(high, value);
+            }
+        }
+        for (int16_t value = 0; value < PLOT_HEIGHT; value++) {
+            const bool expected = value >= low && value <= high;
+            const bool set = pixel(canvas.getBuffer(), canvas.width(), x, PLOT_Y + PLOT_HEIGHT - 1 - value);
+            if (expected != set) {
+                char message[64];
+                snprintf(message, sizeof(message), "Column %d value %d", x - PLOT_X, value);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void setUp() {
+    seed = 1;
+}
+
+void tearDown() {}
+
+void test_ring_wraps_at_capacity() {
+    EinkCanvas::GFXCanvasBW canvas(64, 64);
+    EinkCanvas::TimePlot plot(PLOT_X, PLOT_Y, 10, PLOT_HEIGHT, 0, PLOT_HEIGHT - 1);
+    for (uint16_t i = 0; i < 37; i++) {
+        TEST_ASSERT_TRUE(plot.append(i));
+        TEST_ASSERT_EQUAL_UINT32(std::min<uint32_t>(i + 1, 10), plot.size());
+    }
+    plot.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, plot.size());
+
+    // Columns after several turns of the ring, out of range values are clamped
+    std::vector<float> values;
+    for (uint16_t i = 0; i < 37; i++) {
+        values.push_back(random_between(-5, PLOT_HEIGHT + 5));
+        plot.append(values.back());
+        if (i == 3 || i == 9 || i == 10 || i == 19 || i == 36) {
+            canvas.fillScreen(0);
+            plot.draw(canvas, 1);
+            assert_columns(canvas, 10, 1, values, 10);
+        }
+    }
+}
+
+void test_columns_span_previous_sample() {
+    // Capacity 20 is rounded up to 3 samples in each of 8 columns
+    EinkCanvas::GFXCanvasBW canvas(64, 64);
+    EinkCanvas::TimePlot plot(PLOT_X, PLOT_Y, 8, PLOT_HEIGHT, 0, PLOT_HEIGHT - 1, 20);
+    std::vector<float> values;
+    for (uint16_t i = 0; i < 60; i++) {
+        values.push_back(random_between(0, PLOT_HEIGHT - 1));
+        TEST_ASSERT_EQUAL(i % 3 == 0, plot.append(values.back()));
+        TEST_ASSERT_EQUAL_UINT32(std::min<uint32_t>(i + 1, 24), plot.size());
+        canvas.fillScreen(0);
+        plot.draw(canvas, 1);
+        assert_columns(canvas, 8, 3, values, 24);
+    }
+
+    // Step between columns is drawn in the column after it
+    EinkCanvas::TimePlot step(PLOT_X, PLOT_Y, 4, PLOT_HEIGHT, 0, PLOT_HEIGHT - 1, 8);
+    for (float value : {5, 5, 20, 20}) {
+        step.append(value);
+    }
+    canvas.fillScreen(0);
+    step.draw(canvas, 1);
+    assert_columns(canvas, 4, 2, {5, 5, 20, 20}, 8);
+    TEST_ASSERT_TRUE(pixel(canvas.getBuffer(), 64, PLOT_X + 3, PLOT_Y + PLOT_HEIGHT - 1 - 5));
+    TEST_ASSERT_TRUE(pixel(canvas.getBuffer(), 64, PLOT_X + 3, PLOT_Y + PLOT_HEIGHT - 1 - 20));
+    TEST_ASSERT_FALSE(pixel(canvas.getBuffer(), 64, PLOT_X + 2, PLOT_Y + PLOT_HEIGHT - 1 - 6));
+}
+
+void test_scrolled_plot_matches_redraw() {
+    for (uint16_t capacity : {0, 100}) {
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> scrolled(CS, DC, RST, BUSY);
+        EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> redrawn(CS, DC, RST, BUSY);
+        EinkCanvas::TimePlot plot(PLOT_X, PLOT_Y, 50, PLOT_HEIGHT, 0, PLOT_HEIGHT - 1, capacity);
+        // Neighbours of the plot area are not touched by scrolling
+        scrolled.fill_rect(0, PLOT_Y - 2, 200, PLOT_HEIGHT + 4, EinkColor::BLACK);
+        redrawn.fill_rect(0, PLOT_Y - 2, 200, PLOT_HEIGHT + 4, EinkColor::BLACK);
+        scrolled.draw_plot(plot, EinkColor::BLACK);
+
+        EinkCanvas::SurfaceArena arena(2 * 200 * 200 / 8);
+        EinkCanvas::Surface a = arena.allocate(200, 200);
+        EinkCanvas::Surface b = arena.allocate(200, 200);
+        for (uint16_t i = 0; i < 260; i++) {
+            scrolled.add_sample(plot, random_between(-3, PLOT_HEIGHT + 2), EinkColor::BLACK);
+            if (i % 37 == 0 || i == 259) {
+                redrawn.draw_plot(plot, EinkColor::BLACK);
+                scrolled.capture(a, 0, 0);
+                redrawn.capture(b, 0, 0);
+                TEST_ASSERT_EQUAL_MEMORY(b.bits, a.bits, 200 * 200 / 8);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_wraps_at_capacity);
+    RUN_TEST(test_columns_span_previous_sample);
+    RUN_TEST(test_scrolled_plot_matches_redraw);
+    return UNITY_END();
+}
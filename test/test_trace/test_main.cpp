@@ -0,0 +1,155 @@
+// Trace ring buffer at EINK_TRACE_LEVEL 1: the newest events are kept in order, a refresh
+// logs its phases with the busy time, and tools/trace_decode.py reads the dump.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <spi_monitor.h>
+#include <trace_capture.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+const char* const TOOL = "lib/lib_eink_waveshare/tools/trace_decode.py";
+
+std::vector<uint8_t> events(const std::vector<trace::Record>& records) {
+    std::vector<uint8_t> result;
+    for (const trace::Record& record : records) {
+        result.push_back(record.event);
+    }
+    return result;
+}
+
+} // namespace
+
+void setUp() {
+    trace::clear();
+}
+
+void tearDown() {
+    ArduinoStub::read_pin = nullptr;
+}
+
+void test_empty_dump() {
+    TraceCapture trace;
+    TEST_ASSERT_TRUE(trace.read().empty());
+    const uint8_t header[] = {'E', 'K', 'T', 'R', 1, 0, sizeof(trace::Record), 0, 0, 0, 0, 0};
+    TEST_ASSERT_EQUAL_UINT32(sizeof(header), trace.bytes.size());
+    TEST_ASSERT_EQUAL_MEMORY(header, trace.bytes.data(), sizeof(header));
+}
+
+void test_ring_keeps_newest_events() {
+    TraceCapture trace;
+    const uint32_t total = EINK_TRACE_CAPACITY + 10;
+    for (uint32_t i = 0; i < total; i++) {
+        trace::log(trace::Event::UPLOAD_START, i & 0xFF, i, i + 1, i + 2, i + 3);
+    }
+    const std::vector<trace::Record> records = trace.read();
+    TEST_ASSERT_EQUAL_UINT32(EINK_TRACE_CAPACITY, records.size());
+    for (uint32_t i = 0; i < records.size(); i++) {
+        const uint32_t n = total - EINK_TRACE_CAPACITY + i;
+        TEST_ASSERT_EQUAL_UINT16(n, records[i].sequence);
+        TEST_ASSERT_EQUAL_UINT8(n & 0xFF, records[i].arg);
+        TEST_ASSERT_EQUAL_UINT16(n, records[i].data[0]);
+        TEST_ASSERT_EQUAL_UINT16(n + 3, records[i].data[3]);
+        if (i > 0) {
+            TEST_ASSERT_TRUE(records[i].time >= records[i - 1].time);
+        }
+    }
+
+    trace::clear();
+    TEST_ASSERT_TRUE(trace.read().empty());
+}
+
+void test_refresh_phases() {
+    // Busy pin stays high for 250 reads, 1 ms each, after MASTER_ACTIVATION
+    SpiMonitor monitor(CS, DC);
+    uint32_t busy_reads = 0;
+    ArduinoStub::read_pin = [&](uint8_t pin) {
+        if (pin != BUSY) return (int)ArduinoStub::pins[pin];
+        if (monitor.commands[0x20] > 0) {
+            monitor.commands[0x20] = 0;
+            busy_reads = 250;
+        }
+        return busy_reads > 0 && busy_reads-- > 0 ? HIGH : LOW;
+    };
+    TraceCapture trace;
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.clear_frame(EinkColor::BLACK);
+    std::vector<trace::Record> records = trace.read();
+    TEST_ASSERT_FALSE(records.empty());
+    TEST_ASSERT_EQUAL_UINT8(trace::Event::CLEAR, records[0].event);
+    TEST_ASSERT_EQUAL_UINT8(EinkColor::BLACK.value(), records[0].arg);
+
+    trace::clear();
+    display.fill_rect(30, 40, 10, 20, EinkColor::WHITE);
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    records = trace.read();
+    const std::vector<uint8_t> expected = {
+        (uint8_t)trace::Event::REFRESH, (uint8_t)trace::Event::UPLOAD_START, (uint8_t)trace::Event::UPLOAD_END,
+        (uint8_t)trace::Event::BUSY_START, (uint8_t)trace::Event::BUSY_END};
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), records.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected.data(), events(records).data(), expected.size());
+    TEST_ASSERT_EQUAL_UINT8(EinkDriver::Waveform::PARTIAL, records[0].arg);
+    const uint16_t box[4] = {30, 40, 39, 59};
+    TEST_ASSERT_EQUAL_MEMORY(box, records[0].data, sizeof(box));
+    TEST_ASSERT_EQUAL_UINT16(250, records[4].data[0]);
+    TEST_ASSERT_TRUE(records[4].time - records[3].time >= 250000);
+
+    trace::clear();
+    display.display_frame();
+    records = trace.read();
+    TEST_ASSERT_EQUAL_UINT32(1, records.size());
+    TEST_ASSERT_EQUAL_UINT8(trace::Event::UNCHANGED, records[0].event);
+}
+
+void test_decoder_reads_dump() {
+    if (system("python3 --version >/dev/null 2>&1") != 0) {
+        TEST_IGNORE_MESSAGE("python3 is required");
+    }
+    TraceCapture trace;
+    for (uint32_t i = 0; i < EINK_TRACE_CAPACITY + 1; i++) {
+        trace::log(trace::Event::UNCHANGED);
+    }
+    trace::log(trace::Event::REFRESH, 1, 0, 8, 63, 15);
+    trace::log(trace::Event::BUSY_END, 0, 321);
+    trace.read();
+
+    char path[] = "/tmp/trace_XXXXXX";
+    const int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    FILE* file = fdopen(fd, "wb");
+    // Decoder finds the header after other output of the serial console
+    fputs("boot messages\n", file);
+    fwrite(trace.bytes.data(), 1, trace.bytes.size(), file);
+    fclose(file);
+
+    const std::string command = std::string("python3 ") + TOOL + " " + path;
+    FILE* pipe = popen(command.c_str(), "r");
+    std::string output;
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        output += buffer;
+    }
+    const int status = pclose(pipe);
+    remove(path);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_TRUE_MESSAGE(output.find("refresh (0, 8) - (63, 15) partial") != std::string::npos, output.c_str());
+    TEST_ASSERT_TRUE_MESSAGE(output.find("busy_end 321 ms") != std::string::npos, output.c_str());
+    // The ring wrapped, but the kept events are consecutive
+    TEST_ASSERT_TRUE_MESSAGE(output.find("events lost") == std::string::npos, output.c_str());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_dump);
+    RUN_TEST(test_ring_keeps_newest_events);
+    RUN_TEST(test_refresh_phases);
+    RUN_TEST(test_decoder_reads_dump);
+    return UNITY_END();
+}
@@ -0,0 +1,245 @@
+// Drawing clipped once by nested viewports sets the same pixels as drawing clipped pixel by
+// pixel, for lines, rectangles and rows crossing the edges, and the dirty area is clipped too.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <trace_capture.h>
+
+#include <vector>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+// Odd size, rows of the canvas do not start at byte boundaries
+constexpr int16_t CANVAS_WIDTH = 61, CANVAS_HEIGHT = 47;
+
+uint32_t seed = 1;
+
+int16_t random_between(int16_t low, int16_t high) {
+    seed = seed * 1103515245 + 12345;
+    return low + (int16_t)((seed >> 16) % (high - low + 1));
+}
+
+/// Reference canvas, every pixel is translated and checked against the clip rectangle
+class PixelCanvas : public Adafruit_GFX {
+public:
+    PixelCanvas() : Adafruit_GFX(CANVAS_WIDTH, CANVAS_HEIGHT), white(CANVAS_WIDTH * CANVAS_HEIGHT) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        x += origin_x;
+        y += origin_y;
+        if (x < clip_x0 || x > clip_x1 || y < clip_y0 || y > clip_y1) return;
+        white[y * CANVAS_WIDTH + x] = color != 0;
+    }
+
+    /// Same nesting as GFXCanvasBW::pushViewport()
+    void push(int16_t x, int16_t y, int16_t w, int16_t h) {
+        origin_x += x;
+        origin_y += y;
+        clip_x0 = std::max<int16_t>(clip_x0, origin_x);
+        clip_y0 = std::max<int16_t>(clip_y0, origin_y);
+        clip_x1 = std::min<int16_t>(clip_x1, origin_x + w - 1);
+        clip_y1 = std::min<int16_t>(clip_y1, origin_y + h - 1);
+    }
+
+    std::vector<bool> white;
+    int16_t origin_x = 0, origin_y = 0;
+    int16_t clip_x0 = 0, clip_y0 = 0, clip_x1 = CANVAS_WIDTH - 1, clip_y1 = CANVAS_HEIGHT - 1;
+};
+
+uint32_t mismatches(EinkCanvas::GFXCanvasBW& canvas, const PixelCanvas& reference) {
+    uint32_t count = 0;
+    const uint8_t* buffer = canvas.getBuffer();
+    for (int32_t i = 0; i < CANVAS_WIDTH * CANVAS_HEIGHT; i++) {
+        count += ((buffer[i / 8] & (0x80 >> (i % 8))) != 0) != reference.white[i];
+    }
+    return count;
+}
+
+/// Both canvases get the same random nesting of viewports, some reach outside of their parents
+void push_random_viewports(EinkCanvas::GFXCanvasBW& canvas, PixelCanvas& reference) {
+    for (uint8_t depth = random_between(0, 3); depth > 0; depth--) {
+        const int16_t x = random_between(-10, 40), y = random_between(-10, 30);
+        const int16_t w = random_between(1, 50), h = random_between(1, 40);
+        TEST_ASSERT_TRUE(canvas.pushViewport(x, y, w, h));
+        reference.push(x, y, w, h);
+    }
+}
+
+template <typename Draw>
+void compare(Draw draw) {
+    for (uint16_t i = 0; i < 2000; i++) {
+        EinkCanvas::GFXCanvasBW canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+        PixelCanvas reference;
+        push_random_viewports(canvas, reference);
+        for (uint8_t n = 0; n < 4; n++) {
+            draw(canvas, reference, n & 1);
+        }
+        TEST_ASSERT_EQUAL_UINT32(0, mismatches(canvas, reference));
+    }
+}
+
+} // namespace
+
+void setUp() {
+    seed = 1;
+    trace::clear();
+}
+
+void tearDown() {}
+
+void test_lines() {
+    compare([](EinkCanvas::GFXCanvasBW& canvas, PixelCanvas& reference, uint16_t color) {
+        // Steep, flat, axis parallel and single pixel lines in all directions
+        const int16_t x0 = random_between(-80, 140), y0 = random_between(-80, 130);
+        const int16_t x1 = random_between(0, 3) == 0 ? x0 : random_between(-80, 140);
+        const int16_t y1 = random_between(0, 3) == 0 ? y0 : random_between(-80, 130);
+        canvas.drawLine(x0, y0, x1, y1, color);
+        reference.drawLine(x0, y0, x1, y1, color);
+    });
+}
+
+void test_rectangles() {
+    compare([](EinkCanvas::GFXCanvasBW& canvas, PixelCanvas& reference, uint16_t color) {
+        const int16_t x = random_between(-40, 70), y = random_between(-40, 55);
+        const int16_t w = random_between(-3, 80), h = random_between(-3, 60);
+        switch (random_between(0, 3)) {
+        case 0:
+            canvas.fillRect(x, y, w, h, color);
+            reference.fillRect(x, y, w, h, color);
+            break;
+        case 1:
+            // Outline of an empty rectangle is left to Adafruit GFX
+            if (w > 0 && h > 0) {
+                canvas.drawRect(x, y, w, h, color);
+                reference.drawRect(x, y, w, h, color);
+            }
+            break;
+        case 2:
+            // Negative length goes to the left
+            canvas.drawFastHLine(x, y, w, color);
+            if (w < 0) reference.drawFastHLine(x + w + 1, y, -w, color);
+            else reference.drawFastHLine(x, y, w, color);
+            break;
+        default:
+            canvas.drawFastVLine(x, y, h, color);
+            if (h < 0) reference.drawFastVLine(x, y + h + 1, -h, color);
+            else reference.drawFastVLine(x, y, h, color);
+            break;
+        }
+    });
+}
+
+void test_rows() {
+    compare([](EinkCanvas::GFXCanvasBW& canvas, PixelCanvas& reference, uint16_t) {
+        uint8_t bits[12];
+        for (uint8_t& byte : bits) {
+            byte = random_between(0, 255);
+        }
+        const int16_t w = random_between(1, 8 * sizeof(bits));
+        const int16_t x = random_between(-100, 70), y = random_between(-5, 50);
+        canvas.writeRow(x, y, bits, w);
+        for (int16_t i = 0; i < w; i++) {
+            reference.drawPixel(x + i, y, bits[i / 8] & (0x80 >> (i % 8)));
+        }
+
+        // Read back through the viewport, translated but not clipped, 0 outside of the canvas
+        uint8_t read[13];
+        memset(read, 0xAA, sizeof(read));
+        canvas.readRow(x, y, read, w);
+        for (int16_t i = 0; i < w; i++) {
+            const int16_t cx = x + i + reference.origin_x, cy = y + reference.origin_y;
+            const bool inside = cx >= 0 && cx < CANVAS_WIDTH && cy >= 0 && cy < CANVAS_HEIGHT;
+            const bool expected = inside && reference.white[cy * CANVAS_WIDTH + cx];
+            TEST_ASSERT_EQUAL(expected, (read[i / 8] & (0x80 >> (i % 8))) != 0);
+        }
+        // Padding bits of the last byte are cleared, bytes after it are not touched
+        if (w % 8) TEST_ASSERT_EQUAL_HEX8(0, read[w / 8] & (0xFF >> (w % 8)));
+        TEST_ASSERT_EQUAL_HEX8(0xAA, read[(w + 7) / 8]);
+    });
+}
+
+void test_clip_rect() {
+    EinkCanvas::GFXCanvasBW canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+    TEST_ASSERT_TRUE(canvas.pushViewport(10, 5, 30, 20));
+    TEST_ASSERT_TRUE(canvas.pushViewport(-5, 15, 20, 20));
+
+    // Inner viewport is cut by the outer one: columns 10..24, rows 20..24
+    int16_t x0 = -100, y0 = -100, x1 = 100, y1 = 100;
+    TEST_ASSERT_TRUE(canvas.clipRect(x0, y0, x1, y1));
+    TEST_ASSERT_EQUAL_INT16(10, x0);
+    TEST_ASSERT_EQUAL_INT16(20, y0);
+    TEST_ASSERT_EQUAL_INT16(24, x1);
+    TEST_ASSERT_EQUAL_INT16(24, y1);
+
+    x0 = 0, y0 = 0, x1 = 4, y1 = 4;
+    TEST_ASSERT_FALSE(canvas.clipRect(x0, y0, x1, y1));
+
+    // Extreme coordinates do not wrap around
+    x0 = INT16_MIN, y0 = INT16_MIN, x1 = INT16_MAX, y1 = INT16_MAX;
+    TEST_ASSERT_TRUE(canvas.clipRect(x0, y0, x1, y1));
+    TEST_ASSERT_EQUAL_INT16(10, x0);
+    TEST_ASSERT_EQUAL_INT16(24, y1);
+
+    canvas.popViewport();
+    canvas.popViewport();
+    canvas.popViewport();
+    for (uint8_t i = 1; i < EinkCanvas::GFXCanvasBW::M_MAX_VIEWPORTS; i++) {
+        TEST_ASSERT_TRUE(canvas.pushViewport(0, 0, CANVAS_WIDTH, CANVAS_HEIGHT));
+    }
+    TEST_ASSERT_FALSE(canvas.pushViewport(0, 0, CANVAS_WIDTH, CANVAS_HEIGHT));
+}
+
+void test_dirty_area_is_clipped() {
+    TraceCapture trace;
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    EinkCanvas::SurfaceArena arena(200 * 200 / 8);
+    EinkCanvas::Surface frame = arena.allocate(200, 200);
+    display.clear_frame();
+
+    // Viewport at columns 50..89 and rows 60..89, drawing reaches far outside of it
+    TEST_ASSERT_TRUE(display.push_viewport(50, 60, 40, 30));
+    display.draw_line(-100, -90, 300, 310, EinkColor::BLACK);
+    display.fill_rect(-20, 25, 30, 100, EinkColor::BLACK);
+    display.draw_rect(30, -10, 100, 15, EinkColor::BLACK);
+    display.pop_viewport();
+    trace::clear();
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+
+    // Refreshed box is exactly the changed pixels, all inside of the viewport
+    display.capture(frame, 0, 0);
+    int16_t x0 = INT16_MAX, y0 = INT16_MAX, x1 = INT16_MIN, y1 = INT16_MIN;
+    for (int16_t y = 0; y < 200; y++) {
+        for (int16_t x = 0; x < 200; x++) {
+            if (frame.bits[y * 25 + x / 8] & (0x80 >> (x % 8))) continue;
+            x0 = std::min(x0, x), y0 = std::min(y0, y);
+            x1 = std::max(x1, x), y1 = std::max(y1, y);
+        }
+    }
+    TEST_ASSERT_TRUE(x0 >= 50 && y0 >= 60 && x1 <= 89 && y1 <= 89);
+    const std::vector<trace::Record> records = trace.read();
+    TEST_ASSERT_FALSE(records.empty());
+    TEST_ASSERT_EQUAL_UINT8(trace::Event::REFRESH, records[0].event);
+    const uint16_t box[4] = {(uint16_t)x0, (uint16_t)y0, (uint16_t)x1, (uint16_t)y1};
+    TEST_ASSERT_EQUAL_MEMORY(box, records[0].data, sizeof(box));
+
+    // Drawing entirely outside of the viewport marks nothing
+    display.push_viewport(50, 60, 40, 30);
+    display.fill_rect(-30, -30, 20, 20, EinkColor::BLACK);
+    display.draw_line(50, 0, 100, 20, EinkColor::BLACK);
+    display.pop_viewport();
+    trace::clear();
+    display.display_frame(EinkDisplay::RefreshMode::PARTIAL);
+    TEST_ASSERT_EQUAL_UINT32(1, trace.count(trace::Event::UNCHANGED));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lines);
+    RUN_TEST(test_rectangles);
+    RUN_TEST(test_rows);
+    RUN_TEST(test_clip_rect);
+    RUN_TEST(test_dirty_area_is_clipped);
+    return UNITY_END();
+}
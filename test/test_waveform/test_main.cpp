@@ -0,0 +1,109 @@
+// Lookup table sent to the controller follows the requested refresh and frame timing
+// follows the temperature of the panel, at the borders of the temperature ranges too.
+
+#include <unity.h>
+
+#include <eink_waveshare.h>
+#include <command_recorder.h>
+
+namespace {
+
+constexpr uint8_t CS = 5, DC = 17, RST = 16, BUSY = 4;
+constexpr size_t LUT_SIZE = 30;
+
+const uint8_t FULL_LUT[LUT_SIZE] = {
+    0x02, 0x02, 0x01, 0x11, 0x12, 0x12, 0x22, 0x22, 0x66, 0x69, 0x69, 0x59, 0x58, 0x99, 0x99,
+    0x88, 0x00, 0x00, 0x00, 0x00, 0xF8, 0xB4, 0x13, 0x51, 0x35, 0x51, 0x51, 0x19, 0x01, 0x00};
+const uint8_t PARTIAL_LUT[LUT_SIZE] = {
+    0x10, 0x18, 0x18, 0x08, 0x18, 0x18, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x13, 0x14, 0x44, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+const uint8_t FAST_LUT[LUT_SIZE] = {
+    0x10, 0x18, 0x18, 0x08, 0x18, 0x18, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x13, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+void assert_sent(const CommandRecorder& recorder, uint8_t command, const uint8_t* data, size_t size) {
+    const CommandRecorder::Entry* entry = recorder.find(command);
+    TEST_ASSERT_TRUE_MESSAGE(entry != nullptr, "Command was not sent");
+    TEST_ASSERT_EQUAL_UINT32(size, entry->data.size());
+    TEST_ASSERT_EQUAL_MEMORY(data, entry->data.data(), size);
+}
+
+} // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_lut_follows_waveform() {
+    CommandRecorder recorder(CS, DC);
+    EinkSPI::SPIController spi(CS, DC);
+    EinkDriver::Eink1in54 driver(RST, BUSY, spi);
+
+    driver.init(EinkDriver::Waveform::FULL);
+    assert_sent(recorder, 0x32, FULL_LUT, LUT_SIZE);
+    recorder.clear();
+    driver.init(EinkDriver::Waveform::PARTIAL);
+    assert_sent(recorder, 0x32, PARTIAL_LUT, LUT_SIZE);
+    recorder.clear();
+    driver.init(EinkDriver::Waveform::FAST);
+    assert_sent(recorder, 0x32, FAST_LUT, LUT_SIZE);
+}
+
+void test_timing_follows_temperature() {
+    CommandRecorder recorder(CS, DC);
+    EinkSPI::SPIController spi(CS, DC);
+    EinkDriver::Eink1in54 driver(RST, BUSY, spi);
+
+    const struct {
+        int8_t celsius;
+        uint8_t dummy_line_period;
+    } cases[] = {{127, 0x1A}, {25, 0x1A}, {10, 0x1A}, {9, 0x24}, {0, 0x24}, {-1, 0x30}, {-128, 0x30}};
+    const uint8_t gate_time = 0x08;
+    for (const auto& c : cases) {
+        driver.set_temperature(c.celsius);
+        recorder.clear();
+        driver.init(EinkDriver::Waveform::PARTIAL);
+        assert_sent(recorder, 0x3A, &c.dummy_line_period, 1);
+        assert_sent(recorder, 0x3B, &gate_time, 1);
+        // Waveform does not depend on temperature
+        assert_sent(recorder, 0x32, PARTIAL_LUT, LUT_SIZE);
+    }
+}
+
+void test_display_handle_selects_waveform() {
+    CommandRecorder recorder(CS, DC);
+    EinkDisplay::DisplayHandle<EinkDriver::Eink1in54> display(CS, DC, RST, BUSY);
+    display.set_temperature(-5);
+
+    // Content of the display is unknown, full refresh is forced
+    display.fill_rect(0, 0, 10, 10, EinkColor::BLACK);
+    display.display_frame(EinkDisplay::RefreshMode::FAST);
+    assert_sent(recorder, 0x32, FULL_LUT, LUT_SIZE);
+    const uint8_t cold = 0x30;
+    assert_sent(recorder, 0x3A, &cold, 1);
+
+    const struct {
+        EinkDisplay::RefreshMode mode;
+        const uint8_t* lut;
+    } cases[] = {{EinkDisplay::RefreshMode::FAST, FAST_LUT},
+                 {EinkDisplay::RefreshMode::PARTIAL, PARTIAL_LUT},
+                 {EinkDisplay::RefreshMode::AUTO, PARTIAL_LUT},
+                 {EinkDisplay::RefreshMode::FULL, FULL_LUT}};
+    display.set_temperature(30);
+    for (uint8_t i = 0; i < 4; i++) {
+        display.fill_rect(20 * i, 50, 10, 10, EinkColor::BLACK);
+        recorder.clear();
+        display.display_frame(cases[i].mode);
+        assert_sent(recorder, 0x32, cases[i].lut, LUT_SIZE);
+        const uint8_t warm = 0x1A;
+        assert_sent(recorder, 0x3A, &warm, 1);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lut_follows_waveform);
+    RUN_TEST(test_timing_follows_temperature);
+    RUN_TEST(test_display_handle_selects_waveform);
+    return UNITY_END();
+}